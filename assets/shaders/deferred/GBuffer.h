@@ -15,11 +15,21 @@ struct GBuffer
 	layout(location = 1) out vec3 outGBufferNormal;
 	layout(location = 2) out vec2 outGBufferShading;
 	layout(location = 3) out vec2 outGBufferVelocity;
+#elif defined(GBUFFER_SUBPASS_INPUT)
+	layout(input_attachment_index = 0, set = GBUFFER_SET, binding = 0) uniform subpassInput inGBufferBaseColor;
+	layout(input_attachment_index = 1, set = GBUFFER_SET, binding = 1) uniform subpassInput inGBufferNormal;
+	layout(input_attachment_index = 2, set = GBUFFER_SET, binding = 2) uniform subpassInput inGBufferShading;
+	layout(input_attachment_index = 3, set = GBUFFER_SET, binding = 3) uniform subpassInput inGBufferDepth;
+
+	// subpass inputs are only readable at the current pixel, uv is still used for reconstruction
+	#define GBUFFER_FETCH(name, uv) subpassLoad(in##name)
 #else
 	layout(set = GBUFFER_SET, binding = 0) uniform sampler2D texGBufferBaseColor;
 	layout(set = GBUFFER_SET, binding = 1) uniform sampler2D texGBufferNormal;
 	layout(set = GBUFFER_SET, binding = 2) uniform sampler2D texGBufferShading;
 	layout(set = GBUFFER_SET, binding = 3) uniform sampler2D texGBufferDepth;
+
+	#define GBUFFER_FETCH(name, uv) texture(tex##name, uv)
 #endif
 
 #ifdef GBUFFER_WRITE
@@ -38,21 +48,21 @@ struct GBuffer
 	{
 		GBuffer result;
 
-		vec3 normal = texture(texGBufferNormal, uv).xyz;
-		vec2 shading = texture(texGBufferShading, uv).rg;
+		vec3 normal = GBUFFER_FETCH(GBufferNormal, uv).xyz;
+		vec2 shading = GBUFFER_FETCH(GBufferShading, uv).rg;
 
-		result.baseColor = texture(texGBufferBaseColor, uv).rgb;
+		result.baseColor = GBUFFER_FETCH(GBufferBaseColor, uv).rgb;
 		result.normalVS = normalize(normal);
 		result.roughness = shading.r;
 		result.metalness = shading.g;
-		result.depth = texture(texGBufferDepth, uv).r;
+		result.depth = GBUFFER_FETCH(GBufferDepth, uv).r;
 
 		return result;
 	}
 
 	vec3 getGBufferNormalVS(vec2 uv)
 	{
-		return normalize(texture(texGBufferNormal, uv).xyz);
+		return normalize(GBUFFER_FETCH(GBufferNormal, uv).xyz);
 	}
 
 	vec3 getGBufferPositionVS(vec2 uv, float depth, mat4 iprojection)
@@ -65,7 +75,7 @@ struct GBuffer
 
 	vec3 getGBufferPositionVS(vec2 uv, mat4 iprojection)
 	{
-		float depth = texture(texGBufferDepth, uv).r;
+		float depth = GBUFFER_FETCH(GBufferDepth, uv).r;
 		return getGBufferPositionVS(uv, depth, iprojection);
 	}
 
@@ -0,0 +1,6 @@
+#version 450
+#pragma shader_stage(fragment)
+
+// reads the gbuffer written by the previous subpass
+#define GBUFFER_SUBPASS_INPUT
+#include <shaders/deferred/SkylightDeferred.h>
@@ -9,10 +9,28 @@ struct MaterialTextures
 	float metalness;
 };
 
+#ifdef PBR_MATERIAL_BINDLESS
+// requires GL_EXT_nonuniform_qualifier, material indices follow node transform in push constants
+layout(set = PBR_MATERIAL_SET, binding = 0) uniform sampler2D texBindless[];
+
+layout(push_constant) uniform Material
+{
+	layout(offset = 64) uint baseColor;
+	uint normal;
+	uint roughness;
+	uint metalness;
+} materialIndices;
+
+#define texMaterialBaseColor texBindless[nonuniformEXT(materialIndices.baseColor)]
+#define texMaterialNormal texBindless[nonuniformEXT(materialIndices.normal)]
+#define texMaterialRoughness texBindless[nonuniformEXT(materialIndices.roughness)]
+#define texMaterialMetalness texBindless[nonuniformEXT(materialIndices.metalness)]
+#else
 layout(set = PBR_MATERIAL_SET, binding = 0) uniform sampler2D texMaterialBaseColor;
 layout(set = PBR_MATERIAL_SET, binding = 1) uniform sampler2D texMaterialNormal;
 layout(set = PBR_MATERIAL_SET, binding = 2) uniform sampler2D texMaterialRoughness;
 layout(set = PBR_MATERIAL_SET, binding = 3) uniform sampler2D texMaterialMetalness;
+#endif
 
 MaterialTextures sampleMaterial(in vec2 uv, in mat3 TBN)
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace render::backend
@@ -16,6 +17,7 @@ namespace render::backend
 	{
 		STATIC = 0,
 		DYNAMIC,
+		TRANSIENT, // contents are valid for the current frame only, every map() returns new memory
 
 		MAX,
 	};
@@ -64,6 +66,14 @@ namespace render::backend
 		MAX,
 	};
 
+	enum class SamplerFilter : uint8_t
+	{
+		NEAREST = 0,
+		LINEAR,
+
+		MAX,
+	};
+
 	enum class Format : uint16_t
 	{
 		UNDEFINED = 0,
@@ -206,6 +216,12 @@ namespace render::backend
 		SECONDARY,
 	};
 
+	enum class RenderPassContents : uint8_t
+	{
+		INLINE = 0, // commands are recorded directly into the primary command buffer
+		SECONDARY_COMMAND_BUFFERS, // pass is filled by executeCommands only
+	};
+
 	enum class CullMode : uint8_t
 	{
 		NONE = 0,
@@ -246,6 +262,66 @@ namespace render::backend
 		MAX,
 	};
 
+	enum class BarrierType : uint8_t
+	{
+		COMPUTE_TO_COMPUTE = 0, // storage writes are read or written by the next dispatch
+		COMPUTE_TO_GRAPHICS, // storage writes are read by draws, including vertex, index and indirect data
+		GRAPHICS_TO_COMPUTE, // attachment and shader writes are read or written by dispatches
+
+		MAX,
+	};
+
+	enum class TextureState : uint8_t
+	{
+		UNDEFINED = 0, // contents may be discarded by the next transition
+		GRAPHICS_SAMPLED, // read by vertex or fragment shaders
+		COMPUTE_SAMPLED, // read by dispatches
+		COMPUTE_STORAGE, // read and written as a storage image by dispatches
+		COLOR_ATTACHMENT,
+		DEPTHSTENCIL_ATTACHMENT,
+		TRANSFER_SRC,
+		TRANSFER_DST,
+
+		MAX,
+	};
+
+	enum class QueryType : uint8_t
+	{
+		TIMESTAMP = 0,
+		PIPELINE_STATISTICS,
+
+		MAX,
+	};
+
+	enum class PipelineCompilePolicy : uint8_t
+	{
+		BLOCK = 0,
+		SKIP,
+		FALLBACK,
+
+		MAX,
+	};
+
+	enum class MemoryCategory : uint8_t
+	{
+		TEXTURES = 0, // textures created with data
+		RENDER_TARGETS, // textures created without data
+		GEOMETRY, // vertex & index buffers, including geometry arenas
+		UNIFORMS, // uniform buffers and the transient frame ring
+		STORAGE,
+		STAGING, // upload & readback staging memory
+
+		MAX,
+	};
+
+	// extra texture usages, off by default as they can disable compression on some hardware
+	enum TextureUsageFlags : uint32_t
+	{
+		TEXTURE_USAGE_NONE = 0,
+		TEXTURE_USAGE_STORAGE = 1 << 0, // written by dispatches, see bindStorageImage
+		TEXTURE_USAGE_INPUT_ATTACHMENT = 1 << 1, // read by later subpasses with subpassLoad, see bindInputAttachment
+	};
+
 	// C opaque structs
 	struct VertexBuffer {};
 	struct IndexBuffer {};
@@ -256,13 +332,18 @@ namespace render::backend
 	struct CommandBuffer {};
 
 	struct UniformBuffer {};
-	// TODO: shader storage buffer?
+	struct StorageBuffer {};
 
 	struct Shader {};
 	struct BindSet {};
 	struct PipelineState {};
 
 	struct SwapChain {};
+	struct QueryPool {};
+	struct Sampler {};
+
+	struct GeometryArena {};
+	struct GeometryAllocation {};
 
 	// C structs
 	struct VertexAttribute
@@ -307,19 +388,116 @@ namespace render::backend
 		RenderPassClearValue clear_value;
 	};
 
+	// describes a single subpass, input attachments are read with subpassLoad
 	struct RenderPassDescription
 	{
 		uint32_t num_color_attachments {0};
 		uint32_t *color_attachments {nullptr};
 		uint32_t *resolve_attachments {nullptr};
 		uint32_t *depthstencil_attachment {nullptr};
+		uint32_t num_input_attachments {0};
+		uint32_t *input_attachments {nullptr};
+	};
+
+	// index of textures that don't have a slot in the bindless table
+	constexpr uint32_t INVALID_BINDLESS_INDEX = 0xFFFFFFFF;
+
+	// samplers with equal descriptions are shared
+	struct SamplerDescription
+	{
+		SamplerFilter min_filter {SamplerFilter::LINEAR};
+		SamplerFilter mag_filter {SamplerFilter::LINEAR};
+		SamplerFilter mip_filter {SamplerFilter::LINEAR};
+		SamplerWrapMode wrap_u {SamplerWrapMode::REPEAT};
+		SamplerWrapMode wrap_v {SamplerWrapMode::REPEAT};
+		SamplerWrapMode wrap_w {SamplerWrapMode::REPEAT};
+		float max_anisotropy {1.0f}; // 1 disables anisotropic filtering, clamped to device limits
+		float min_lod {0.0f};
+		float max_lod {1000.0f}; // mip range is limited by the bound view anyway
+		bool depth_compare {false};
+		DepthCompareFunc depth_compare_func {DepthCompareFunc::ALWAYS};
+	};
+
+	// location of a geometry arena allocation, indices are relative to vertex_offset
+	struct GeometryRange
+	{
+		VertexBuffer *vertex_buffer {nullptr};
+		IndexBuffer *index_buffer {nullptr};
+		uint32_t first_index {0};
+		uint32_t num_indices {0};
+		int32_t vertex_offset {0};
+		uint32_t num_vertices {0};
+	};
+
+	// layout of a single indirect draw in argument buffers, filled by CPU or GPU
+	struct DrawIndexedIndirectCommand
+	{
+		uint32_t num_indices {0};
+		uint32_t num_instances {0};
+		uint32_t base_index {0};
+		int32_t base_vertex {0};
+		uint32_t base_instance {0};
+	};
+
+	// result layout of a single pipeline statistics query
+	struct PipelineStatistics
+	{
+		uint64_t num_input_vertices {0};
+		uint64_t num_input_primitives {0};
+		uint64_t num_vertex_shader_invocations {0};
+		uint64_t num_clipping_primitives {0};
+		uint64_t num_fragment_shader_invocations {0};
+		uint64_t num_compute_shader_invocations {0};
+	};
+
+	struct DescriptorPoolStats
+	{
+		uint32_t max_sets {0};
+		uint32_t num_allocated_sets {0};
+		uint32_t num_total_allocations {0};
+		bool transient {false};
+	};
+
+	struct MemoryCategoryStats
+	{
+		uint64_t bytes {0};
+		uint32_t num_allocations {0};
+	};
+
+	struct MemoryHeapStats
+	{
+		uint64_t size {0};
+		uint64_t budget {0}; // how much the process may use before allocations start to fail or thrash
+		uint64_t usage {0}; // current usage of the whole process, including other APIs
+		uint64_t allocated_bytes {0}; // device memory blocks allocated by the driver
+		uint64_t used_bytes {0}; // part of the blocks occupied by live resources
+		bool device_local {false};
+	};
+
+	struct MemoryStats
+	{
+		static constexpr uint32_t MAX_HEAPS = 16;
+
+		uint32_t num_heaps {0};
+		MemoryHeapStats heaps[MAX_HEAPS];
+		MemoryCategoryStats categories[static_cast<uint32_t>(MemoryCategory::MAX)];
+		bool exact_budget {false}; // budget and usage are estimated from heap sizes otherwise
+	};
+
+	struct DefragmentationStats
+	{
+		uint64_t bytes_moved {0};
+		uint64_t bytes_freed {0};
+		uint32_t allocations_moved {0};
+		uint32_t memory_blocks_freed {0};
 	};
 
 	// main backend class
 	class Driver
 	{
 	public:
-		static Driver *create(const char *application_name, const char *engine_name, Api api = Api::DEFAULT);
+		// headless drivers need no display or surface extensions, only offscreen swap chains can be created
+		static Driver *create(const char *application_name, const char *engine_name, Api api = Api::DEFAULT, bool headless = false);
 
 	public:
 		virtual VertexBuffer *createVertexBuffer(
@@ -344,7 +522,8 @@ namespace render::backend
 			uint32_t num_mipmaps,
 			Format format,
 			const void *data = nullptr,
-			uint32_t num_data_mipmaps = 1
+			uint32_t num_data_mipmaps = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) = 0;
 
 		virtual Texture *createTexture2DMultisample(
@@ -362,7 +541,8 @@ namespace render::backend
 			Format format,
 			const void *data = nullptr,
 			uint32_t num_data_mipmaps = 1,
-			uint32_t num_data_layers = 1
+			uint32_t num_data_layers = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) = 0;
 
 		virtual Texture *createTexture3D(
@@ -372,7 +552,8 @@ namespace render::backend
 			uint32_t num_mipmaps,
 			Format format,
 			const void *data = nullptr,
-			uint32_t num_data_mipmaps = 1
+			uint32_t num_data_mipmaps = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) = 0;
 
 		virtual Texture *createTextureCube(
@@ -380,7 +561,8 @@ namespace render::backend
 			uint32_t num_mipmaps,
 			Format format,
 			const void *data = nullptr,
-			uint32_t num_data_mipmaps = 1
+			uint32_t num_data_mipmaps = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) = 0;
 
 		virtual FrameBuffer *createFrameBuffer(
@@ -394,6 +576,14 @@ namespace render::backend
 			const RenderPassDescription &description
 		) = 0;
 
+		// subpasses reading input attachments wait for earlier subpasses writing them
+		virtual RenderPass *createRenderPass(
+			uint32_t num_attachments,
+			const RenderPassAttachment *attachments,
+			uint32_t num_subpasses,
+			const RenderPassDescription *subpasses
+		) = 0;
+
 		virtual RenderPass *createRenderPass(
 			const SwapChain *swap_chain,
 			RenderPassLoadOp load_op,
@@ -401,6 +591,7 @@ namespace render::backend
 			const RenderPassClearColor *clear_color
 		) = 0;
 
+		// command buffer is allocated from a pool owned by the calling thread and must be recorded on it
 		virtual CommandBuffer *createCommandBuffer(
 			CommandBufferType type
 		) = 0;
@@ -411,6 +602,12 @@ namespace render::backend
 			const void *data = nullptr
 		) = 0;
 
+		virtual StorageBuffer *createStorageBuffer(
+			BufferType type,
+			uint32_t size,
+			const void *data = nullptr
+		) = 0;
+
 		virtual Shader *createShaderFromSource(
 			ShaderType type,
 			uint32_t size,
@@ -435,6 +632,35 @@ namespace render::backend
 			void *native_window
 		) = 0;
 
+		// images are owned by the driver and acquired round robin, present only waits for rendering
+		virtual SwapChain *createOffscreenSwapChain(
+			uint32_t width,
+			uint32_t height,
+			uint32_t num_images
+		) = 0;
+
+		virtual Sampler *createSampler(
+			const SamplerDescription &description
+		) = 0;
+
+		// returns nullptr if the device doesn't support given query type
+		virtual QueryPool *createQueryPool(
+			QueryType type,
+			uint32_t num_queries
+		) = 0;
+
+		// shared static vertex & index buffers with a single vertex layout, grows on demand
+		virtual GeometryArena *createGeometryArena(
+			uint16_t vertex_size,
+			uint8_t num_attributes,
+			const VertexAttribute *attributes,
+			IndexFormat index_format,
+			uint32_t num_vertices,
+			uint32_t num_indices
+		) = 0;
+
+		// GPU objects are released once work recorded so far is complete, no need to wait before destroying
+		// exceptions are command buffers, which wait for their last submit, and swap chains
 		virtual void destroyVertexBuffer(VertexBuffer *vertex_buffer) = 0;
 		virtual void destroyIndexBuffer(IndexBuffer *index_buffer) = 0;
 		virtual void destroyTexture(Texture *texture) = 0;
@@ -442,10 +668,14 @@ namespace render::backend
 		virtual void destroyRenderPass(RenderPass *render_pass) = 0;
 		virtual void destroyCommandBuffer(CommandBuffer *command_buffer) = 0;
 		virtual void destroyUniformBuffer(UniformBuffer *uniform_buffer) = 0;
+		virtual void destroyStorageBuffer(StorageBuffer *storage_buffer) = 0;
 		virtual void destroyShader(Shader *shader) = 0;
 		virtual void destroyBindSet(BindSet *bind_set) = 0;
 		virtual void destroyPipelineState(PipelineState *pipeline_state) = 0;
 		virtual void destroySwapChain(SwapChain *swap_chain) = 0;
+		virtual void destroyQueryPool(QueryPool *query_pool) = 0;
+		virtual void destroySampler(Sampler *sampler) = 0;
+		virtual void destroyGeometryArena(GeometryArena *arena) = 0;
 
 	public:
 		virtual bool isFlipped() = 0;
@@ -457,6 +687,94 @@ namespace render::backend
 		virtual void setTextureSamplerDepthCompare(Texture *texture, bool enabled, DepthCompareFunc func) = 0;
 		virtual void generateTexture2DMipmaps(Texture *texture) = 0;
 
+		virtual void setPipelineCachePath(const char *path) = 0;
+		virtual void setAsyncPipelineCompilation(bool enabled) = 0;
+		virtual uint32_t getNumPendingPipelines() = 0;
+
+	public:
+		// uploads, resource data passed between begin and end is transferred with a single submit
+		// resources created inside a batch must not be used on GPU until the batch is ended
+		// batches are per thread, resources can be created and uploaded from loader threads
+		virtual void beginUploadBatch() = 0;
+		virtual bool endUploadBatch() = 0;
+
+		// submits the batch without waiting, returned ticket can be polled from any thread
+		virtual uint64_t endUploadBatchAsync() = 0;
+		virtual bool isUploadComplete(uint64_t ticket) = 0;
+
+		// loader threads call it before exiting, waits for the thread's uploads and releases its upload context
+		// & command pool; command buffers created by the thread must be destroyed first
+		virtual void releaseThreadResources() = 0;
+
+	public:
+		// readbacks, copies are recorded into the command buffer and land in host visible memory once it is submitted
+		// returned ticket is polled or waited on from the render thread, 0 means the readback ring is full
+		// data stays valid until the ticket is released, unreleased tickets keep their ring space
+		virtual uint64_t readTexture(
+			CommandBuffer *command_buffer,
+			const Texture *texture,
+			uint32_t mip = 0,
+			uint32_t layer = 0
+		) = 0;
+
+		// size of 0 reads the rest of the buffer
+		virtual uint64_t readBuffer(
+			CommandBuffer *command_buffer,
+			const StorageBuffer *storage_buffer,
+			uint32_t offset = 0,
+			uint32_t size = 0
+		) = 0;
+
+		// reads the acquired image, must be recorded after rendering to it
+		virtual uint64_t readSwapChain(
+			CommandBuffer *command_buffer,
+			const SwapChain *swap_chain
+		) = 0;
+
+		virtual bool isReadbackComplete(uint64_t ticket) = 0;
+
+		// waits for the submit the copy was recorded into, fails if it is not submitted yet
+		virtual bool waitReadback(uint64_t ticket) = 0;
+
+		// null until the readback is complete, texture rows are tightly packed
+		virtual const void *getReadbackData(uint64_t ticket, size_t *size = nullptr) = 0;
+		virtual void releaseReadback(uint64_t ticket) = 0;
+
+	public:
+		// bindless, 2D textures get a stable index into a global texture table on creation
+		// the table is bound like a regular bind set and indexed with nonuniformEXT in shaders
+		virtual bool isBindlessSupported() = 0;
+		virtual uint32_t getBindlessIndex(const Texture *texture) = 0;
+		virtual BindSet *getBindlessBindSet() = 0;
+
+	public:
+		// geometry arena, data is uploaded on allocation and ranges are reused once GPU is done with them
+		// compaction and growth move allocations, ranges must be fetched again after them
+		virtual GeometryAllocation *allocateGeometry(
+			GeometryArena *arena,
+			uint32_t num_vertices,
+			const void *vertices,
+			uint32_t num_indices,
+			const void *indices
+		) = 0;
+
+		virtual void freeGeometry(GeometryArena *arena, GeometryAllocation *allocation) = 0;
+		virtual GeometryRange getGeometryRange(const GeometryArena *arena, const GeometryAllocation *allocation) = 0;
+		virtual void compactGeometryArena(GeometryArena *arena) = 0;
+
+	public:
+		// statistics
+		virtual uint32_t getNumDescriptorPools() = 0;
+		virtual DescriptorPoolStats getDescriptorPoolStats(uint32_t index) = 0;
+		virtual void getMemoryStats(MemoryStats *stats) = 0;
+
+		// records moves of up to given amount of static vertex & index buffers into a primary command buffer outside
+		// render passes, the command buffer must be submitted next; emptied blocks are released once it completes
+		// and reported by the following call, which records nothing while the moves are in flight
+		// returns false once there was nothing left to move
+		// must not overlap upload batches, command buffers recorded before the call must be recorded again
+		virtual bool defragmentMemory(CommandBuffer *command_buffer, uint64_t max_bytes, uint32_t max_allocations, DefragmentationStats *stats = nullptr) = 0;
+
 	public:
 		virtual void *map(VertexBuffer *vertex_buffer) = 0;
 		virtual void unmap(VertexBuffer *vertex_buffer) = 0;
@@ -467,6 +785,9 @@ namespace render::backend
 		virtual void *map(UniformBuffer *uniform_buffer) = 0;
 		virtual void unmap(UniformBuffer *uniform_buffer) = 0;
 
+		virtual void *map(StorageBuffer *storage_buffer) = 0;
+		virtual void unmap(StorageBuffer *storage_buffer) = 0;
+
 		virtual void flush(BindSet *bind_set) = 0;
 		virtual void flush(PipelineState *pipeline_state) = 0;
 
@@ -495,10 +816,20 @@ namespace render::backend
 			const UniformBuffer *uniform_buffer
 		) = 0;
 
+		// exposes range bytes of the buffer, offset is set per draw with setDynamicOffset
+		virtual void bindDynamicUniformBuffer(
+			BindSet *bind_set,
+			uint32_t binding,
+			const UniformBuffer *uniform_buffer,
+			uint32_t range
+		) = 0;
+
+		// texture's own sampler is used unless another one is given
 		virtual void bindTexture(
 			BindSet *bind_set,
 			uint32_t binding,
-			const Texture *texture
+			const Texture *texture,
+			const Sampler *sampler = nullptr
 		) = 0;
 
 		virtual void bindTexture(
@@ -508,7 +839,29 @@ namespace render::backend
 			uint32_t base_mip,
 			uint32_t num_mips,
 			uint32_t base_layer,
-			uint32_t num_layers
+			uint32_t num_layers,
+			const Sampler *sampler = nullptr
+		) = 0;
+
+		virtual void bindStorageBuffer(
+			BindSet *bind_set,
+			uint32_t binding,
+			const StorageBuffer *storage_buffer
+		) = 0;
+
+		// texture must be created with TEXTURE_USAGE_STORAGE and moved to storage access with textureBarrier
+		virtual void bindStorageImage(
+			BindSet *bind_set,
+			uint32_t binding,
+			const Texture *texture,
+			uint32_t mip = 0
+		) = 0;
+
+		// texture must be created with TEXTURE_USAGE_INPUT_ATTACHMENT and be an input attachment of the subpass the bind set is used in
+		virtual void bindInputAttachment(
+			BindSet *bind_set,
+			uint32_t binding,
+			const Texture *texture
 		) = 0;
 
 	public:
@@ -533,6 +886,13 @@ namespace render::backend
 			BindSet *bind_set
 		) = 0;
 
+		virtual void setDynamicOffset(
+			PipelineState *pipeline_state,
+			uint8_t set,
+			uint32_t binding,
+			uint32_t offset
+		) = 0;
+
 		virtual void clearShaders(
 			PipelineState *pipeline_state
 		) = 0;
@@ -547,10 +907,12 @@ namespace render::backend
 			PipelineState *pipeline_state
 		) = 0;
 
+		// offset is in bytes from the start of the vertex buffer
 		virtual void setVertexStream(
 			PipelineState *pipeline_state,
 			uint8_t binding,
-			VertexBuffer *vertex_buffer
+			VertexBuffer *vertex_buffer,
+			uint32_t offset = 0
 			// TODO: vertex stream usage (per vertex or per instance)
 		) = 0;
 
@@ -606,6 +968,16 @@ namespace render::backend
 			BlendFactor dest_factor
 		) = 0;
 
+		virtual void setCompilePolicy(
+			PipelineState *pipeline_state,
+			PipelineCompilePolicy policy
+		) = 0;
+
+		virtual void setFallbackPipelineState(
+			PipelineState *pipeline_state,
+			PipelineState *fallback
+		) = 0;
+
 	public:
 		// command buffers
 		virtual bool resetCommandBuffer(
@@ -616,6 +988,13 @@ namespace render::backend
 			CommandBuffer *command_buffer
 		) = 0;
 
+		// secondary command buffers continue the given render pass, frame buffer is an optional hint
+		virtual bool beginCommandBuffer(
+			CommandBuffer *command_buffer,
+			const RenderPass *render_pass,
+			const FrameBuffer *frame_buffer = nullptr
+		) = 0;
+
 		virtual bool endCommandBuffer(
 			CommandBuffer *command_buffer
 		) = 0;
@@ -639,19 +1018,33 @@ namespace render::backend
 		virtual void beginRenderPass(
 			CommandBuffer *command_buffer,
 			const RenderPass *render_pass,
-			const FrameBuffer *frame_buffer
+			const FrameBuffer *frame_buffer,
+			RenderPassContents contents = RenderPassContents::INLINE
 		) = 0;
 
 		virtual void beginRenderPass(
 			CommandBuffer *command_buffer,
 			const RenderPass *render_pass,
-			const SwapChain *swap_chain
+			const SwapChain *swap_chain,
+			RenderPassContents contents = RenderPassContents::INLINE
+		) = 0;
+
+		virtual void nextSubpass(
+			CommandBuffer *command_buffer,
+			RenderPassContents contents = RenderPassContents::INLINE
 		) = 0;
 
 		virtual void endRenderPass(
 			CommandBuffer *command_buffer
 		) = 0;
 
+		// secondary command buffers must be ended, current render pass must expect them
+		virtual void executeCommands(
+			CommandBuffer *command_buffer,
+			uint32_t num_command_buffers,
+			CommandBuffer * const *command_buffers
+		) = 0;
+
 		virtual void drawIndexedPrimitiveInstanced(
 			CommandBuffer *command_buffer,
 			PipelineState *pipeline_state,
@@ -662,5 +1055,124 @@ namespace render::backend
 			uint32_t num_instances = 1,
 			uint32_t base_instance = 0
 		) = 0;
+
+		// arguments are num_draws DrawIndexedIndirectCommand structures starting at offset
+		virtual void drawIndexedIndirect(
+			CommandBuffer *command_buffer,
+			PipelineState *pipeline_state,
+			const IndexBuffer *index_buffer,
+			const StorageBuffer *arguments,
+			uint32_t offset,
+			uint32_t num_draws,
+			uint32_t stride = sizeof(DrawIndexedIndirectCommand)
+		) = 0;
+
+		// draw count is read by the GPU from a uint32_t in count_buffer and clamped to max_draws,
+		// without driver support all max_draws draws are issued so unused ones must have zero instances
+		virtual void drawIndexedIndirectCount(
+			CommandBuffer *command_buffer,
+			PipelineState *pipeline_state,
+			const IndexBuffer *index_buffer,
+			const StorageBuffer *arguments,
+			uint32_t offset,
+			const StorageBuffer *count_buffer,
+			uint32_t count_offset,
+			uint32_t max_draws,
+			uint32_t stride = sizeof(DrawIndexedIndirectCommand)
+		) = 0;
+
+	public:
+		// compute commands, must be recorded outside of render passes
+		virtual void dispatch(
+			CommandBuffer *command_buffer,
+			PipelineState *pipeline_state,
+			uint32_t num_groups_x,
+			uint32_t num_groups_y = 1,
+			uint32_t num_groups_z = 1
+		) = 0;
+
+		virtual void dispatchIndirect(
+			CommandBuffer *command_buffer,
+			PipelineState *pipeline_state,
+			const StorageBuffer *arguments,
+			uint32_t offset = 0
+		) = 0;
+
+		virtual void memoryBarrier(
+			CommandBuffer *command_buffer,
+			BarrierType type
+		) = 0;
+
+		// sampled textures live in shader read layout, storage access needs a transition both ways
+		virtual void textureBarrier(
+			CommandBuffer *command_buffer,
+			const Texture *texture,
+			BarrierType type
+		) = 0;
+
+	public:
+		// texture state is tracked per mip & layer in recording order, so command buffers must be submitted
+		// in the order they were recorded; render passes leave their attachments in GRAPHICS_SAMPLED layout
+		virtual void transitionTexture(
+			CommandBuffer *command_buffer,
+			const Texture *texture,
+			TextureState state,
+			uint32_t base_mip = 0,
+			uint32_t num_mips = 0, // 0 means all remaining mips
+			uint32_t base_layer = 0,
+			uint32_t num_layers = 0 // 0 means all remaining layers
+		) = 0;
+
+		// transitions are collected and flushed as a single barrier before the next render pass,
+		// dispatch or barrier, call this before commands that don't flush on their own
+		virtual void flushBarriers(
+			CommandBuffer *command_buffer
+		) = 0;
+
+	public:
+		// queries, must be reset outside of render passes before they are written again
+		virtual void resetQueries(
+			CommandBuffer *command_buffer,
+			QueryPool *query_pool,
+			uint32_t first_query,
+			uint32_t num_queries
+		) = 0;
+
+		// timestamps are taken once all previous commands started or finished execution
+		virtual void beginTimestamp(
+			CommandBuffer *command_buffer,
+			QueryPool *query_pool,
+			uint32_t query
+		) = 0;
+
+		virtual void endTimestamp(
+			CommandBuffer *command_buffer,
+			QueryPool *query_pool,
+			uint32_t query
+		) = 0;
+
+		virtual void beginQuery(
+			CommandBuffer *command_buffer,
+			QueryPool *query_pool,
+			uint32_t query
+		) = 0;
+
+		virtual void endQuery(
+			CommandBuffer *command_buffer,
+			QueryPool *query_pool,
+			uint32_t query
+		) = 0;
+
+		// never waits, returns false if any of the queries is not available yet
+		// timestamps are written as uint64_t ticks, statistics as PipelineStatistics
+		virtual bool getQueryResults(
+			const QueryPool *query_pool,
+			uint32_t first_query,
+			uint32_t num_queries,
+			void *results
+		) = 0;
+
+		// nanoseconds per timestamp tick
+		virtual float getTimestampPeriod() = 0;
 	};
 }
@@ -18,12 +18,38 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <chrono>
 
 /*
  */
-void Application::run()
+struct PassTiming
 {
+	const char *name;
+	float RenderGraphTimings::*value;
+};
+
+static const PassTiming pass_timings[] =
+{
+	{ "GBuffer", &RenderGraphTimings::gbuffer },
+	{ "SSAO", &RenderGraphTimings::ssao },
+	{ "SSAO Blur", &RenderGraphTimings::ssao_blur },
+	{ "LBuffer", &RenderGraphTimings::lbuffer },
+	{ "SSR Trace", &RenderGraphTimings::ssr_trace },
+	{ "SSR Resolve", &RenderGraphTimings::ssr_resolve },
+	{ "SSR Temporal Filter", &RenderGraphTimings::ssr_temporal_filter },
+	{ "Composite", &RenderGraphTimings::composite },
+	{ "Composite Temporal Filter", &RenderGraphTimings::composite_temporal_filter },
+	{ "Tonemapping + ImGui", &RenderGraphTimings::tonemapping },
+	{ "Total", &RenderGraphTimings::total },
+};
+
+/*
+ */
+void Application::run(const ApplicationOptions &options)
+{
+	this->options = options;
+
 	initWindow();
 	initImGui();
 	initDriver();
@@ -139,9 +165,25 @@ void Application::update()
 	ImGui::SliderFloat("SSR Facing Threshold", (float*)&render_graph->getSSRData().cpu_data->facing_threshold, 0.0f, 1.0f);
 	ImGui::SliderFloat("SSR Bypass Depth Threshold", (float*)&render_graph->getSSRData().cpu_data->bypass_depth_threshold, 0.0f, 5.0f);
 
+	bool lighting_merged = render_graph->isLightingMerged();
+	if (ImGui::Checkbox("Merge Lighting Into GBuffer Pass", &lighting_merged))
+		render_graph->setLightingMerged(lighting_merged);
+
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 	ImGui::End();
 
+	ImGui::Begin("GPU Timings");
+
+	const RenderGraphTimings &timings = render_graph->getTimings();
+	for (const PassTiming &pass_timing : pass_timings)
+		ImGui::Text("%-26s %.3f ms", pass_timing.name, timings.*pass_timing.value);
+
+	const render::backend::PipelineStatistics &statistics = timings.gbuffer_statistics;
+	ImGui::Text("GBuffer vertex invocations: %llu", static_cast<unsigned long long>(statistics.num_vertex_shader_invocations));
+	ImGui::Text("GBuffer fragment invocations: %llu", static_cast<unsigned long long>(statistics.num_fragment_shader_invocations));
+
+	ImGui::End();
+
 	ImGui::Begin("GBuffer");
 
 	ImTextureID base_color_id = render_graph->fetchTextureID(render_graph->getGBuffer().base_color);
@@ -191,9 +233,14 @@ void Application::render()
 		return;
 	}
 
+	void *camera_gpu_data = driver->map(camera_buffer);
 	memcpy(camera_gpu_data, &camera_state, sizeof(CameraState));
+	driver->unmap(camera_buffer);
+
+	void *application_gpu_data = driver->map(application_buffer);
 	memcpy(application_gpu_data, &application_state, sizeof(ApplicationState));
-	
+	driver->unmap(application_buffer);
+
 	render_graph->render(command_buffer, swap_chain->getBackend(), application_bindings, camera_bindings, sponza);
 
 	driver->submitSyncked(command_buffer, swap_chain->getBackend());
@@ -216,12 +263,21 @@ void Application::postRender()
  */
 void Application::mainloop()
 {
-	if (!window)
+	if (!window && !options.headless)
 		return;
 
-	while (!glfwWindowShouldClose(window))
+	uint32_t num_frames = 0;
+	uint32_t num_gpu_samples = 0;
+	uint32_t last_gpu_sample = render_graph->getTimings().num_samples;
+	double gpu_times[std::size(pass_timings)] {};
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	while (!window || !glfwWindowShouldClose(window))
 	{
-		ImGui_ImplGlfw_NewFrame();
+		if (window)
+			ImGui_ImplGlfw_NewFrame();
+
 		ImGui::NewFrame();
 
 		update();
@@ -230,10 +286,42 @@ void Application::mainloop()
 
 		render();
 		postRender();
-		glfwPollEvents();
+
+		if (window)
+			glfwPollEvents();
+
+		// results arrive a few frames late, only count frames that were actually measured
+		const RenderGraphTimings &timings = render_graph->getTimings();
+		if (timings.num_samples != last_gpu_sample)
+		{
+			for (size_t i = 0; i < std::size(pass_timings); ++i)
+				gpu_times[i] += timings.*pass_timings[i].value;
+
+			last_gpu_sample = timings.num_samples;
+			num_gpu_samples++;
+		}
+
+		if (++num_frames == options.num_frames)
+			break;
 	}
 
 	driver->wait();
+
+	if (options.num_frames == 0)
+		return;
+
+	auto currentTime = std::chrono::high_resolution_clock::now();
+	double cpu_time = std::chrono::duration<double, std::chrono::milliseconds::period>(currentTime - startTime).count();
+
+	std::cout << "Rendered " << num_frames << " frames in " << cpu_time << " ms" << std::endl;
+	std::cout << "Average frame: " << cpu_time / num_frames << " ms" << std::endl;
+
+	if (num_gpu_samples == 0)
+		return;
+
+	std::cout << "Average GPU timings over " << num_gpu_samples << " frames:" << std::endl;
+	for (size_t i = 0; i < std::size(pass_timings); ++i)
+		std::cout << "  " << pass_timings[i].name << ": " << gpu_times[i] / num_gpu_samples << " ms" << std::endl;
 }
 
 /*
@@ -243,6 +331,9 @@ void Application::initWindow()
 	width = 800;
 	height = 600;
 
+	if (options.headless)
+		return;
+
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	window = glfwCreateWindow(width, height, "Scapes v1.0", nullptr, nullptr);
 
@@ -257,6 +348,9 @@ void Application::initWindow()
 
 void Application::shutdownWindow()
 {
+	if (!window)
+		return;
+
 	glfwDestroyWindow(window);
 	window = nullptr;
 }
@@ -322,12 +416,16 @@ void Application::initRenderScene()
 	resources->init();
 
 	sponza = new Scene(driver);
+
+	driver->beginUploadBatch();
 	sponza->import("assets/scenes/pbr_sponza/sponza.obj");
+	driver->endUploadBatch();
 
 	sky_light = new SkyLight(
 		driver,
 		resources->getShader(config::Shaders::FullscreenQuadVertex),
-		resources->getShader(config::Shaders::SkylightDeferredFragment)
+		resources->getShader(config::Shaders::SkylightDeferredFragment),
+		resources->getShader(config::Shaders::SkylightDeferredSubpassFragment)
 	);
 
 	sky_light->setBakedBRDFTexture(resources->getBakedBRDFTexture());
@@ -375,19 +473,15 @@ void Application::initRenderers()
 		}
 	}
 
-	camera_buffer = driver->createUniformBuffer(render::backend::BufferType::DYNAMIC, sizeof(CameraState));
+	camera_buffer = driver->createUniformBuffer(render::backend::BufferType::TRANSIENT, sizeof(CameraState));
 	camera_bindings = driver->createBindSet();
 
 	driver->bindUniformBuffer(camera_bindings, 0, camera_buffer);
 
-	camera_gpu_data = driver->map(camera_buffer);
-
-	application_buffer = driver->createUniformBuffer(render::backend::BufferType::DYNAMIC, sizeof(ApplicationState));
+	application_buffer = driver->createUniformBuffer(render::backend::BufferType::TRANSIENT, sizeof(ApplicationState));
 	application_bindings = driver->createBindSet();
 
 	driver->bindUniformBuffer(application_bindings, 0, application_buffer);
-
-	application_gpu_data = driver->map(application_buffer);
 }
 
 void Application::shutdownRenderers()
@@ -395,18 +489,14 @@ void Application::shutdownRenderers()
 	delete render_graph;
 	render_graph = nullptr;
 
-	driver->unmap(camera_buffer);
 	driver->destroyUniformBuffer(camera_buffer);
 	camera_buffer = nullptr;
-	camera_gpu_data = nullptr;
 
 	driver->destroyBindSet(camera_bindings);
 	camera_bindings = nullptr;
 
-	driver->unmap(application_buffer);
 	driver->destroyUniformBuffer(application_buffer);
 	application_buffer = nullptr;
-	application_gpu_data = nullptr;
 
 	driver->destroyBindSet(application_bindings);
 	application_bindings = nullptr;
@@ -420,12 +510,23 @@ void Application::initImGui()
 	ImGui::CreateContext();
 	ImGui::StyleColorsDark();
 
+	// without a window ImGui is fed a fixed display size and frame rate
+	if (options.headless)
+	{
+		ImGuiIO &io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
+		io.DeltaTime = 1.0f / 60.0f;
+		return;
+	}
+
 	ImGui_ImplGlfw_InitForVulkan(window, true);
 }
 
 void Application::shutdownImGui()
 {
-	ImGui_ImplGlfw_Shutdown();
+	if (window)
+		ImGui_ImplGlfw_Shutdown();
+
 	ImGui::DestroyContext();
 }
 
@@ -435,7 +536,9 @@ void Application::initDriver()
 {
 	file_system = new ApplicationFileSystem("assets/");
 
-	driver = render::backend::Driver::create("PBR Sandbox", "Scape", render::backend::Api::VULKAN);
+	driver = render::backend::Driver::create("PBR Sandbox", "Scape", render::backend::Api::VULKAN, options.headless);
+	driver->setPipelineCachePath("pipeline.cache");
+
 	compiler = render::shaders::Compiler::create(render::shaders::ShaderILType::SPIRV, file_system);
 }
 
@@ -455,6 +558,15 @@ void Application::shutdownDriver()
  */
 void Application::initSwapChain()
 {
+	if (options.headless)
+	{
+		if (!swap_chain)
+			swap_chain = new SwapChain(driver, width, height);
+
+		swap_chain->init();
+		return;
+	}
+
 #if defined(SCAPES_PLATFORM_WIN32)
 	void *nativeWindow = glfwGetWin32Window(window);
 #else
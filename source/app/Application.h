@@ -67,6 +67,12 @@ struct CameraState
 	glm::vec3 target;
 };
 
+struct ApplicationOptions
+{
+	bool headless {false}; // renders into an offscreen swap chain, no window or display needed
+	uint32_t num_frames {0}; // 0 renders until the window is closed
+};
+
 struct InputState
 {
 	const double rotationSpeed {0.01};
@@ -81,7 +87,7 @@ struct InputState
 class Application
 {
 public:
-	void run();
+	void run(const ApplicationOptions &options = ApplicationOptions());
 
 private:
 	void initWindow();
@@ -114,6 +120,8 @@ private:
 	static void onScroll(GLFWwindow* window, double deltaX, double deltaY);
 
 private:
+	ApplicationOptions options;
+
 	GLFWwindow *window {nullptr};
 	bool windowResized {false};
 	uint32_t width {0};
@@ -135,9 +143,7 @@ private:
 
 	render::backend::UniformBuffer *camera_buffer {nullptr};
 	render::backend::BindSet *camera_bindings {nullptr};
-	void *camera_gpu_data {nullptr};
 
 	render::backend::UniformBuffer *application_buffer {nullptr};
 	render::backend::BindSet *application_bindings {nullptr};
-	void *application_gpu_data {nullptr};
 };
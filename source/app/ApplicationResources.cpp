@@ -22,8 +22,10 @@ namespace config
 		"assets/shaders/utils/DiffuseIrradianceCubemap.frag",
 		"assets/shaders/utils/BakedBRDF.frag",
 		"assets/shaders/deferred/SkylightDeferred.frag",
+		"assets/shaders/deferred/SkylightDeferredSubpass.frag",
 		"assets/shaders/deferred/GBuffer.vert",
 		"assets/shaders/deferred/GBuffer.frag",
+		"assets/shaders/deferred/GBufferBindless.frag",
 		"assets/shaders/deferred/SSAO.frag",
 		"assets/shaders/deferred/SSAOBlur.frag",
 		"assets/shaders/deferred/SSRTrace.frag",
@@ -42,6 +44,7 @@ namespace config
 		render::backend::ShaderType::FRAGMENT,
 		render::backend::ShaderType::FRAGMENT,
 		render::backend::ShaderType::FRAGMENT,
+		render::backend::ShaderType::FRAGMENT,
 		render::backend::ShaderType::VERTEX,
 		render::backend::ShaderType::FRAGMENT,
 		render::backend::ShaderType::FRAGMENT,
@@ -52,6 +55,7 @@ namespace config
 		render::backend::ShaderType::FRAGMENT,
 		render::backend::ShaderType::FRAGMENT,
 		render::backend::ShaderType::FRAGMENT,
+		render::backend::ShaderType::FRAGMENT,
 	};
 
 	// Textures
@@ -96,6 +100,8 @@ ApplicationResources::~ApplicationResources()
  */
 void ApplicationResources::init()
 {
+	driver->beginUploadBatch();
+
 	for (int i = 0; i < config::meshes.size(); ++i)
 		resources.loadMesh(i, config::meshes[i]);
 
@@ -110,6 +116,11 @@ void ApplicationResources::init()
 	for (int i = 0; i < config::hdrTextures.size(); ++i)
 		resources.loadTexture(config::Textures::EnvironmentBase + i, config::hdrTextures[i]);
 
+	blue_noise = new Texture(driver);
+	blue_noise->import(config::blueNoise);
+
+	driver->endUploadBatch();
+
 	baked_brdf = RenderUtils::createTexture2D(
 		driver,
 		render::backend::Format::R16G16_SFLOAT,
@@ -145,9 +156,6 @@ void ApplicationResources::init()
 			environment_cubemaps[i]
 		);
 	}
-
-	blue_noise = new Texture(driver);
-	blue_noise->import(config::blueNoise);
 }
 
 void ApplicationResources::shutdown()
@@ -19,8 +19,10 @@ namespace config
 		DiffuseIrradianceCubemapFragment,
 		BakedBRDFFragment,
 		SkylightDeferredFragment,
+		SkylightDeferredSubpassFragment,
 		GBufferVertex,
 		GBufferFragment,
+		GBufferBindlessFragment,
 		SSAOFragment,
 		SSAOBlurFragment,
 		SSRTraceFragment,
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
 /*
  */
@@ -78,8 +79,7 @@ io::IStream *ApplicationFileSystem::open(const char *path, const char *mode)
 	const char *offset = strstr(path, root_path.c_str());
 	std::string resolved_path = (offset != path) ? root_path + path : path;
 
-	FILE *file = nullptr;
-	fopen_s(&file, resolved_path.c_str(), mode);
+	FILE *file = fopen(resolved_path.c_str(), mode);
 	if (!file)
 		return nullptr;
 
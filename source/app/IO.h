@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/IO.h>
+#include <cstdio>
 #include <string>
 
 class ApplicationStream : public io::IStream
@@ -169,7 +169,7 @@ void ImGuiRenderer::updateBuffers(const ImDrawData *draw_data)
 		index_buffer_size = index_size * num_indices;
 
 		driver->destroyIndexBuffer(indices);
-		indices = driver->createIndexBuffer(render::backend::BufferType::DYNAMIC, index_format, num_indices, nullptr);
+		indices = driver->createIndexBuffer(render::backend::BufferType::TRANSIENT, index_format, num_indices, nullptr);
 	}
 
 	// resize vertex buffer
@@ -178,7 +178,7 @@ void ImGuiRenderer::updateBuffers(const ImDrawData *draw_data)
 		vertex_buffer_size = vertex_size * num_vertices;
 
 		driver->destroyVertexBuffer(vertices);
-		vertices = driver->createVertexBuffer(render::backend::BufferType::DYNAMIC, vertex_size, num_vertices, num_attributes, attributes, nullptr);
+		vertices = driver->createVertexBuffer(render::backend::BufferType::TRANSIENT, vertex_size, num_vertices, num_attributes, attributes, nullptr);
 	}
 
 	ImDrawVert *vertex_data = reinterpret_cast<ImDrawVert *>(driver->map(vertices));
@@ -16,6 +16,51 @@ Mesh::~Mesh()
 	clearCPUData();
 }
 
+/*
+ */
+render::backend::GeometryArena *Mesh::createGeometryArena(render::backend::Driver *driver, uint32_t num_vertices, uint32_t num_indices)
+{
+	return driver->createGeometryArena(
+		sizeof(Vertex),
+		NUM_VERTEX_ATTRIBUTES, getVertexAttributes(),
+		render::backend::IndexFormat::UINT32,
+		num_vertices, num_indices
+	);
+}
+
+const render::backend::VertexAttribute *Mesh::getVertexAttributes()
+{
+	static render::backend::VertexAttribute attributes[NUM_VERTEX_ATTRIBUTES] =
+	{
+		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, position) },
+		{ render::backend::Format::R32G32_SFLOAT, offsetof(Vertex, uv) },
+		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, tangent) },
+		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, binormal) },
+		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, normal) },
+		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, color) },
+	};
+
+	return attributes;
+}
+
+/*
+ */
+uint32_t Mesh::getBaseIndex() const
+{
+	if (geometry == nullptr)
+		return 0;
+
+	return driver->getGeometryRange(arena, geometry).first_index;
+}
+
+int32_t Mesh::getBaseVertex() const
+{
+	if (geometry == nullptr)
+		return 0;
+
+	return driver->getGeometryRange(arena, geometry).vertex_offset;
+}
+
 /*
  */
 bool Mesh::import(const char *path)
@@ -169,20 +214,10 @@ void Mesh::createQuad(float size)
  */
 void Mesh::createVertexBuffer()
 {
-	static render::backend::VertexAttribute attributes[6] =
-	{
-		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, position) },
-		{ render::backend::Format::R32G32_SFLOAT, offsetof(Vertex, uv) },
-		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, tangent) },
-		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, binormal) },
-		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, normal) },
-		{ render::backend::Format::R32G32B32_SFLOAT, offsetof(Vertex, color) },
-	};
-
 	vertex_buffer = driver->createVertexBuffer(
 		render::backend::BufferType::STATIC,
 		sizeof(Vertex), static_cast<uint32_t>(vertices.size()),
-		6, attributes,
+		NUM_VERTEX_ATTRIBUTES, getVertexAttributes(),
 		vertices.data()
 	);
 }
@@ -199,20 +234,56 @@ void Mesh::createIndexBuffer()
 	);
 }
 
+void Mesh::createGeometry()
+{
+	num_indices = static_cast<uint32_t>(indices.size());
+
+	geometry = driver->allocateGeometry(
+		arena,
+		static_cast<uint32_t>(vertices.size()), vertices.data(),
+		num_indices, indices.data()
+	);
+
+	if (geometry == nullptr)
+		return;
+
+	// arena buffers are stable, only ranges move on compaction
+	render::backend::GeometryRange range = driver->getGeometryRange(arena, geometry);
+	vertex_buffer = range.vertex_buffer;
+	index_buffer = range.index_buffer;
+}
+
 /*
  */
 void Mesh::uploadToGPU()
 {
 	clearGPUData();
 
+	if (arena)
+	{
+		createGeometry();
+		return;
+	}
+
 	createVertexBuffer();
 	createIndexBuffer();
 }
 
 void Mesh::clearGPUData()
 {
-	driver->destroyVertexBuffer(vertex_buffer);
-	driver->destroyIndexBuffer(index_buffer);
+	if (arena)
+	{
+		driver->freeGeometry(arena, geometry);
+		geometry = nullptr;
+	}
+	else
+	{
+		driver->destroyVertexBuffer(vertex_buffer);
+		driver->destroyIndexBuffer(index_buffer);
+	}
+
+	vertex_buffer = nullptr;
+	index_buffer = nullptr;
 }
 
 void Mesh::clearCPUData()
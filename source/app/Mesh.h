@@ -10,6 +10,9 @@ namespace render::backend
 	class Driver;
 	struct VertexBuffer;
 	struct IndexBuffer;
+	struct GeometryArena;
+	struct GeometryAllocation;
+	struct VertexAttribute;
 }
 
 /*
@@ -17,15 +20,21 @@ namespace render::backend
 class Mesh
 {
 public:
-	Mesh(render::backend::Driver *driver)
-		: driver(driver) { }
+	// meshes with an arena share its buffers, draws must use base index & vertex
+	Mesh(render::backend::Driver *driver, render::backend::GeometryArena *arena = nullptr)
+		: driver(driver), arena(arena) { }
 
 	~Mesh();
 
+	static render::backend::GeometryArena *createGeometryArena(render::backend::Driver *driver, uint32_t num_vertices, uint32_t num_indices);
+
 	inline uint32_t getNumIndices() const { return num_indices; }
 	inline render::backend::VertexBuffer *getVertexBuffer() const { return vertex_buffer; }
 	inline render::backend::IndexBuffer *getIndexBuffer() const { return index_buffer; }
 
+	uint32_t getBaseIndex() const;
+	int32_t getBaseVertex() const;
+
 	bool import(const char *path);
 	bool import(const aiMesh *mesh);
 
@@ -37,11 +46,16 @@ public:
 	void clearCPUData();
 
 private:
+	static const render::backend::VertexAttribute *getVertexAttributes();
+	static constexpr uint8_t NUM_VERTEX_ATTRIBUTES = 6;
+
 	void createVertexBuffer();
 	void createIndexBuffer();
+	void createGeometry();
 
 private:
 	render::backend::Driver *driver {nullptr};
+	render::backend::GeometryArena *arena {nullptr};
 
 	struct Vertex
 	{
@@ -58,5 +72,6 @@ private:
 
 	render::backend::VertexBuffer *vertex_buffer {nullptr};
 	render::backend::IndexBuffer *index_buffer {nullptr};
+	render::backend::GeometryAllocation *geometry {nullptr};
 	uint32_t num_indices {0};
 };
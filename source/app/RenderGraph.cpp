@@ -43,6 +43,7 @@ void RenderGraph::init(const ApplicationResources *resources, uint32_t width, ui
 	imgui_renderer->init(ImGui::GetCurrentContext());
 
 	initRenderPasses();
+	initQueries();
 	initSSAOKernel();
 	initSSRData(resources->getBlueNoiseTexture());
 	initTransient(width, height);
@@ -52,6 +53,7 @@ void RenderGraph::init(const ApplicationResources *resources, uint32_t width, ui
 
 	gbuffer_pass_vertex = resources->getShader(config::Shaders::GBufferVertex);
 	gbuffer_pass_fragment = resources->getShader(config::Shaders::GBufferFragment);
+	gbuffer_pass_bindless_fragment = resources->getShader(config::Shaders::GBufferBindlessFragment);
 
 	fullscreen_quad_vertex = resources->getShader(config::Shaders::FullscreenQuadVertex);
 
@@ -67,6 +69,7 @@ void RenderGraph::init(const ApplicationResources *resources, uint32_t width, ui
 void RenderGraph::shutdown()
 {
 	shutdownRenderPasses();
+	shutdownQueries();
 	shutdownSSAOKernel();
 	shutdownSSRData();
 	shutdownTransient();
@@ -82,6 +85,7 @@ void RenderGraph::shutdown()
 
 	gbuffer_pass_vertex = nullptr;
 	gbuffer_pass_fragment = nullptr;
+	gbuffer_pass_bindless_fragment = nullptr;
 
 	fullscreen_quad_vertex = nullptr;
 
@@ -94,6 +98,26 @@ void RenderGraph::shutdown()
 	tonemapping_pass_fragment = nullptr;
 }
 
+void RenderGraph::initQueries()
+{
+	// both pools are optional, passes are simply not timed without them
+	timestamp_pool = driver->createQueryPool(render::backend::QueryType::TIMESTAMP, NUM_QUERY_FRAMES * NUM_PASS_TIMESTAMPS);
+	statistics_pool = driver->createQueryPool(render::backend::QueryType::PIPELINE_STATISTICS, NUM_QUERY_FRAMES);
+
+	current_query_frame = 0;
+	for (int i = 0; i < NUM_QUERY_FRAMES; ++i)
+		query_frame_pending[i] = false;
+}
+
+void RenderGraph::shutdownQueries()
+{
+	driver->destroyQueryPool(timestamp_pool);
+	timestamp_pool = nullptr;
+
+	driver->destroyQueryPool(statistics_pool);
+	statistics_pool = nullptr;
+}
+
 void RenderGraph::initRenderPasses()
 {
 	render::backend::Multisample samples = render::backend::Multisample::COUNT_1;
@@ -138,6 +162,41 @@ void RenderGraph::initRenderPasses()
 		lbuffer_render_pass = driver->createRenderPass(2, render_pass_attachments, render_pass_description);
 	}
 
+	{ // GBuffer + LBuffer, lighting reads the gbuffer from tile memory
+		render::backend::RenderPassClearValue clear_depth;
+		clear_depth.as_depth_stencil = { 1.0f, 0 };
+
+		// gbuffer is still stored, SSAO, SSR and temporal filters sample it later in the frame
+		render::backend::RenderPassAttachment render_pass_attachments[7] =
+		{
+			{ render::backend::Format::D32_SFLOAT, samples, render::backend::RenderPassLoadOp::CLEAR, render::backend::RenderPassStoreOp::STORE, clear_depth },
+			{ render::backend::Format::R8G8B8A8_UNORM, samples, render::backend::RenderPassLoadOp::DONT_CARE, render::backend::RenderPassStoreOp::STORE },
+			{ render::backend::Format::R16G16B16A16_SFLOAT, samples, render::backend::RenderPassLoadOp::DONT_CARE, render::backend::RenderPassStoreOp::STORE },
+			{ render::backend::Format::R8G8_UNORM, samples, render::backend::RenderPassLoadOp::DONT_CARE, render::backend::RenderPassStoreOp::STORE },
+			{ render::backend::Format::R16G16_SFLOAT, samples, render::backend::RenderPassLoadOp::DONT_CARE, render::backend::RenderPassStoreOp::STORE },
+			{ render::backend::Format::R16G16B16A16_SFLOAT, samples, render::backend::RenderPassLoadOp::DONT_CARE, render::backend::RenderPassStoreOp::STORE },
+			{ render::backend::Format::R16G16B16A16_SFLOAT, samples, render::backend::RenderPassLoadOp::DONT_CARE, render::backend::RenderPassStoreOp::STORE },
+		};
+
+		uint32_t gbuffer_color_attachments[4] = { 1, 2, 3, 4 };
+		uint32_t gbuffer_depthstencil_attachment[1] = { 0 };
+
+		uint32_t lbuffer_color_attachments[2] = { 5, 6 };
+		uint32_t lbuffer_input_attachments[4] = { 1, 2, 3, 0 }; // matches gbuffer bindings
+
+		render::backend::RenderPassDescription subpasses[2] = {};
+		subpasses[0].num_color_attachments = 4;
+		subpasses[0].color_attachments = gbuffer_color_attachments;
+		subpasses[0].depthstencil_attachment = gbuffer_depthstencil_attachment;
+
+		subpasses[1].num_color_attachments = 2;
+		subpasses[1].color_attachments = lbuffer_color_attachments;
+		subpasses[1].num_input_attachments = 4;
+		subpasses[1].input_attachments = lbuffer_input_attachments;
+
+		deferred_render_pass = driver->createRenderPass(7, render_pass_attachments, 2, subpasses);
+	}
+
 	{ // SSR Resolve
 		render::backend::RenderPassAttachment render_pass_attachments[2] =
 		{
@@ -211,6 +270,9 @@ void RenderGraph::shutdownRenderPasses()
 	driver->destroyRenderPass(lbuffer_render_pass);
 	lbuffer_render_pass = nullptr;
 
+	driver->destroyRenderPass(deferred_render_pass);
+	deferred_render_pass = nullptr;
+
 	driver->destroyRenderPass(ssao_render_pass);
 	ssao_render_pass = nullptr;
 
@@ -266,10 +328,13 @@ void RenderGraph::shutdownTransient()
 
 void RenderGraph::initGBuffer(uint32_t width, uint32_t height)
 {
-	gbuffer.base_color = driver->createTexture2D(width, height, 1, render::backend::Format::R8G8B8A8_UNORM);
-	gbuffer.normal = driver->createTexture2D(width, height, 1, render::backend::Format::R16G16B16A16_SFLOAT);
-	gbuffer.shading = driver->createTexture2D(width, height, 1, render::backend::Format::R8G8_UNORM);
-	gbuffer.depth = driver->createTexture2D(width, height, 1, render::backend::Format::D32_SFLOAT);
+	// read with subpassLoad by the lighting subpass
+	uint32_t usage_flags = render::backend::TEXTURE_USAGE_INPUT_ATTACHMENT;
+
+	gbuffer.base_color = driver->createTexture2D(width, height, 1, render::backend::Format::R8G8B8A8_UNORM, nullptr, 1, usage_flags);
+	gbuffer.normal = driver->createTexture2D(width, height, 1, render::backend::Format::R16G16B16A16_SFLOAT, nullptr, 1, usage_flags);
+	gbuffer.shading = driver->createTexture2D(width, height, 1, render::backend::Format::R8G8_UNORM, nullptr, 1, usage_flags);
+	gbuffer.depth = driver->createTexture2D(width, height, 1, render::backend::Format::D32_SFLOAT, nullptr, 1, usage_flags);
 	gbuffer.velocity = driver->createTexture2D(width, height, 1, render::backend::Format::R16G16_SFLOAT);
 
 	render::backend::FrameBufferAttachment gbuffer_attachments[5] = {
@@ -288,6 +353,13 @@ void RenderGraph::initGBuffer(uint32_t width, uint32_t height)
 	driver->bindTexture(gbuffer.bindings, 2, gbuffer.shading);
 	driver->bindTexture(gbuffer.bindings, 3, gbuffer.depth);
 
+	gbuffer.input_bindings = driver->createBindSet();
+
+	driver->bindInputAttachment(gbuffer.input_bindings, 0, gbuffer.base_color);
+	driver->bindInputAttachment(gbuffer.input_bindings, 1, gbuffer.normal);
+	driver->bindInputAttachment(gbuffer.input_bindings, 2, gbuffer.shading);
+	driver->bindInputAttachment(gbuffer.input_bindings, 3, gbuffer.depth);
+
 	gbuffer.velocity_bindings = driver->createBindSet();
 
 	driver->bindTexture(gbuffer.velocity_bindings, 0, gbuffer.velocity);
@@ -304,6 +376,7 @@ void RenderGraph::shutdownGBuffer()
 	driver->destroyFrameBuffer(gbuffer.frame_buffer);
 
 	driver->destroyBindSet(gbuffer.bindings);
+	driver->destroyBindSet(gbuffer.input_bindings);
 	driver->destroyBindSet(gbuffer.velocity_bindings);
 
 	memset(&gbuffer, 0, sizeof(GBuffer));
@@ -461,6 +534,18 @@ void RenderGraph::initLBuffer(uint32_t width, uint32_t height)
 	};
 
 	lbuffer.frame_buffer = driver->createFrameBuffer(2, lbuffer_attachments);
+
+	render::backend::FrameBufferAttachment merged_attachments[7] = {
+		{ gbuffer.depth },
+		{ gbuffer.base_color },
+		{ gbuffer.normal },
+		{ gbuffer.shading },
+		{ gbuffer.velocity },
+		{ lbuffer.diffuse },
+		{ lbuffer.specular },
+	};
+
+	lbuffer.merged_frame_buffer = driver->createFrameBuffer(7, merged_attachments);
 	lbuffer.bindings = driver->createBindSet();
 
 	driver->bindTexture(lbuffer.bindings, 0, lbuffer.diffuse);
@@ -472,6 +557,7 @@ void RenderGraph::shutdownLBuffer()
 	driver->destroyTexture(lbuffer.diffuse);
 	driver->destroyTexture(lbuffer.specular);
 	driver->destroyFrameBuffer(lbuffer.frame_buffer);
+	driver->destroyFrameBuffer(lbuffer.merged_frame_buffer);
 	driver->destroyBindSet(lbuffer.bindings);
 
 	memset(&lbuffer, 0, sizeof(LBuffer));
@@ -504,6 +590,8 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 	driver->resetCommandBuffer(command_buffer);
 	driver->beginCommandBuffer(command_buffer);
 
+	fetchTimings(command_buffer);
+
 	if (first_frame)
 	{
 		prepareOldTexture(old_composite, command_buffer);
@@ -511,6 +599,15 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		first_frame = false;
 	}
 
+	bool lighting_merged = merge_lighting && canMergeLighting(scene);
+
+	if (lighting_merged)
+	{
+		ZoneScopedN("GBuffer + LBuffer pass");
+
+		renderMergedDeferred(scene, command_buffer, application_bindings, camera_bindings);
+	}
+	else
 	{
 		ZoneScopedN("GBuffer pass");
 
@@ -519,7 +616,9 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, true);
 		driver->setDepthTest(pipeline_state, true);
 
+		beginPass(command_buffer, Pass::GBUFFER);
 		renderGBuffer(scene, command_buffer, application_bindings, camera_bindings);
+		endPass(command_buffer, Pass::GBUFFER);
 	}
 
 	{
@@ -530,7 +629,9 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, false);
 		driver->setDepthTest(pipeline_state, false);
 
+		beginPass(command_buffer, Pass::SSAO);
 		renderSSAO(scene, command_buffer, camera_bindings);
+		endPass(command_buffer, Pass::SSAO);
 	}
 
 	{
@@ -541,13 +642,18 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, false);
 		driver->setDepthTest(pipeline_state, false);
 
+		beginPass(command_buffer, Pass::SSAO_BLUR);
 		renderSSAOBlur(scene, command_buffer, application_bindings);
+		endPass(command_buffer, Pass::SSAO_BLUR);
 	}
 
+	if (!lighting_merged)
 	{
 		ZoneScopedN("LBuffer pass");
 
+		beginPass(command_buffer, Pass::LBUFFER);
 		renderLBuffer(scene, command_buffer, camera_bindings);
+		endPass(command_buffer, Pass::LBUFFER);
 	}
 
 	{
@@ -558,7 +664,9 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, false);
 		driver->setDepthTest(pipeline_state, false);
 
+		beginPass(command_buffer, Pass::SSR_TRACE);
 		renderSSRTrace(scene, command_buffer, application_bindings, camera_bindings);
+		endPass(command_buffer, Pass::SSR_TRACE);
 	}
 
 	{
@@ -569,7 +677,9 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, false);
 		driver->setDepthTest(pipeline_state, false);
 
+		beginPass(command_buffer, Pass::SSR_RESOLVE);
 		renderSSRResolve(scene, command_buffer, application_bindings, camera_bindings);
+		endPass(command_buffer, Pass::SSR_RESOLVE);
 	}
 
 	{
@@ -580,13 +690,17 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, false);
 		driver->setDepthTest(pipeline_state, false);
 
+		beginPass(command_buffer, Pass::SSR_TEMPORAL_FILTER);
 		renderSSRTemporalFilter(scene, command_buffer);
+		endPass(command_buffer, Pass::SSR_TEMPORAL_FILTER);
 	}
 
 	{
 		ZoneScopedN("Composite pass");
 
+		beginPass(command_buffer, Pass::COMPOSITE);
 		renderComposite(scene, command_buffer);
+		endPass(command_buffer, Pass::COMPOSITE);
 	}
 
 	{
@@ -597,51 +711,141 @@ void RenderGraph::render(render::backend::CommandBuffer *command_buffer, render:
 		driver->setDepthWrite(pipeline_state, false);
 		driver->setDepthTest(pipeline_state, false);
 
+		beginPass(command_buffer, Pass::COMPOSITE_TEMPORAL_FILTER);
 		renderCompositeTemporalFilter(scene, command_buffer);
+		endPass(command_buffer, Pass::COMPOSITE_TEMPORAL_FILTER);
 	}
 
 	{
 		ZoneScopedN("Tonemapping + ImGui pass");
 
+		beginPass(command_buffer, Pass::TONEMAPPING);
 		renderToSwapChain(scene, command_buffer, swap_chain);
+		endPass(command_buffer, Pass::TONEMAPPING);
 	}
 
 	// Swap temporal filters
 	std::swap(old_ssr, ssr);
 	std::swap(old_composite, composite);
 
+	query_frame_pending[current_query_frame] = true;
+	current_query_frame = (current_query_frame + 1) % NUM_QUERY_FRAMES;
+
 	driver->endCommandBuffer(command_buffer);
 }
 
+/*
+ */
+void RenderGraph::fetchTimings(render::backend::CommandBuffer *command_buffer)
+{
+	uint32_t first_timestamp = current_query_frame * NUM_PASS_TIMESTAMPS;
+
+	// queries of this frame slot were recorded NUM_QUERY_FRAMES ago, keep old timings if GPU is still behind
+	if (query_frame_pending[current_query_frame])
+	{
+		uint64_t timestamps[NUM_PASS_TIMESTAMPS];
+		if (driver->getQueryResults(timestamp_pool, first_timestamp, NUM_PASS_TIMESTAMPS, timestamps))
+		{
+			float ms_per_tick = driver->getTimestampPeriod() / 1000000.0f;
+			float pass_timings[static_cast<int>(Pass::MAX)];
+
+			for (int i = 0; i < static_cast<int>(Pass::MAX); ++i)
+				pass_timings[i] = static_cast<float>(timestamps[i * 2 + 1] - timestamps[i * 2]) * ms_per_tick;
+
+			timings.gbuffer = pass_timings[static_cast<int>(Pass::GBUFFER)];
+			timings.ssao = pass_timings[static_cast<int>(Pass::SSAO)];
+			timings.ssao_blur = pass_timings[static_cast<int>(Pass::SSAO_BLUR)];
+			timings.lbuffer = pass_timings[static_cast<int>(Pass::LBUFFER)];
+			timings.ssr_trace = pass_timings[static_cast<int>(Pass::SSR_TRACE)];
+			timings.ssr_resolve = pass_timings[static_cast<int>(Pass::SSR_RESOLVE)];
+			timings.ssr_temporal_filter = pass_timings[static_cast<int>(Pass::SSR_TEMPORAL_FILTER)];
+			timings.composite = pass_timings[static_cast<int>(Pass::COMPOSITE)];
+			timings.composite_temporal_filter = pass_timings[static_cast<int>(Pass::COMPOSITE_TEMPORAL_FILTER)];
+			timings.tonemapping = pass_timings[static_cast<int>(Pass::TONEMAPPING)];
+			timings.total = static_cast<float>(timestamps[NUM_PASS_TIMESTAMPS - 1] - timestamps[0]) * ms_per_tick;
+			timings.num_samples++;
+		}
+
+		driver->getQueryResults(statistics_pool, current_query_frame, 1, &timings.gbuffer_statistics);
+	}
+
+	driver->resetQueries(command_buffer, timestamp_pool, first_timestamp, NUM_PASS_TIMESTAMPS);
+	driver->resetQueries(command_buffer, statistics_pool, current_query_frame, 1);
+}
+
+void RenderGraph::beginPass(render::backend::CommandBuffer *command_buffer, Pass pass)
+{
+	uint32_t query = current_query_frame * NUM_PASS_TIMESTAMPS + static_cast<uint32_t>(pass) * 2;
+	driver->beginTimestamp(command_buffer, timestamp_pool, query);
+
+	if (pass == Pass::GBUFFER)
+		driver->beginQuery(command_buffer, statistics_pool, current_query_frame);
+}
+
+void RenderGraph::endPass(render::backend::CommandBuffer *command_buffer, Pass pass)
+{
+	if (pass == Pass::GBUFFER)
+		driver->endQuery(command_buffer, statistics_pool, current_query_frame);
+
+	uint32_t query = current_query_frame * NUM_PASS_TIMESTAMPS + static_cast<uint32_t>(pass) * 2 + 1;
+	driver->endTimestamp(command_buffer, timestamp_pool, query);
+}
+
 void RenderGraph::renderGBuffer(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings)
 {
 	driver->beginRenderPass(command_buffer, gbuffer_render_pass, gbuffer.frame_buffer);
+	renderGBufferGeometry(scene, command_buffer, application_bindings, camera_bindings);
+	driver->endRenderPass(command_buffer);
+}
 
+void RenderGraph::renderGBufferGeometry(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings)
+{
 	driver->clearPushConstants(pipeline_state);
 	driver->clearBindSets(pipeline_state);
 	driver->setBindSet(pipeline_state, 0, application_bindings);
 	driver->setBindSet(pipeline_state, 1, camera_bindings);
 
+	// materials are indices into the bindless table, set 2 stays bound for the whole pass
+	bool bindless = driver->isBindlessSupported();
+	const Shader *fragment_shader = (bindless) ? gbuffer_pass_bindless_fragment : gbuffer_pass_fragment;
+
+	if (bindless)
+		driver->setBindSet(pipeline_state, 2, driver->getBindlessBindSet());
+
 	driver->clearShaders(pipeline_state);
 	driver->setShader(pipeline_state, render::backend::ShaderType::VERTEX, gbuffer_pass_vertex->getBackend());
-	driver->setShader(pipeline_state, render::backend::ShaderType::FRAGMENT, gbuffer_pass_fragment->getBackend());
+	driver->setShader(pipeline_state, render::backend::ShaderType::FRAGMENT, fragment_shader->getBackend());
+
+	struct NodePushConstants
+	{
+		glm::mat4 transform;
+		uint32_t material_indices[4];
+	};
 
 	driver->clearVertexStreams(pipeline_state);
 	for (size_t i = 0; i < scene->getNumNodes(); ++i)
 	{
 		const Mesh *node_mesh = scene->getNodeMesh(i);
 		const glm::mat4 &node_transform = scene->getNodeWorldTransform(i);
-		render::backend::BindSet *node_bindings = scene->getNodeBindings(i);
 
 		driver->setVertexStream(pipeline_state, 0, node_mesh->getVertexBuffer());
 
-		driver->setBindSet(pipeline_state, 2, node_bindings);
-		driver->setPushConstants(pipeline_state, static_cast<uint8_t>(sizeof(glm::mat4)), &node_transform);
+		if (bindless)
+		{
+			NodePushConstants push_constants;
+			push_constants.transform = node_transform;
+			memcpy(push_constants.material_indices, scene->getNodeBindlessIndices(i), sizeof(push_constants.material_indices));
 
-		driver->drawIndexedPrimitiveInstanced(command_buffer, pipeline_state, node_mesh->getIndexBuffer(), node_mesh->getNumIndices());
-	}
+			driver->setPushConstants(pipeline_state, static_cast<uint8_t>(sizeof(NodePushConstants)), &push_constants);
+		}
+		else
+		{
+			driver->setBindSet(pipeline_state, 2, scene->getNodeBindings(i));
+			driver->setPushConstants(pipeline_state, static_cast<uint8_t>(sizeof(glm::mat4)), &node_transform);
+		}
 
-	driver->endRenderPass(command_buffer);
+		driver->drawIndexedPrimitiveInstanced(command_buffer, pipeline_state, node_mesh->getIndexBuffer(), node_mesh->getNumIndices(), node_mesh->getBaseIndex(), node_mesh->getBaseVertex());
+	}
 }
 
 void RenderGraph::renderSSAO(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *camera_bindings)
@@ -742,18 +946,23 @@ void RenderGraph::renderSSRTemporalFilter(const Scene *scene, render::backend::C
 void RenderGraph::renderLBuffer(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *camera_bindings)
 {
 	driver->beginRenderPass(command_buffer, lbuffer_render_pass, lbuffer.frame_buffer);
+	renderLights(scene, command_buffer, camera_bindings, false);
+	driver->endRenderPass(command_buffer);
+}
 
+void RenderGraph::renderLights(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *camera_bindings, bool subpass_input)
+{
 	driver->clearPushConstants(pipeline_state);
 	driver->clearBindSets(pipeline_state);
 	driver->setBindSet(pipeline_state, 0, camera_bindings);
-	driver->setBindSet(pipeline_state, 1, gbuffer.bindings);
+	driver->setBindSet(pipeline_state, 1, (subpass_input) ? gbuffer.input_bindings : gbuffer.bindings);
 
 	for (size_t i = 0; i < scene->getNumLights(); ++i)
 	{
 		const Light *light = scene->getLight(i);
 
 		const Shader *vertex_shader = light->getVertexShader();
-		const Shader *fragment_shader = light->getFragmentShader();
+		const Shader *fragment_shader = (subpass_input) ? light->getSubpassFragmentShader() : light->getFragmentShader();
 		const Mesh *light_mesh = light->getMesh();
 
 		render::backend::BindSet *light_bindings = light->getBindSet();
@@ -769,10 +978,45 @@ void RenderGraph::renderLBuffer(const Scene *scene, render::backend::CommandBuff
 
 		driver->drawIndexedPrimitiveInstanced(command_buffer, pipeline_state, light_mesh->getIndexBuffer(), light_mesh->getNumIndices());
 	}
+}
+
+void RenderGraph::renderMergedDeferred(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings)
+{
+	driver->beginRenderPass(command_buffer, deferred_render_pass, lbuffer.merged_frame_buffer);
+
+	driver->setBlending(pipeline_state, false);
+	driver->setCullMode(pipeline_state, render::backend::CullMode::BACK);
+	driver->setDepthWrite(pipeline_state, true);
+	driver->setDepthTest(pipeline_state, true);
+
+	// queries must begin and end within one subpass
+	beginPass(command_buffer, Pass::GBUFFER);
+	renderGBufferGeometry(scene, command_buffer, application_bindings, camera_bindings);
+	endPass(command_buffer, Pass::GBUFFER);
+
+	driver->nextSubpass(command_buffer);
+
+	driver->setBlending(pipeline_state, false);
+	driver->setCullMode(pipeline_state, render::backend::CullMode::NONE);
+	driver->setDepthWrite(pipeline_state, false);
+	driver->setDepthTest(pipeline_state, false);
+
+	beginPass(command_buffer, Pass::LBUFFER);
+	renderLights(scene, command_buffer, camera_bindings, true);
+	endPass(command_buffer, Pass::LBUFFER);
 
 	driver->endRenderPass(command_buffer);
 }
 
+bool RenderGraph::canMergeLighting(const Scene *scene) const
+{
+	for (size_t i = 0; i < scene->getNumLights(); ++i)
+		if (scene->getLight(i)->getSubpassFragmentShader() == nullptr)
+			return false;
+
+	return true;
+}
+
 void RenderGraph::renderComposite(const Scene *scene, render::backend::CommandBuffer *command_buffer)
 {
 	driver->beginRenderPass(command_buffer, hdr_render_pass, composite_temp.frame_buffer);
@@ -27,6 +27,7 @@ struct GBuffer
 	render::backend::Texture *velocity {nullptr};       // rg16f, uv motion vector
 	render::backend::FrameBuffer *frame_buffer {nullptr};
 	render::backend::BindSet *bindings {nullptr};
+	render::backend::BindSet *input_bindings {nullptr}; // same layout as bindings, read with subpassLoad
 	render::backend::BindSet *velocity_bindings {nullptr};
 };
 
@@ -35,6 +36,7 @@ struct LBuffer
 	render::backend::Texture *diffuse {nullptr};        // rgb16f, hdr linear color
 	render::backend::Texture *specular {nullptr};       // rga16f, hdr linear color
 	render::backend::FrameBuffer *frame_buffer {nullptr};
+	render::backend::FrameBuffer *merged_frame_buffer {nullptr}; // gbuffer + lbuffer attachments
 	render::backend::BindSet *bindings {nullptr};
 };
 
@@ -96,6 +98,27 @@ struct RenderBuffer
 	render::backend::BindSet *bindings {nullptr};
 };
 
+// GPU time of each pass in milliseconds, a few frames old
+struct RenderGraphTimings
+{
+	float gbuffer {0.0f};
+	float ssao {0.0f};
+	float ssao_blur {0.0f};
+	float lbuffer {0.0f};
+	float ssr_trace {0.0f};
+	float ssr_resolve {0.0f};
+	float ssr_temporal_filter {0.0f};
+	float composite {0.0f};
+	float composite_temporal_filter {0.0f};
+	float tonemapping {0.0f}; // includes ImGui
+	float total {0.0f};
+
+	// incremented whenever new results are read back
+	uint32_t num_samples {0};
+
+	render::backend::PipelineStatistics gbuffer_statistics;
+};
+
 /*
  */
 class RenderGraph
@@ -127,12 +150,46 @@ public:
 
 	const RenderBuffer &getSSRTrace() const { return ssr_trace; }
 
+	const RenderGraphTimings &getTimings() const { return timings; }
+
+	bool isLightingMerged() const { return merge_lighting; }
+	void setLightingMerged(bool merged) { merge_lighting = merged; }
+
 	void buildSSAOKernel();
 
 private:
+	enum class Pass : uint8_t
+	{
+		GBUFFER = 0,
+		SSAO,
+		SSAO_BLUR,
+		LBUFFER,
+		SSR_TRACE,
+		SSR_RESOLVE,
+		SSR_TEMPORAL_FILTER,
+		COMPOSITE,
+		COMPOSITE_TEMPORAL_FILTER,
+		TONEMAPPING,
+
+		MAX,
+	};
+
+	enum
+	{
+		// results are read back this many frames later to avoid waiting for the GPU
+		NUM_QUERY_FRAMES = 3,
+		NUM_PASS_TIMESTAMPS = static_cast<int>(Pass::MAX) * 2,
+	};
+
 	void initRenderPasses();
 	void shutdownRenderPasses();
 
+	void initQueries();
+	void shutdownQueries();
+	void fetchTimings(render::backend::CommandBuffer *command_buffer);
+	void beginPass(render::backend::CommandBuffer *command_buffer, Pass pass);
+	void endPass(render::backend::CommandBuffer *command_buffer, Pass pass);
+
 	void initTransient(uint32_t width, uint32_t height);
 	void shutdownTransient();
 
@@ -155,12 +212,16 @@ private:
 	void shutdownLBuffer();
 
 	void renderGBuffer(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings);
+	void renderGBufferGeometry(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings);
 	void renderSSAO(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *camera_bindings);
 	void renderSSAOBlur(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings);
 	void renderSSRTrace(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings);
 	void renderSSRResolve(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings);
 	void renderSSRTemporalFilter(const Scene *scene, render::backend::CommandBuffer *command_buffer);
 	void renderLBuffer(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *camera_bindings);
+	void renderLights(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *camera_bindings, bool subpass_input);
+	void renderMergedDeferred(const Scene *scene, render::backend::CommandBuffer *command_buffer, render::backend::BindSet *application_bindings, render::backend::BindSet *camera_bindings);
+	bool canMergeLighting(const Scene *scene) const;
 	void renderComposite(const Scene *scene, render::backend::CommandBuffer *command_buffer);
 	void renderCompositeTemporalFilter(const Scene *scene, render::backend::CommandBuffer *command_buffer);
 	void renderTemporalFilter(RenderBuffer &current, const RenderBuffer &old, const RenderBuffer &temp, const RenderBuffer &velocity, render::backend::CommandBuffer *command_buffer);
@@ -192,12 +253,20 @@ private:
 	RenderBuffer old_composite;
 
 	bool first_frame {true};
+	bool merge_lighting {true};
+
+	render::backend::QueryPool *timestamp_pool {nullptr};
+	render::backend::QueryPool *statistics_pool {nullptr};
+	uint32_t current_query_frame {0};
+	bool query_frame_pending[NUM_QUERY_FRAMES] {};
+	RenderGraphTimings timings;
 
 	Mesh *quad {nullptr};
 	ImGuiRenderer *imgui_renderer {nullptr};
 
 	render::backend::RenderPass *gbuffer_render_pass {nullptr};
 	render::backend::RenderPass *lbuffer_render_pass {nullptr};
+	render::backend::RenderPass *deferred_render_pass {nullptr}; // gbuffer & lighting subpasses
 	render::backend::RenderPass *ssr_resolve_render_pass {nullptr};
 	render::backend::RenderPass *ssao_render_pass {nullptr};
 	render::backend::RenderPass *hdr_render_pass {nullptr};
@@ -206,6 +275,7 @@ private:
 
 	const Shader *gbuffer_pass_vertex {nullptr};
 	const Shader *gbuffer_pass_fragment {nullptr};
+	const Shader *gbuffer_pass_bindless_fragment {nullptr};
 
 	const Shader *fullscreen_quad_vertex {nullptr};
 
@@ -101,11 +101,23 @@ bool Scene::import(const char *path)
 	if (end != nullptr)
 		dir = std::string(path, strlen(path) - strlen(end));
 	
+	// all scene geometry shares a single vertex & index buffer pair
+	uint32_t num_vertices = 0;
+	uint32_t num_indices = 0;
+
+	for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+	{
+		num_vertices += scene->mMeshes[i]->mNumVertices;
+		num_indices += scene->mMeshes[i]->mNumFaces * 3;
+	}
+
+	geometry_arena = Mesh::createGeometryArena(driver, num_vertices, num_indices);
+
 	// import meshes
 	meshes.resize(scene->mNumMeshes);
 	for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
 	{
-		Mesh *mesh = new Mesh(driver);
+		Mesh *mesh = new Mesh(driver, geometry_arena);
 		mesh->import(scene->mMeshes[i]);
 
 		meshes[i] = mesh;
@@ -162,13 +174,22 @@ bool Scene::import(const char *path)
 		render_material.roughness = import_material_texture(material, aiTextureType_SHININESS);
 		render_material.metalness = import_material_texture(material, aiTextureType_AMBIENT);
 
-		render_material.bindings = driver->createBindSet();
-
 		const render::backend::Texture *albedo = (render_material.albedo) ? render_material.albedo->getBackend() : default_albedo;
 		const render::backend::Texture *normal = (render_material.normal) ? render_material.normal->getBackend() : default_normal;
 		const render::backend::Texture *roughness = (render_material.roughness) ? render_material.roughness->getBackend() : default_roughness;
 		const render::backend::Texture *metalness = (render_material.metalness) ? render_material.metalness->getBackend() : default_metalness;
 
+		if (driver->isBindlessSupported())
+		{
+			render_material.bindless_indices[0] = driver->getBindlessIndex(albedo);
+			render_material.bindless_indices[1] = driver->getBindlessIndex(normal);
+			render_material.bindless_indices[2] = driver->getBindlessIndex(roughness);
+			render_material.bindless_indices[3] = driver->getBindlessIndex(metalness);
+			continue;
+		}
+
+		render_material.bindings = driver->createBindSet();
+
 		driver->bindTexture(render_material.bindings, 0, albedo);
 		driver->bindTexture(render_material.bindings, 1, normal);
 		driver->bindTexture(render_material.bindings, 2, roughness);
@@ -191,6 +212,9 @@ void Scene::clear()
 	for (size_t i = 0; i < meshes.size(); ++i)
 		delete meshes[i];
 
+	driver->destroyGeometryArena(geometry_arena);
+	geometry_arena = nullptr;
+
 	for (size_t i = 0; i < materials.size(); ++i)
 		driver->destroyBindSet(materials[i].bindings);
 
@@ -14,6 +14,7 @@ class Texture;
 namespace render::backend
 {
 	struct BindSet;
+	struct GeometryArena;
 	struct UniformBuffer;
 	class Driver;
 }
@@ -43,6 +44,13 @@ public:
 		return materials[material_index].bindings;
 	}
 
+	// albedo, normal, roughness and metalness indices into the bindless texture table
+	inline const uint32_t *getNodeBindlessIndices(size_t index) const
+	{
+		int32_t material_index = nodes[index].render_material_index;
+		return materials[material_index].bindless_indices;
+	}
+
 	inline void addLight(Light *light) { lights.push_back(light); }
 	inline size_t getNumLights() const { return lights.size(); }
 	inline const Light *getLight(size_t index) const { return lights[index]; }
@@ -63,6 +71,7 @@ private:
 		const Texture *metalness {nullptr};
 		render::backend::UniformBuffer * parameters {nullptr};
 		render::backend::BindSet *bindings {nullptr};
+		uint32_t bindless_indices[4] {};
 	};
 
 private:
@@ -70,6 +79,7 @@ private:
 
 private:
 	render::backend::Driver *driver {nullptr};
+	render::backend::GeometryArena *geometry_arena {nullptr};
 
 	std::vector<Mesh *> meshes;
 	std::map<std::string, Texture *> textures;
@@ -5,8 +5,8 @@
 
 /*
  */
-Light::Light(render::backend::Driver *driver, const Shader *vertex, const Shader *fragment)
-	: driver(driver), vertex_shader(vertex), fragment_shader(fragment)
+Light::Light(render::backend::Driver *driver, const Shader *vertex, const Shader *fragment, const Shader *subpass_fragment)
+	: driver(driver), vertex_shader(vertex), fragment_shader(fragment), subpass_fragment_shader(subpass_fragment)
 {
 	bind_set = driver->createBindSet();
 }
@@ -19,12 +19,13 @@ Light::~Light()
 	mesh = nullptr;
 	vertex_shader = nullptr;
 	fragment_shader = nullptr;
+	subpass_fragment_shader = nullptr;
 }
 
 /*
  */
-SkyLight::SkyLight(render::backend::Driver *driver, const Shader *vertex, const Shader *fragment)
-	: Light(driver, vertex, fragment)
+SkyLight::SkyLight(render::backend::Driver *driver, const Shader *vertex, const Shader *fragment, const Shader *subpass_fragment)
+	: Light(driver, vertex, fragment, subpass_fragment)
 {
 	mesh = new Mesh(driver);
 	mesh->createQuad(2.0f);
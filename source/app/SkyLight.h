@@ -12,13 +12,16 @@ public:
 	Light(
 		render::backend::Driver *driver,
 		const Shader *vertex,
-		const Shader *fragment
+		const Shader *fragment,
+		const Shader *subpass_fragment = nullptr
 	);
 	virtual ~Light();
 
 	inline const Mesh *getMesh() const { return mesh; }
 	inline const Shader *getVertexShader() const { return vertex_shader; }
 	inline const Shader *getFragmentShader() const { return fragment_shader; }
+	// reads the gbuffer as input attachments, lights without it can't be merged into the gbuffer pass
+	inline const Shader *getSubpassFragmentShader() const { return subpass_fragment_shader; }
 	inline render::backend::BindSet *getBindSet() const { return bind_set; }
 
 protected:
@@ -28,6 +31,7 @@ protected:
 	Mesh *mesh {nullptr};
 	const Shader *vertex_shader {nullptr};
 	const Shader *fragment_shader {nullptr};
+	const Shader *subpass_fragment_shader {nullptr};
 };
 
 /*
@@ -38,7 +42,8 @@ public:
 	SkyLight(
 		render::backend::Driver *driver,
 		const Shader *vertex,
-		const Shader *fragment
+		const Shader *fragment,
+		const Shader *subpass_fragment = nullptr
 	);
 	virtual ~SkyLight();
 
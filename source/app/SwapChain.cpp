@@ -8,6 +8,13 @@ SwapChain::SwapChain(render::backend::Driver *driver, void *native_window)
 {
 }
 
+SwapChain::SwapChain(render::backend::Driver *driver, uint32_t width, uint32_t height)
+	: driver(driver)
+	, width(width)
+	, height(height)
+{
+}
+
 SwapChain::~SwapChain()
 {
 	shutdown();
@@ -17,7 +24,7 @@ SwapChain::~SwapChain()
  */
 void SwapChain::init()
 {
-	swap_chain = driver->createSwapChain(native_window);
+	swap_chain = createBackend();
 
 	initFrames();
 }
@@ -25,7 +32,7 @@ void SwapChain::init()
 void SwapChain::recreate()
 {
 	driver->destroySwapChain(swap_chain);
-	swap_chain = driver->createSwapChain(native_window);
+	swap_chain = createBackend();
 }
 
 void SwapChain::shutdown()
@@ -58,6 +65,16 @@ bool SwapChain::present(render::backend::CommandBuffer *command_buffer)
 	return result;
 }
 
+/*
+ */
+render::backend::SwapChain *SwapChain::createBackend()
+{
+	if (native_window == nullptr)
+		return driver->createOffscreenSwapChain(width, height, NUM_OFFSCREEN_IMAGES);
+
+	return driver->createSwapChain(native_window);
+}
+
 /*
  */
 void SwapChain::initFrames()
@@ -9,6 +9,7 @@ class SwapChain
 {
 public:
 	SwapChain(render::backend::Driver *driver, void *native_window);
+	SwapChain(render::backend::Driver *driver, uint32_t width, uint32_t height); // offscreen
 	virtual ~SwapChain();
 
 	void init();
@@ -21,6 +22,8 @@ public:
 	inline render::backend::SwapChain *getBackend() { return swap_chain; }
 
 private:
+	render::backend::SwapChain *createBackend();
+
 	void initFrames();
 	void shutdownFrames();
 
@@ -28,6 +31,7 @@ private:
 	enum
 	{
 		NUM_IN_FLIGHT_FRAMES = 1,
+		NUM_OFFSCREEN_IMAGES = 3,
 	};
 
 	render::backend::Driver *driver {nullptr};
@@ -1,3 +1,5 @@
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -7,23 +9,62 @@
 
 /*
  */
-int main(void)
+static bool parseOptions(int argc, char **argv, ApplicationOptions &options)
 {
-	if (!glfwInit())
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			options.headless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			options.num_frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << argv[i] << std::endl;
+			std::cerr << "Usage: app [--headless] [--frames N]" << std::endl;
+			return false;
+		}
+	}
+
+	// headless runs are benchmarks, there is no window to close
+	if (options.headless && options.num_frames == 0)
+	{
+		std::cerr << "Headless mode needs a frame count, use --frames N" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ */
+int main(int argc, char **argv)
+{
+	ApplicationOptions options;
+	if (!parseOptions(argc, argv, options))
 		return EXIT_FAILURE;
 
+	if (!options.headless && !glfwInit())
+		return EXIT_FAILURE;
+
+	int result = EXIT_SUCCESS;
+
 	try
 	{
 		Application app;
-		app.run();
+		app.run(options);
 	}
 	catch (const std::exception &e)
 	{
 		std::cerr << e.what() << std::endl;
-		glfwTerminate();
-		return EXIT_FAILURE;
+		result = EXIT_FAILURE;
 	}
 
-	glfwTerminate();
-	return EXIT_SUCCESS;
+	if (!options.headless)
+		glfwTerminate();
+
+	return result;
 }
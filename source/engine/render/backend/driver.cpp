@@ -5,11 +5,11 @@
 
 namespace render::backend
 {
-	Driver *Driver::create(const char *application_name, const char *engine_name, Api api)
+	Driver *Driver::create(const char *application_name, const char *engine_name, Api api, bool headless)
 	{
 		switch (api)
 		{
-			case Api::VULKAN: return new vulkan::Driver(application_name, engine_name);
+			case Api::VULKAN: return new vulkan::Driver(application_name, engine_name, headless);
 		}
 
 		return nullptr;
@@ -0,0 +1,163 @@
+#include "render/backend/vulkan/BindlessTable.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	BindlessTable::BindlessTable(const Device *device, SubmitTracker *submit_tracker)
+		: device(device), submit_tracker(submit_tracker), capacity(device->getMaxBindlessTextures())
+	{
+		assert(device->hasDescriptorIndexing() && "Bindless textures require descriptor indexing");
+
+		VkDescriptorSetLayoutBinding binding = {};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = capacity;
+		binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+		// entries are written while the set is bound or in flight, unused ones are never read
+		VkDescriptorBindingFlagsEXT binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+			| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+			| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_info = {};
+		binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		binding_flags_info.bindingCount = 1;
+		binding_flags_info.pBindingFlags = &binding_flags;
+
+		VkDescriptorSetLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layout_info.pNext = &binding_flags_info;
+		layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		layout_info.bindingCount = 1;
+		layout_info.pBindings = &binding;
+
+		VkResult result = vkCreateDescriptorSetLayout(device->getDevice(), &layout_info, nullptr, &set_layout);
+		assert((result == VK_SUCCESS) && "Can't create bindless descriptor set layout");
+
+		VkDescriptorPoolSize pool_size = {};
+		pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pool_size.descriptorCount = capacity;
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		pool_info.maxSets = 1;
+		pool_info.poolSizeCount = 1;
+		pool_info.pPoolSizes = &pool_size;
+
+		result = vkCreateDescriptorPool(device->getDevice(), &pool_info, nullptr, &pool);
+		assert((result == VK_SUCCESS) && "Can't create bindless descriptor pool");
+
+		VkDescriptorSetAllocateInfo set_info = {};
+		set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		set_info.descriptorPool = pool;
+		set_info.descriptorSetCount = 1;
+		set_info.pSetLayouts = &set_layout;
+
+		result = vkAllocateDescriptorSets(device->getDevice(), &set_info, &set);
+		assert((result == VK_SUCCESS) && "Can't allocate bindless descriptor set");
+	}
+
+	BindlessTable::~BindlessTable()
+	{
+		vkDestroyDescriptorPool(device->getDevice(), pool, nullptr);
+		pool = VK_NULL_HANDLE;
+		set = VK_NULL_HANDLE;
+
+		vkDestroyDescriptorSetLayout(device->getDevice(), set_layout, nullptr);
+		set_layout = VK_NULL_HANDLE;
+
+		free_indices.clear();
+		pending_frees.clear();
+	}
+
+	/*
+	 */
+	uint32_t BindlessTable::allocate(VkImageView view, VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		uint32_t index = num_indices;
+
+		if (!free_indices.empty())
+		{
+			index = free_indices.back();
+			free_indices.pop_back();
+		}
+		else if (num_indices < capacity)
+		{
+			num_indices++;
+		}
+		else
+		{
+			std::cerr << "BindlessTable::allocate(): table is full, capacity is " << capacity << " textures" << std::endl;
+			return INVALID_BINDLESS_INDEX;
+		}
+
+		write(index, view, sampler);
+		return index;
+	}
+
+	void BindlessTable::update(uint32_t index, VkImageView view, VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(index < num_indices && "Invalid bindless index");
+
+		write(index, view, sampler);
+	}
+
+	void BindlessTable::free(uint32_t index)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(index < num_indices && "Invalid bindless index");
+
+		// frames recorded so far may still sample this index, textures may be destroyed from loader threads
+		PendingFree pending;
+		pending.serial = submit_tracker->getCurrentSerial();
+		pending.index = index;
+
+		pending_frees.push_back(pending);
+
+		retire();
+	}
+
+	/*
+	 */
+	void BindlessTable::write(uint32_t index, VkImageView view, VkSampler sampler)
+	{
+		VkDescriptorImageInfo image_info = {};
+		image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		image_info.imageView = view;
+		image_info.sampler = sampler;
+
+		VkWriteDescriptorSet write_set = {};
+		write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_set.dstSet = set;
+		write_set.dstBinding = 0;
+		write_set.dstArrayElement = index;
+		write_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write_set.descriptorCount = 1;
+		write_set.pImageInfo = &image_info;
+
+		vkUpdateDescriptorSets(device->getDevice(), 1, &write_set, 0, nullptr);
+	}
+
+	void BindlessTable::retire()
+	{
+		while (!pending_frees.empty())
+		{
+			const PendingFree &pending = pending_frees.front();
+			if (!submit_tracker->isComplete(pending.serial))
+				break;
+
+			free_indices.push_back(pending.index);
+			pending_frees.pop_front();
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <render/backend/Driver.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <volk.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+	class SubmitTracker;
+
+	/*
+	 * Global update-after-bind array of combined image samplers, requires descriptor indexing.
+	 * Indices are stable for the lifetime of a texture and recycled once GPU is done with them.
+	 * Entries may be added from loader threads.
+	 */
+	class BindlessTable
+	{
+	public:
+		BindlessTable(const Device *device, SubmitTracker *submit_tracker);
+		~BindlessTable();
+
+		inline VkDescriptorSetLayout getSetLayout() const { return set_layout; }
+		inline VkDescriptorSet getSet() const { return set; }
+		inline uint32_t getCapacity() const { return capacity; }
+
+		uint32_t allocate(VkImageView view, VkSampler sampler);
+		void update(uint32_t index, VkImageView view, VkSampler sampler);
+		void free(uint32_t index);
+
+	private:
+		struct PendingFree
+		{
+			uint64_t serial {0};
+			uint32_t index {0};
+		};
+
+		void write(uint32_t index, VkImageView view, VkSampler sampler);
+		void retire();
+
+	private:
+		const Device *device {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+
+		VkDescriptorPool pool {VK_NULL_HANDLE};
+		VkDescriptorSetLayout set_layout {VK_NULL_HANDLE};
+		VkDescriptorSet set {VK_NULL_HANDLE};
+
+		uint32_t capacity {0};
+		uint32_t num_indices {0};
+
+		std::vector<uint32_t> free_indices;
+		std::deque<PendingFree> pending_frees;
+		std::mutex mutex;
+	};
+}
@@ -0,0 +1,341 @@
+#include "render/backend/vulkan/DescriptorAllocator.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	struct PoolSizeRatio
+	{
+		VkDescriptorType type;
+		float descriptors_per_set;
+	};
+
+	static PoolSizeRatio pool_size_ratios[] =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1.0f },
+	};
+
+	/*
+	 */
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		// sets die with their pools, only wait for the GPU to stop using them
+		for (PendingFree &pending : pending_frees)
+			submit_tracker->wait(pending.serial);
+
+		pending_frees.clear();
+
+		for (Frame &frame : frames)
+		{
+			submit_tracker->wait(frame.serial);
+
+			for (Pool *pool : frame.pools)
+				destroyPool(pool);
+		}
+
+		frames.clear();
+
+		for (Pool *pool : frame_pools)
+			destroyPool(pool);
+
+		frame_pools.clear();
+
+		for (Pool *pool : free_frame_pools)
+			destroyPool(pool);
+
+		free_frame_pools.clear();
+
+		for (Pool *pool : pools)
+			destroyPool(pool);
+
+		pools.clear();
+		current_pool = nullptr;
+	}
+
+	/*
+	 */
+	VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, VkDescriptorPool &pool)
+	{
+		VkDescriptorSet result = VK_NULL_HANDLE;
+
+		retirePendingFrees();
+
+		if (current_pool && allocateFromPool(current_pool, layout, result) == VK_SUCCESS)
+		{
+			pool = current_pool->pool;
+			return result;
+		}
+
+		// sets might have been freed in older pools
+		for (Pool *candidate : pools)
+		{
+			if (candidate == current_pool || candidate->num_allocated_sets == candidate->max_sets)
+				continue;
+
+			VkResult status = allocateFromPool(candidate, layout, result);
+			if (status == VK_SUCCESS)
+			{
+				current_pool = candidate;
+				pool = candidate->pool;
+				return result;
+			}
+
+			if (status != VK_ERROR_OUT_OF_POOL_MEMORY && status != VK_ERROR_FRAGMENTED_POOL)
+			{
+				std::cerr << "DescriptorAllocator::allocate(): can't allocate descriptor set" << std::endl;
+				return VK_NULL_HANDLE;
+			}
+		}
+
+		current_pool = createPool(false);
+		pools.push_back(current_pool);
+
+		if (allocateFromPool(current_pool, layout, result) != VK_SUCCESS)
+		{
+			std::cerr << "DescriptorAllocator::allocate(): can't allocate descriptor set from a new pool" << std::endl;
+			return VK_NULL_HANDLE;
+		}
+
+		pool = current_pool->pool;
+		return result;
+	}
+
+	void DescriptorAllocator::free(VkDescriptorSet set, VkDescriptorPool pool, uint64_t serial)
+	{
+		if (set == VK_NULL_HANDLE)
+			return;
+
+		if (!submit_tracker->isComplete(serial))
+		{
+			PendingFree pending;
+			pending.serial = serial;
+			pending.set = set;
+			pending.pool = pool;
+
+			pending_frees.push_back(pending);
+			return;
+		}
+
+		freeToPool(set, pool);
+	}
+
+	VkDescriptorSet DescriptorAllocator::allocateTransient(VkDescriptorSetLayout layout)
+	{
+		VkDescriptorSet result = VK_NULL_HANDLE;
+
+		if (!frame_pools.empty())
+		{
+			VkResult status = allocateFromPool(frame_pools.back(), layout, result);
+			if (status == VK_SUCCESS)
+				return result;
+
+			if (status != VK_ERROR_OUT_OF_POOL_MEMORY && status != VK_ERROR_FRAGMENTED_POOL)
+			{
+				std::cerr << "DescriptorAllocator::allocateTransient(): can't allocate descriptor set" << std::endl;
+				return VK_NULL_HANDLE;
+			}
+		}
+
+		Pool *pool = acquireFramePool();
+		frame_pools.push_back(pool);
+
+		if (allocateFromPool(pool, layout, result) != VK_SUCCESS)
+		{
+			std::cerr << "DescriptorAllocator::allocateTransient(): can't allocate descriptor set from a new pool" << std::endl;
+			return VK_NULL_HANDLE;
+		}
+
+		return result;
+	}
+
+	void DescriptorAllocator::endFrame()
+	{
+		if (frame_pools.empty())
+			return;
+
+		Frame frame;
+		frame.serial = submit_tracker->getCurrentSerial();
+		frame.pools = std::move(frame_pools);
+		frame_pools.clear();
+
+		frames.push_back(std::move(frame));
+	}
+
+	/*
+	 */
+	uint32_t DescriptorAllocator::getNumPools() const
+	{
+		uint32_t result = static_cast<uint32_t>(pools.size() + frame_pools.size() + free_frame_pools.size());
+
+		for (const Frame &frame : frames)
+			result += static_cast<uint32_t>(frame.pools.size());
+
+		return result;
+	}
+
+	DescriptorPoolStats DescriptorAllocator::getPoolStats(uint32_t index) const
+	{
+		DescriptorPoolStats result;
+		const Pool *pool = nullptr;
+
+		// persistent pools first, then transient ones from the newest frame to the oldest
+		if (index < pools.size())
+			pool = pools[index];
+		else
+			index -= static_cast<uint32_t>(pools.size());
+
+		if (pool == nullptr && index < frame_pools.size())
+			pool = frame_pools[index];
+		else if (pool == nullptr)
+			index -= static_cast<uint32_t>(frame_pools.size());
+
+		for (auto it = frames.rbegin(); pool == nullptr && it != frames.rend(); ++it)
+		{
+			if (index < it->pools.size())
+				pool = it->pools[index];
+			else
+				index -= static_cast<uint32_t>(it->pools.size());
+		}
+
+		if (pool == nullptr && index < free_frame_pools.size())
+			pool = free_frame_pools[index];
+
+		if (pool == nullptr)
+			return result;
+
+		result.max_sets = pool->max_sets;
+		result.num_allocated_sets = pool->num_allocated_sets;
+		result.num_total_allocations = pool->num_total_allocations;
+		result.transient = pool->transient;
+
+		return result;
+	}
+
+	/*
+	 */
+	DescriptorAllocator::Pool *DescriptorAllocator::createPool(bool transient)
+	{
+		constexpr size_t num_sizes = sizeof(pool_size_ratios) / sizeof(PoolSizeRatio);
+		VkDescriptorPoolSize sizes[num_sizes];
+
+		for (size_t i = 0; i < num_sizes; ++i)
+		{
+			sizes[i].type = pool_size_ratios[i].type;
+			sizes[i].descriptorCount = static_cast<uint32_t>(pool_size_ratios[i].descriptors_per_set * MAX_SETS_PER_POOL);
+		}
+
+		VkDescriptorPoolCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		info.poolSizeCount = static_cast<uint32_t>(num_sizes);
+		info.pPoolSizes = sizes;
+		info.maxSets = MAX_SETS_PER_POOL;
+
+		// transient pools are only ever reset as a whole
+		if (!transient)
+			info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+
+		Pool *result = new Pool();
+		result->max_sets = MAX_SETS_PER_POOL;
+		result->transient = transient;
+
+		VkResult status = vkCreateDescriptorPool(device->getDevice(), &info, nullptr, &result->pool);
+		assert((status == VK_SUCCESS) && "Can't create descriptor pool");
+
+		return result;
+	}
+
+	void DescriptorAllocator::destroyPool(Pool *pool)
+	{
+		vkDestroyDescriptorPool(device->getDevice(), pool->pool, nullptr);
+		delete pool;
+	}
+
+	VkResult DescriptorAllocator::allocateFromPool(Pool *pool, VkDescriptorSetLayout layout, VkDescriptorSet &set)
+	{
+		VkDescriptorSetAllocateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		info.descriptorPool = pool->pool;
+		info.descriptorSetCount = 1;
+		info.pSetLayouts = &layout;
+
+		VkResult result = vkAllocateDescriptorSets(device->getDevice(), &info, &set);
+		if (result != VK_SUCCESS)
+			return result;
+
+		pool->num_allocated_sets++;
+		pool->num_total_allocations++;
+
+		return result;
+	}
+
+	void DescriptorAllocator::freeToPool(VkDescriptorSet set, VkDescriptorPool pool)
+	{
+		for (Pool *candidate : pools)
+		{
+			if (candidate->pool != pool)
+				continue;
+
+			vkFreeDescriptorSets(device->getDevice(), pool, 1, &set);
+
+			assert(candidate->num_allocated_sets > 0);
+			candidate->num_allocated_sets--;
+			return;
+		}
+
+		assert(false && "Descriptor set was not allocated by this allocator");
+	}
+
+	DescriptorAllocator::Pool *DescriptorAllocator::acquireFramePool()
+	{
+		retire();
+
+		if (free_frame_pools.empty())
+			return createPool(true);
+
+		Pool *result = free_frame_pools.back();
+		free_frame_pools.pop_back();
+
+		return result;
+	}
+
+	void DescriptorAllocator::retire()
+	{
+		while (!frames.empty())
+		{
+			Frame &frame = frames.front();
+			if (!submit_tracker->isComplete(frame.serial))
+				break;
+
+			for (Pool *pool : frame.pools)
+			{
+				vkResetDescriptorPool(device->getDevice(), pool->pool, 0);
+				pool->num_allocated_sets = 0;
+
+				free_frame_pools.push_back(pool);
+			}
+
+			frames.pop_front();
+		}
+	}
+
+	void DescriptorAllocator::retirePendingFrees()
+	{
+		while (!pending_frees.empty())
+		{
+			PendingFree &pending = pending_frees.front();
+			if (!submit_tracker->isComplete(pending.serial))
+				break;
+
+			freeToPool(pending.set, pending.pool);
+			pending_frees.pop_front();
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <render/backend/Driver.h>
+
+#include <deque>
+#include <vector>
+#include <volk.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+	class SubmitTracker;
+
+	/*
+	 * Owns descriptor pools. Persistent sets come from pools that support
+	 * freeing individual sets, a new pool is added once existing ones run out.
+	 * Transient sets live for a single frame, their pools are reset wholesale
+	 * once the frame submit is complete.
+	 */
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(const Device *device, SubmitTracker *submit_tracker)
+			: device(device), submit_tracker(submit_tracker) { }
+		~DescriptorAllocator();
+
+		VkDescriptorSet allocate(VkDescriptorSetLayout layout, VkDescriptorPool &pool);
+
+		// set is returned to the pool once the given submit serial is complete
+		void free(VkDescriptorSet set, VkDescriptorPool pool, uint64_t serial = 0);
+
+		VkDescriptorSet allocateTransient(VkDescriptorSetLayout layout);
+
+		// must be called before the submit tracker advances
+		void endFrame();
+
+		uint32_t getNumPools() const;
+		DescriptorPoolStats getPoolStats(uint32_t index) const;
+
+	private:
+		struct Pool
+		{
+			VkDescriptorPool pool {VK_NULL_HANDLE};
+			uint32_t max_sets {0};
+			uint32_t num_allocated_sets {0};
+			uint32_t num_total_allocations {0};
+			bool transient {false};
+		};
+
+		struct Frame
+		{
+			uint64_t serial {0};
+			std::vector<Pool *> pools;
+		};
+
+		struct PendingFree
+		{
+			uint64_t serial {0};
+			VkDescriptorSet set {VK_NULL_HANDLE};
+			VkDescriptorPool pool {VK_NULL_HANDLE};
+		};
+
+		Pool *createPool(bool transient);
+		void destroyPool(Pool *pool);
+
+		VkResult allocateFromPool(Pool *pool, VkDescriptorSetLayout layout, VkDescriptorSet &set);
+		void freeToPool(VkDescriptorSet set, VkDescriptorPool pool);
+		Pool *acquireFramePool();
+		void retire();
+		void retirePendingFrees();
+
+	private:
+		enum
+		{
+			MAX_SETS_PER_POOL = 256,
+		};
+
+		const Device *device {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+
+		std::vector<Pool *> pools;
+		Pool *current_pool {nullptr};
+
+		std::vector<Pool *> frame_pools;
+		std::vector<Pool *> free_frame_pools;
+		std::deque<Frame> frames;
+		std::deque<PendingFree> pending_frees;
+	};
+}
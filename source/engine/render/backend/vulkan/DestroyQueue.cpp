@@ -0,0 +1,190 @@
+#include "render/backend/vulkan/DestroyQueue.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/ImageViewCache.h"
+#include "render/backend/vulkan/MemoryTracker.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+
+#include <cassert>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	DestroyQueue::~DestroyQueue()
+	{
+		// objects queued after the last submit are not referenced by any GPU work
+		vkDeviceWaitIdle(device->getDevice());
+
+		for (const Entry &entry : entries)
+			destroy(entry);
+
+		entries.clear();
+	}
+
+	/*
+	 */
+	void DestroyQueue::destroyBuffer(VkBuffer buffer, VmaAllocation memory)
+	{
+		if (buffer == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::BUFFER;
+		entry.buffer = buffer;
+		entry.memory = memory;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyImage(VkImage image, VmaAllocation memory)
+	{
+		if (image == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::IMAGE;
+		entry.image = image;
+		entry.memory = memory;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyImageViews(ImageViewCache *image_view_cache)
+	{
+		if (image_view_cache == nullptr)
+			return;
+
+		Entry entry;
+		entry.type = Type::IMAGE_VIEWS;
+		entry.image_view_cache = image_view_cache;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyFrameBuffer(VkFramebuffer frame_buffer)
+	{
+		if (frame_buffer == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::FRAME_BUFFER;
+		entry.frame_buffer = frame_buffer;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyRenderPass(VkRenderPass render_pass)
+	{
+		if (render_pass == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::RENDER_PASS;
+		entry.render_pass = render_pass;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyShaderModule(VkShaderModule shader_module)
+	{
+		if (shader_module == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::SHADER_MODULE;
+		entry.shader_module = shader_module;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyPipeline(VkPipeline pipeline)
+	{
+		if (pipeline == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::PIPELINE;
+		entry.pipeline = pipeline;
+
+		push(entry);
+	}
+
+	void DestroyQueue::destroyQueryPool(VkQueryPool query_pool)
+	{
+		if (query_pool == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::QUERY_POOL;
+		entry.query_pool = query_pool;
+
+		push(entry);
+	}
+
+	// moves recorded by defragmentation read old memory blocks, they are released here
+	void DestroyQueue::endDefragmentation(VmaDefragmentationContext context)
+	{
+		if (context == VK_NULL_HANDLE)
+			return;
+
+		Entry entry;
+		entry.type = Type::DEFRAGMENTATION;
+		entry.defragmentation_context = context;
+
+		push(entry);
+	}
+
+	/*
+	 */
+	void DestroyQueue::retire()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		while (!entries.empty())
+		{
+			const Entry &entry = entries.front();
+			if (!submit_tracker->isComplete(entry.serial))
+				break;
+
+			destroy(entry);
+			entries.pop_front();
+		}
+	}
+
+	uint32_t DestroyQueue::getNumPending() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(entries.size());
+	}
+
+	/*
+	 */
+	void DestroyQueue::push(Entry &entry)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// work recorded so far belongs to the current serial, loader threads read it while the render thread submits
+		entry.serial = submit_tracker->getCurrentSerial();
+		entries.push_back(entry);
+	}
+
+	void DestroyQueue::destroy(const Entry &entry)
+	{
+		// only buffers and images carry memory
+		device->getMemoryTracker()->remove(entry.memory);
+
+		switch (entry.type)
+		{
+			case Type::BUFFER: vmaDestroyBuffer(device->getVRAMAllocator(), entry.buffer, entry.memory); break;
+			case Type::IMAGE: vmaDestroyImage(device->getVRAMAllocator(), entry.image, entry.memory); break;
+			case Type::IMAGE_VIEWS: delete entry.image_view_cache; break;
+			case Type::FRAME_BUFFER: vkDestroyFramebuffer(device->getDevice(), entry.frame_buffer, nullptr); break;
+			case Type::RENDER_PASS: vkDestroyRenderPass(device->getDevice(), entry.render_pass, nullptr); break;
+			case Type::SHADER_MODULE: vkDestroyShaderModule(device->getDevice(), entry.shader_module, nullptr); break;
+			case Type::PIPELINE: vkDestroyPipeline(device->getDevice(), entry.pipeline, nullptr); break;
+			case Type::QUERY_POOL: vkDestroyQueryPool(device->getDevice(), entry.query_pool, nullptr); break;
+			case Type::DEFRAGMENTATION: vmaDefragmentationEnd(device->getVRAMAllocator(), entry.defragmentation_context); break;
+			default: assert(false && "Unknown object type"); break;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+	class ImageViewCache;
+	class SubmitTracker;
+
+	/*
+	 * Destroys objects once all work recorded before their destruction is complete.
+	 * Objects are queued with the current submit serial and retired after each submit,
+	 * so callers don't need to wait for the device before releasing resources.
+	 * Objects may be queued from loader threads.
+	 */
+	class DestroyQueue
+	{
+	public:
+		DestroyQueue(const Device *device, SubmitTracker *submit_tracker)
+			: device(device), submit_tracker(submit_tracker) { }
+		~DestroyQueue();
+
+		void destroyBuffer(VkBuffer buffer, VmaAllocation memory);
+		void destroyImage(VkImage image, VmaAllocation memory);
+		void destroyImageViews(ImageViewCache *image_view_cache);
+		void destroyFrameBuffer(VkFramebuffer frame_buffer);
+		void destroyRenderPass(VkRenderPass render_pass);
+		void destroyShaderModule(VkShaderModule shader_module);
+		void destroyPipeline(VkPipeline pipeline);
+		void destroyQueryPool(VkQueryPool query_pool);
+		void endDefragmentation(VmaDefragmentationContext context);
+
+		void retire();
+		uint32_t getNumPending() const;
+
+	private:
+		enum class Type : uint8_t
+		{
+			BUFFER = 0,
+			IMAGE,
+			IMAGE_VIEWS,
+			FRAME_BUFFER,
+			RENDER_PASS,
+			SHADER_MODULE,
+			PIPELINE,
+			QUERY_POOL,
+			DEFRAGMENTATION,
+		};
+
+		struct Entry
+		{
+			uint64_t serial {0};
+			Type type {Type::BUFFER};
+			VmaAllocation memory {VK_NULL_HANDLE};
+
+			union
+			{
+				VkBuffer buffer;
+				VkImage image;
+				ImageViewCache *image_view_cache;
+				VkFramebuffer frame_buffer;
+				VkRenderPass render_pass;
+				VkShaderModule shader_module;
+				VkPipeline pipeline;
+				VkQueryPool query_pool;
+				VmaDefragmentationContext defragmentation_context;
+			};
+		};
+
+		void push(Entry &entry);
+		void destroy(const Entry &entry);
+
+	private:
+		const Device *device {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+
+		std::deque<Entry> entries;
+		mutable std::mutex mutex;
+	};
+}
@@ -0,0 +1,163 @@
+#include "render/backend/vulkan/FrameBufferCache.h"
+#include "render/backend/vulkan/DestroyQueue.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/Driver.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	template <class T>
+	static void hashCombine(uint64_t &s, const T &v)
+	{
+		std::hash<T> h;
+		s^= h(v) + 0x9e3779b9 + (s<< 6) + (s>> 2);
+	}
+
+	/*
+	 */
+	FrameBufferCache::~FrameBufferCache()
+	{
+		clear();
+	}
+
+	/*
+	 */
+	VkFramebuffer FrameBufferCache::fetch(const RenderPass *render_pass, const FrameBuffer *frame_buffer)
+	{
+		assert(render_pass);
+		assert(frame_buffer);
+		assert(render_pass->num_attachments == frame_buffer->num_attachments && "Frame buffer is not compatible with render pass");
+
+		uint64_t hash = getHash(render_pass, frame_buffer);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = cache.find(hash);
+		if (it != cache.end())
+			return it->second.frame_buffer;
+
+		// any render pass compatible with the cached one can use the framebuffer
+		VkFramebufferCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		info.renderPass = render_pass->render_pass;
+		info.attachmentCount = frame_buffer->num_attachments;
+		info.pAttachments = frame_buffer->attachment_views;
+		info.width = frame_buffer->sizes.width;
+		info.height = frame_buffer->sizes.height;
+		info.layers = 1;
+
+		Entry entry;
+		if (vkCreateFramebuffer(device->getDevice(), &info, nullptr, &entry.frame_buffer) != VK_SUCCESS)
+		{
+			std::cerr << "FrameBufferCache::fetch(): can't create framebuffer, " << cache.size() << " framebuffers are alive" << std::endl;
+			return VK_NULL_HANDLE;
+		}
+
+		entry.num_images = frame_buffer->num_attachments;
+		for (uint32_t i = 0; i < frame_buffer->num_attachments; ++i)
+			entry.images[i] = frame_buffer->attachment_images[i];
+
+		cache[hash] = entry;
+		return entry.frame_buffer;
+	}
+
+	void FrameBufferCache::evict(VkImage image)
+	{
+		if (image == VK_NULL_HANDLE)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto it = cache.begin(); it != cache.end(); )
+		{
+			const Entry &entry = it->second;
+
+			bool referenced = false;
+			for (uint32_t i = 0; i < entry.num_images && !referenced; ++i)
+				referenced = (entry.images[i] == image);
+
+			if (!referenced)
+			{
+				++it;
+				continue;
+			}
+
+			destroy_queue->destroyFrameBuffer(entry.frame_buffer);
+			it = cache.erase(it);
+		}
+	}
+
+	void FrameBufferCache::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto it = cache.begin(); it != cache.end(); ++it)
+			destroy_queue->destroyFrameBuffer(it->second.frame_buffer);
+
+		cache.clear();
+	}
+
+	uint32_t FrameBufferCache::getNumFrameBuffers() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(cache.size());
+	}
+
+	/*
+	 */
+	uint64_t FrameBufferCache::getCompatibilityHash(const RenderPass *render_pass, uint32_t num_subpasses, const RenderPassDescription *subpasses)
+	{
+		assert(render_pass);
+		assert(subpasses);
+
+		// load / store ops and layouts don't affect render pass compatibility
+		uint64_t hash = 0;
+
+		hashCombine(hash, render_pass->num_attachments);
+		for (uint32_t i = 0; i < render_pass->num_attachments; ++i)
+		{
+			hashCombine(hash, render_pass->attachment_formats[i]);
+			hashCombine(hash, render_pass->attachment_samples[i]);
+		}
+
+		hashCombine(hash, num_subpasses);
+		for (uint32_t subpass = 0; subpass < num_subpasses; ++subpass)
+		{
+			const RenderPassDescription &description = subpasses[subpass];
+
+			hashCombine(hash, description.num_color_attachments);
+			for (uint32_t i = 0; i < description.num_color_attachments; ++i)
+			{
+				hashCombine(hash, description.color_attachments[i]);
+
+				if (description.resolve_attachments)
+					hashCombine(hash, description.resolve_attachments[i]);
+			}
+
+			if (description.depthstencil_attachment)
+				hashCombine(hash, *description.depthstencil_attachment);
+
+			hashCombine(hash, description.num_input_attachments);
+			for (uint32_t i = 0; i < description.num_input_attachments; ++i)
+				hashCombine(hash, description.input_attachments[i]);
+		}
+
+		return hash;
+	}
+
+	uint64_t FrameBufferCache::getHash(const RenderPass *render_pass, const FrameBuffer *frame_buffer) const
+	{
+		uint64_t hash = 0;
+
+		hashCombine(hash, render_pass->compatibility_hash);
+		hashCombine(hash, frame_buffer->sizes.width);
+		hashCombine(hash, frame_buffer->sizes.height);
+
+		for (uint32_t i = 0; i < frame_buffer->num_attachments; ++i)
+			hashCombine(hash, frame_buffer->attachment_views[i]);
+
+		return hash;
+	}
+}
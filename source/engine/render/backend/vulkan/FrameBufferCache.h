@@ -0,0 +1,58 @@
+#pragma once
+
+#include <render/backend/Driver.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <volk.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+	class DestroyQueue;
+	struct FrameBuffer;
+	struct RenderPass;
+
+	/*
+	 * Shares framebuffers between frame buffers with the same attachment views & extent used
+	 * with compatible render passes. Framebuffers are evicted once an image they reference
+	 * is destroyed. Textures may be destroyed from loader threads.
+	 */
+	class FrameBufferCache
+	{
+	public:
+		FrameBufferCache(const Device *device, DestroyQueue *destroy_queue)
+			: device(device), destroy_queue(destroy_queue) { }
+		~FrameBufferCache();
+
+		VkFramebuffer fetch(const RenderPass *render_pass, const FrameBuffer *frame_buffer);
+		void evict(VkImage image);
+		void clear();
+
+		uint32_t getNumFrameBuffers() const;
+
+		static uint64_t getCompatibilityHash(const RenderPass *render_pass, uint32_t num_subpasses, const RenderPassDescription *subpasses);
+
+	private:
+		enum
+		{
+			MAX_ATTACHMENTS = 16,
+		};
+
+		struct Entry
+		{
+			VkFramebuffer frame_buffer {VK_NULL_HANDLE};
+			uint32_t num_images {0};
+			VkImage images[MAX_ATTACHMENTS];
+		};
+
+		uint64_t getHash(const RenderPass *render_pass, const FrameBuffer *frame_buffer) const;
+
+	private:
+		const Device *device {nullptr};
+		DestroyQueue *destroy_queue {nullptr};
+
+		std::unordered_map<uint64_t, Entry> cache;
+		mutable std::mutex mutex;
+	};
+}
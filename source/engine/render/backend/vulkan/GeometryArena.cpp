@@ -0,0 +1,360 @@
+#include "render/backend/vulkan/GeometryArena.h"
+#include "render/backend/vulkan/DestroyQueue.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/MemoryTracker.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+#include "render/backend/vulkan/UploadContext.h"
+#include "render/backend/vulkan/Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	void GeometryArena::RangeHeap::reset(uint32_t new_capacity, uint32_t num_used)
+	{
+		assert(num_used <= new_capacity);
+
+		capacity = new_capacity;
+		free_ranges.clear();
+
+		if (num_used < capacity)
+			free_ranges[num_used] = capacity - num_used;
+	}
+
+	bool GeometryArena::RangeHeap::allocate(uint32_t size, uint32_t &offset)
+	{
+		for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it)
+		{
+			if (it->second < size)
+				continue;
+
+			offset = it->first;
+
+			uint32_t remaining = it->second - size;
+			free_ranges.erase(it);
+
+			if (remaining > 0)
+				free_ranges[offset + size] = remaining;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void GeometryArena::RangeHeap::free(uint32_t offset, uint32_t size)
+	{
+		auto it = free_ranges.emplace(offset, size).first;
+
+		// merge with neighbours
+		auto next = std::next(it);
+		if (next != free_ranges.end() && it->first + it->second == next->first)
+		{
+			it->second += next->second;
+			free_ranges.erase(next);
+		}
+
+		if (it != free_ranges.begin())
+		{
+			auto prev = std::prev(it);
+			if (prev->first + prev->second == it->first)
+			{
+				prev->second += it->second;
+				free_ranges.erase(it);
+			}
+		}
+	}
+
+	/*
+	 */
+	GeometryArena::GeometryArena(
+		const Device *device,
+		SubmitTracker *submit_tracker,
+		DestroyQueue *destroy_queue,
+		uint16_t vertex_size,
+		uint8_t num_attributes,
+		const VertexAttribute *attributes,
+		IndexFormat index_format,
+		uint32_t num_vertices,
+		uint32_t num_indices
+	)
+		: device(device), submit_tracker(submit_tracker), destroy_queue(destroy_queue), index_size(Utils::getIndexSize(index_format))
+	{
+		assert(num_vertices != 0 && "Invalid vertex count");
+		assert(num_indices != 0 && "Invalid index count");
+		assert(vertex_size != 0 && "Invalid vertex size");
+		assert(num_attributes <= VertexBuffer::MAX_ATTRIBUTES && "Vertex attributes are limited to 16");
+
+		vertex_buffer.type = BufferType::STATIC;
+		vertex_buffer.vertex_size = vertex_size;
+		vertex_buffer.num_vertices = num_vertices;
+		vertex_buffer.num_attributes = num_attributes;
+
+		for (uint8_t i = 0; i < num_attributes; ++i)
+		{
+			vertex_buffer.attribute_formats[i] = Utils::getFormat(attributes[i].format);
+			vertex_buffer.attribute_offsets[i] = attributes[i].offset;
+		}
+
+		index_buffer.type = BufferType::STATIC;
+		index_buffer.index_type = Utils::getIndexType(index_format);
+		index_buffer.num_indices = num_indices;
+
+		createBuffer(static_cast<VkDeviceSize>(vertex_size) * num_vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer.buffer, vertex_buffer.memory);
+		createBuffer(static_cast<VkDeviceSize>(index_size) * num_indices, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer.buffer, index_buffer.memory);
+
+		vertex_heap.reset(num_vertices, 0);
+		index_heap.reset(num_indices, 0);
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+		pending_frees.clear();
+
+		destroy_queue->destroyBuffer(vertex_buffer.buffer, vertex_buffer.memory);
+		vertex_buffer.buffer = VK_NULL_HANDLE;
+		vertex_buffer.memory = VK_NULL_HANDLE;
+
+		destroy_queue->destroyBuffer(index_buffer.buffer, index_buffer.memory);
+		index_buffer.buffer = VK_NULL_HANDLE;
+		index_buffer.memory = VK_NULL_HANDLE;
+
+		for (GeometryAllocation *allocation : allocations)
+			delete allocation;
+
+		allocations.clear();
+	}
+
+	/*
+	 */
+	GeometryAllocation *GeometryArena::allocate(
+		UploadContext *upload_context,
+		uint32_t num_vertices,
+		const void *vertices,
+		uint32_t num_indices,
+		const void *indices
+	)
+	{
+		assert(num_vertices != 0 && "Invalid vertex count");
+		assert(num_indices != 0 && "Invalid index count");
+
+		std::lock_guard<std::mutex> lock(mutex);
+		retire();
+
+		uint32_t first_vertex = 0;
+		uint32_t first_index = 0;
+
+		bool allocated = vertex_heap.allocate(num_vertices, first_vertex);
+		if (allocated && !index_heap.allocate(num_indices, first_index))
+		{
+			vertex_heap.free(first_vertex, num_vertices);
+			allocated = false;
+		}
+
+		if (!allocated)
+		{
+			// compaction alone is enough if live geometry still fits
+			uint32_t vertex_capacity = vertex_heap.capacity;
+			uint32_t index_capacity = index_heap.capacity;
+
+			if (num_used_vertices + num_vertices > vertex_capacity)
+				vertex_capacity = std::max(vertex_capacity * 2, num_used_vertices + num_vertices);
+
+			if (num_used_indices + num_indices > index_capacity)
+				index_capacity = std::max(index_capacity * 2, num_used_indices + num_indices);
+
+			rebuild(upload_context, vertex_capacity, index_capacity);
+
+			allocated = vertex_heap.allocate(num_vertices, first_vertex) && index_heap.allocate(num_indices, first_index);
+			if (!allocated)
+			{
+				std::cerr << "GeometryArena::allocate(): can't allocate " << num_vertices << " vertices and " << num_indices << " indices" << std::endl;
+				return nullptr;
+			}
+		}
+
+		VkDeviceSize vertex_size = vertex_buffer.vertex_size;
+
+		upload_context->beginBatch();
+
+		if (vertices)
+			upload_context->fillBufferRange(vertex_buffer.buffer, vertex_size * first_vertex, vertex_size * num_vertices, vertices);
+
+		if (indices)
+			upload_context->fillBufferRange(index_buffer.buffer, index_size * first_index, index_size * num_indices, indices);
+
+		upload_context->endBatch();
+
+		GeometryAllocation *result = new GeometryAllocation();
+		result->first_vertex = first_vertex;
+		result->num_vertices = num_vertices;
+		result->first_index = first_index;
+		result->num_indices = num_indices;
+		result->index = static_cast<uint32_t>(allocations.size());
+
+		allocations.push_back(result);
+
+		num_used_vertices += num_vertices;
+		num_used_indices += num_indices;
+
+		return result;
+	}
+
+	void GeometryArena::free(GeometryAllocation *allocation)
+	{
+		if (allocation == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(allocation->index < allocations.size() && allocations[allocation->index] == allocation && "Allocation doesn't belong to this arena");
+
+		// frames recorded so far may still read these ranges
+		PendingFree pending;
+		pending.serial = submit_tracker->getCurrentSerial();
+		pending.first_vertex = allocation->first_vertex;
+		pending.num_vertices = allocation->num_vertices;
+		pending.first_index = allocation->first_index;
+		pending.num_indices = allocation->num_indices;
+
+		pending_frees.push_back(pending);
+
+		num_used_vertices -= allocation->num_vertices;
+		num_used_indices -= allocation->num_indices;
+
+		GeometryAllocation *last = allocations.back();
+		allocations[allocation->index] = last;
+		last->index = allocation->index;
+		allocations.pop_back();
+
+		delete allocation;
+
+		retire();
+	}
+
+	void GeometryArena::compact(UploadContext *upload_context)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		rebuild(upload_context, vertex_heap.capacity, index_heap.capacity);
+	}
+
+	/*
+	 */
+	GeometryRange GeometryArena::getRange(const GeometryAllocation *allocation) const
+	{
+		assert(allocation != nullptr && "Invalid allocation");
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		GeometryRange result;
+		result.vertex_buffer = const_cast<VertexBuffer *>(&vertex_buffer);
+		result.index_buffer = const_cast<IndexBuffer *>(&index_buffer);
+		result.first_index = allocation->first_index;
+		result.num_indices = allocation->num_indices;
+		result.vertex_offset = static_cast<int32_t>(allocation->first_vertex);
+		result.num_vertices = allocation->num_vertices;
+
+		return result;
+	}
+
+	/*
+	 */
+	void GeometryArena::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VmaAllocation &memory)
+	{
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = size;
+		buffer_info.usage = usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo alloc_info = {};
+		alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		VkResult result = vmaCreateBuffer(device->getVRAMAllocator(), &buffer_info, &alloc_info, &buffer, &memory, nullptr);
+		assert((result == VK_SUCCESS) && "Can't create geometry arena buffer");
+
+		device->getMemoryTracker()->add(memory, MemoryCategory::GEOMETRY);
+	}
+
+	void GeometryArena::rebuild(UploadContext *upload_context, uint32_t vertex_capacity, uint32_t index_capacity)
+	{
+		VkDeviceSize vertex_size = vertex_buffer.vertex_size;
+
+		VkBuffer new_vertex_buffer = VK_NULL_HANDLE;
+		VmaAllocation new_vertex_memory = VK_NULL_HANDLE;
+		createBuffer(vertex_size * vertex_capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, new_vertex_buffer, new_vertex_memory);
+
+		VkBuffer new_index_buffer = VK_NULL_HANDLE;
+		VmaAllocation new_index_memory = VK_NULL_HANDLE;
+		createBuffer(static_cast<VkDeviceSize>(index_size) * index_capacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, new_index_buffer, new_index_memory);
+
+		// pack live allocations in order, indices are vertex relative and stay valid
+		std::vector<VkBufferCopy> vertex_regions(allocations.size());
+		std::vector<VkBufferCopy> index_regions(allocations.size());
+
+		uint32_t num_vertices = 0;
+		uint32_t num_indices = 0;
+
+		for (size_t i = 0; i < allocations.size(); ++i)
+		{
+			GeometryAllocation *allocation = allocations[i];
+
+			VkBufferCopy &vertex_region = vertex_regions[i];
+			vertex_region.srcOffset = vertex_size * allocation->first_vertex;
+			vertex_region.dstOffset = vertex_size * num_vertices;
+			vertex_region.size = vertex_size * allocation->num_vertices;
+
+			VkBufferCopy &index_region = index_regions[i];
+			index_region.srcOffset = static_cast<VkDeviceSize>(index_size) * allocation->first_index;
+			index_region.dstOffset = static_cast<VkDeviceSize>(index_size) * num_indices;
+			index_region.size = static_cast<VkDeviceSize>(index_size) * allocation->num_indices;
+
+			allocation->first_vertex = num_vertices;
+			allocation->first_index = num_indices;
+
+			num_vertices += allocation->num_vertices;
+			num_indices += allocation->num_indices;
+		}
+
+		upload_context->beginBatch();
+		upload_context->copyBuffer(vertex_buffer.buffer, new_vertex_buffer, static_cast<uint32_t>(vertex_regions.size()), vertex_regions.data());
+		upload_context->copyBuffer(index_buffer.buffer, new_index_buffer, static_cast<uint32_t>(index_regions.size()), index_regions.data());
+		upload_context->endBatch();
+
+		// frames recorded so far still bind old buffers
+		destroy_queue->destroyBuffer(vertex_buffer.buffer, vertex_buffer.memory);
+		destroy_queue->destroyBuffer(index_buffer.buffer, index_buffer.memory);
+
+		vertex_buffer.buffer = new_vertex_buffer;
+		vertex_buffer.memory = new_vertex_memory;
+		vertex_buffer.num_vertices = vertex_capacity;
+
+		index_buffer.buffer = new_index_buffer;
+		index_buffer.memory = new_index_memory;
+		index_buffer.num_indices = index_capacity;
+
+		vertex_heap.reset(vertex_capacity, num_vertices);
+		index_heap.reset(index_capacity, num_indices);
+
+		// freed ranges only existed in old buffers
+		pending_frees.clear();
+	}
+
+	void GeometryArena::retire()
+	{
+		while (!pending_frees.empty())
+		{
+			const PendingFree &pending = pending_frees.front();
+			if (!submit_tracker->isComplete(pending.serial))
+				break;
+
+			vertex_heap.free(pending.first_vertex, pending.num_vertices);
+			index_heap.free(pending.first_index, pending.num_indices);
+			pending_frees.pop_front();
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "render/backend/vulkan/Driver.h"
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace render::backend::vulkan
+{
+	class DestroyQueue;
+	class Device;
+	class SubmitTracker;
+	class UploadContext;
+
+	struct GeometryAllocation : public render::backend::GeometryAllocation
+	{
+		uint32_t first_vertex {0};
+		uint32_t num_vertices {0};
+		uint32_t first_index {0};
+		uint32_t num_indices {0};
+		uint32_t index {0}; // position in the arena allocation list
+	};
+
+	/*
+	 * Suballocates static geometry from a single device local vertex & index buffer pair.
+	 * Freed ranges are reused once frames recorded so far are complete. Running out of space
+	 * compacts live allocations into new buffers on the GPU, growing them if needed.
+	 * Allocations may come from loader threads, but growth only sees uploads of the calling thread.
+	 */
+	class GeometryArena : public render::backend::GeometryArena
+	{
+	public:
+		GeometryArena(
+			const Device *device,
+			SubmitTracker *submit_tracker,
+			DestroyQueue *destroy_queue,
+			uint16_t vertex_size,
+			uint8_t num_attributes,
+			const VertexAttribute *attributes,
+			IndexFormat index_format,
+			uint32_t num_vertices,
+			uint32_t num_indices
+		);
+		~GeometryArena();
+
+		GeometryAllocation *allocate(
+			UploadContext *upload_context,
+			uint32_t num_vertices,
+			const void *vertices,
+			uint32_t num_indices,
+			const void *indices
+		);
+
+		void free(GeometryAllocation *allocation);
+		void compact(UploadContext *upload_context);
+
+		GeometryRange getRange(const GeometryAllocation *allocation) const;
+
+	private:
+		struct RangeHeap
+		{
+			uint32_t capacity {0};
+			std::map<uint32_t, uint32_t> free_ranges; // offset -> size
+
+			void reset(uint32_t new_capacity, uint32_t num_used);
+			bool allocate(uint32_t size, uint32_t &offset);
+			void free(uint32_t offset, uint32_t size);
+		};
+
+		struct PendingFree
+		{
+			uint64_t serial {0};
+			uint32_t first_vertex {0};
+			uint32_t num_vertices {0};
+			uint32_t first_index {0};
+			uint32_t num_indices {0};
+		};
+
+		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VmaAllocation &memory);
+		void rebuild(UploadContext *upload_context, uint32_t vertex_capacity, uint32_t index_capacity);
+		void retire();
+
+	private:
+		const Device *device {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+		DestroyQueue *destroy_queue {nullptr};
+
+		VertexBuffer vertex_buffer;
+		IndexBuffer index_buffer;
+		uint32_t index_size {0};
+
+		RangeHeap vertex_heap;
+		RangeHeap index_heap;
+		uint32_t num_used_vertices {0};
+		uint32_t num_used_indices {0};
+
+		std::vector<GeometryAllocation *> allocations;
+		std::deque<PendingFree> pending_frees;
+		mutable std::mutex mutex;
+	};
+}
@@ -182,7 +182,7 @@ namespace render::backend::vulkan
 
 	/*
 	 */
-	VkPipeline GraphicsPipelineBuilder::build(VkDevice device)
+	VkPipeline GraphicsPipelineBuilder::build(VkDevice device, VkPipelineCache pipeline_cache)
 	{
 		VkPipelineVertexInputStateCreateInfo vertex_input_state = {};
 		vertex_input_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -223,9 +223,10 @@ namespace render::backend::vulkan
 		info.pDynamicState = &dynamic_state;
 		info.layout = pipeline_layout;
 		info.renderPass = render_pass;
+		info.subpass = subpass;
 
 		VkPipeline result = VK_NULL_HANDLE;
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &result) != VK_SUCCESS)
+		if (vkCreateGraphicsPipelines(device, pipeline_cache, 1, &info, nullptr, &result) != VK_SUCCESS)
 		{
 			// TODO: log error "Can't create graphics pipeline"
 		}
@@ -10,8 +10,8 @@ namespace render::backend::vulkan
 	class GraphicsPipelineBuilder
 	{
 	public:
-		GraphicsPipelineBuilder(VkPipelineLayout pipeline_layout, VkRenderPass render_pass)
-			: render_pass(render_pass), pipeline_layout(pipeline_layout) { }
+		GraphicsPipelineBuilder(VkPipelineLayout pipeline_layout, VkRenderPass render_pass, uint32_t subpass = 0)
+			: render_pass(render_pass), subpass(subpass), pipeline_layout(pipeline_layout) { }
 
 		GraphicsPipelineBuilder &addShaderStage(
 			VkShaderModule shader,
@@ -41,7 +41,7 @@ namespace render::backend::vulkan
 			const VkRect2D &scissor
 		);
 
-		GraphicsPipelineBuilder &GraphicsPipelineBuilder::addBlendColorAttachment(
+		GraphicsPipelineBuilder &addBlendColorAttachment(
 			bool blend = false,
 			VkBlendFactor src_color_blend_factor = VK_BLEND_FACTOR_ONE,
 			VkBlendFactor dst_color_blend_factor = VK_BLEND_FACTOR_ONE,
@@ -77,10 +77,11 @@ namespace render::backend::vulkan
 			VkCompareOp depth_compare_op
 		);
 
-		VkPipeline build(VkDevice device);
+		VkPipeline build(VkDevice device, VkPipelineCache pipeline_cache = VK_NULL_HANDLE);
 
 	private:
 		VkRenderPass render_pass {VK_NULL_HANDLE};
+		uint32_t subpass {0};
 		VkPipelineLayout pipeline_layout {VK_NULL_HANDLE};
 
 		std::vector<VkPipelineShaderStageCreateInfo> shader_stages;
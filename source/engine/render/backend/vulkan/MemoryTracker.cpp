@@ -0,0 +1,62 @@
+#include "render/backend/vulkan/MemoryTracker.h"
+
+#include <cassert>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	void MemoryTracker::add(VmaAllocation allocation, MemoryCategory category)
+	{
+		if (allocation == VK_NULL_HANDLE)
+			return;
+
+		assert(category < MemoryCategory::MAX && "Invalid memory category");
+
+		// zero user data marks untracked allocations
+		uintptr_t user_data = static_cast<uintptr_t>(category) + 1;
+		vmaSetAllocationUserData(allocator, allocation, reinterpret_cast<void *>(user_data));
+
+		VmaAllocationInfo info = {};
+		vmaGetAllocationInfo(allocator, allocation, &info);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		MemoryCategoryStats &stats = categories[static_cast<uint32_t>(category)];
+		stats.bytes += info.size;
+		stats.num_allocations++;
+	}
+
+	void MemoryTracker::remove(VmaAllocation allocation)
+	{
+		if (allocation == VK_NULL_HANDLE)
+			return;
+
+		VmaAllocationInfo info = {};
+		vmaGetAllocationInfo(allocator, allocation, &info);
+
+		uintptr_t user_data = reinterpret_cast<uintptr_t>(info.pUserData);
+		if (user_data == 0)
+			return;
+
+		vmaSetAllocationUserData(allocator, allocation, nullptr);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		MemoryCategoryStats &stats = categories[user_data - 1];
+		assert(stats.num_allocations > 0 && stats.bytes >= info.size && "Memory category underflow");
+
+		stats.bytes -= info.size;
+		stats.num_allocations--;
+	}
+
+	void MemoryTracker::getStats(MemoryCategoryStats *stats) const
+	{
+		assert(stats != nullptr && "Invalid stats");
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryCategory::MAX); ++i)
+			stats[i] = categories[i];
+	}
+}
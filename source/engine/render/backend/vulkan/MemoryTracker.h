@@ -0,0 +1,35 @@
+#pragma once
+
+#include "render/backend/Driver.h"
+
+#include <mutex>
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+namespace render::backend::vulkan
+{
+	/*
+	 * Per category accounting of VMA allocations. The category is kept in the allocation
+	 * user data, so removing an allocation needs nothing but the allocation itself.
+	 * Allocations that were never added are ignored. Allocations may come from loader threads.
+	 */
+	class MemoryTracker
+	{
+	public:
+		MemoryTracker(VmaAllocator allocator)
+			: allocator(allocator) { }
+
+		void add(VmaAllocation allocation, MemoryCategory category);
+
+		// must be called before the allocation is freed
+		void remove(VmaAllocation allocation);
+
+		void getStats(MemoryCategoryStats *stats) const;
+
+	private:
+		VmaAllocator allocator {VK_NULL_HANDLE};
+
+		MemoryCategoryStats categories[static_cast<uint32_t>(MemoryCategory::MAX)];
+		mutable std::mutex mutex;
+	};
+}
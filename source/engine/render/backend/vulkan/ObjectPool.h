@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+
+namespace render::backend::vulkan
+{
+	/*
+	 * Typed slab allocator for driver objects. Objects live next to each other in fixed
+	 * size slabs and never move. The user gets 32-bit handles packing the slot index and
+	 * the slot generation, generation is bumped on free so debug builds catch stale handles.
+	 * Freed slots are reused in FIFO order to make generations wrap as late as possible.
+	 * Objects may be created from loader threads, handles are resolved without locking.
+	 */
+	template <typename T, uint32_t SLAB_SIZE = 64>
+	class ObjectPool
+	{
+	public:
+		ObjectPool() = default;
+		ObjectPool(const ObjectPool &) = delete;
+		ObjectPool &operator=(const ObjectPool &) = delete;
+
+		~ObjectPool()
+		{
+			for (uint32_t i = 0; i < num_slabs; ++i)
+			{
+				Slot *slab = slabs[i];
+
+				for (uint32_t j = 0; j < SLAB_SIZE; ++j)
+					if (slab[j].alive)
+						reinterpret_cast<T *>(slab[j].storage)->~T();
+
+				delete[] slab;
+				slabs[i] = nullptr;
+			}
+
+			num_slabs = 0;
+			free_slots.clear();
+		}
+
+		T *allocate()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (free_slots.empty())
+				addSlab();
+
+			Slot *slot = free_slots.front();
+			free_slots.pop_front();
+
+			slot->alive = true;
+			num_alive++;
+
+			return new (slot->storage) T();
+		}
+
+		void free(T *object)
+		{
+			if (object == nullptr)
+				return;
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			Slot *slot = getSlot(object);
+			assert(slot->alive && "Object is already destroyed");
+
+			object->~T();
+
+			// zero generation is skipped, handles are never null
+			uint8_t generation = slot->generation.load(std::memory_order_relaxed) + 1;
+			slot->generation.store((generation == 0) ? 1 : generation, std::memory_order_relaxed);
+
+			slot->alive = false;
+			num_alive--;
+
+			free_slots.push_back(slot);
+		}
+
+		template <typename Handle>
+		Handle *getHandle(const T *object) const
+		{
+			if (object == nullptr)
+				return nullptr;
+
+			const Slot *slot = getSlot(object);
+			uintptr_t handle = (static_cast<uintptr_t>(slot->index) << GENERATION_BITS) | slot->generation.load(std::memory_order_relaxed);
+
+			return reinterpret_cast<Handle *>(handle);
+		}
+
+		// the handle must come from this pool, stale handles assert in debug builds
+		T *get(const void *handle) const
+		{
+			if (handle == nullptr)
+				return nullptr;
+
+			uintptr_t value = reinterpret_cast<uintptr_t>(handle);
+			uint32_t index = static_cast<uint32_t>(value >> GENERATION_BITS);
+
+			assert(index < num_slabs * SLAB_SIZE && "Invalid handle");
+
+			Slot &slot = slabs[index / SLAB_SIZE][index % SLAB_SIZE];
+			assert(slot.generation.load(std::memory_order_relaxed) == (value & GENERATION_MASK) && "Object is destroyed");
+
+			return reinterpret_cast<T *>(slot.storage);
+		}
+
+		// only valid for objects that came from this pool
+		bool isAlive(const T *object) const
+		{
+			if (object == nullptr)
+				return false;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			return getSlot(object)->alive;
+		}
+
+		uint32_t getNumAlive() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return num_alive;
+		}
+
+		// func must not allocate or free objects from this pool
+		template <typename Func>
+		void forEach(Func func)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			for (uint32_t i = 0; i < num_slabs; ++i)
+				for (uint32_t j = 0; j < SLAB_SIZE; ++j)
+					if (slabs[i][j].alive)
+						func(reinterpret_cast<T *>(slabs[i][j].storage));
+		}
+
+	private:
+		enum : uint32_t
+		{
+			GENERATION_BITS = 8,
+			GENERATION_MASK = (1 << GENERATION_BITS) - 1,
+			MAX_SLABS = 4096,
+		};
+
+		static_assert(MAX_SLABS * SLAB_SIZE <= (1u << (32 - GENERATION_BITS)), "Slot index doesn't fit into a handle");
+
+		struct Slot
+		{
+			alignas(T) unsigned char storage[sizeof(T)];
+			uint32_t index {0};
+			std::atomic<uint8_t> generation {1};
+			bool alive {false};
+		};
+
+		static Slot *getSlot(const T *object)
+		{
+			// storage is the first member of a slot
+			return reinterpret_cast<Slot *>(const_cast<T *>(object));
+		}
+
+		void addSlab()
+		{
+			assert(num_slabs < MAX_SLABS && "Too many objects");
+
+			Slot *slab = new Slot[SLAB_SIZE];
+
+			for (uint32_t i = 0; i < SLAB_SIZE; ++i)
+			{
+				slab[i].index = num_slabs * SLAB_SIZE + i;
+				free_slots.push_back(&slab[i]);
+			}
+
+			// slabs never move, so handles are resolved without taking the mutex
+			slabs[num_slabs] = slab;
+			num_slabs++;
+		}
+
+	private:
+		Slot *slabs[MAX_SLABS] {};
+		std::atomic<uint32_t> num_slabs {0};
+		std::deque<Slot *> free_slots;
+		uint32_t num_alive {0};
+		mutable std::mutex mutex;
+	};
+}
@@ -1,6 +1,7 @@
 #include "render/backend/vulkan/PipelineCache.h"
 #include "render/backend/vulkan/PipelineLayoutCache.h"
 #include "render/backend/vulkan/GraphicsPipelineBuilder.h"
+#include "render/backend/vulkan/DestroyQueue.h"
 
 #include "render/backend/vulkan/Driver.h"
 #include "render/backend/vulkan/Device.h"
@@ -8,6 +9,9 @@
 
 #include <vector>
 #include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 
 namespace render::backend::vulkan
 {
@@ -48,12 +52,155 @@ namespace render::backend::vulkan
 		return supported_stages[static_cast<int>(type)];
 	};
 
+	// VkPipelineCacheHeaderVersionOne layout, see Vulkan spec
+	struct PipelineCacheHeader
+	{
+		uint32_t size;
+		uint32_t version;
+		uint32_t vendor_id;
+		uint32_t device_id;
+		uint8_t uuid[VK_UUID_SIZE];
+	};
+
+	/*
+	 */
+	PipelineCache::PipelineCache(const Device *device, PipelineLayoutCache *layout_cache, DestroyQueue *destroy_queue)
+		: device(device), layout_cache(layout_cache), destroy_queue(destroy_queue)
+	{
+		createPipelineCache(0, nullptr);
+	}
+
 	PipelineCache::~PipelineCache()
 	{
+		stopWorkers();
+		save();
+
 		clear();
+		destroyPipelineCache();
+	}
+
+	/*
+	 */
+	void PipelineCache::setCachePath(const char *path)
+	{
+		if (path == nullptr)
+		{
+			save();
+			cache_path.clear();
+			return;
+		}
+
+		if (cache_path == path)
+			return;
+
+		// workers must not use the pipeline cache object while it's being replaced
+		wait();
+
+		save();
+		cache_path = path;
+
+		std::vector<char> data;
+		std::ifstream file(cache_path, std::ios::ate | std::ios::binary);
+
+		if (file.is_open())
+		{
+			size_t size = static_cast<size_t>(file.tellg());
+			data.resize(size);
+
+			file.seekg(0);
+			file.read(data.data(), size);
+			file.close();
+		}
+
+		if (!data.empty() && !isCompatible(data.size(), data.data()))
+		{
+			std::cerr << "PipelineCache::setCachePath(): \"" << cache_path << "\" was created by another device or driver, ignoring" << std::endl;
+			data.clear();
+		}
+
+		// NOTE: already created pipelines stay valid, only the VkPipelineCache object is swapped
+		destroyPipelineCache();
+		createPipelineCache(data.size(), data.data());
+	}
+
+	bool PipelineCache::save() const
+	{
+		if (cache_path.empty() || pipeline_cache == VK_NULL_HANDLE)
+			return false;
+
+		size_t size = 0;
+		if (vkGetPipelineCacheData(device->getDevice(), pipeline_cache, &size, nullptr) != VK_SUCCESS)
+			return false;
+
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(device->getDevice(), pipeline_cache, &size, data.data()) != VK_SUCCESS)
+			return false;
+
+		std::ofstream file(cache_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "PipelineCache::save(): can't open \"" << cache_path << "\" for writing" << std::endl;
+			return false;
+		}
+
+		file.write(data.data(), size);
+		file.close();
+
+		return true;
+	}
+
+	/*
+	 */
+	void PipelineCache::createPipelineCache(size_t size, const void *data)
+	{
+		VkPipelineCacheCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		info.initialDataSize = size;
+		info.pInitialData = data;
+
+		if (vkCreatePipelineCache(device->getDevice(), &info, nullptr, &pipeline_cache) == VK_SUCCESS)
+			return;
+
+		// drivers may still reject data that passed the header check, start from scratch then
+		info.initialDataSize = 0;
+		info.pInitialData = nullptr;
+
+		if (vkCreatePipelineCache(device->getDevice(), &info, nullptr, &pipeline_cache) != VK_SUCCESS)
+		{
+			std::cerr << "PipelineCache::createPipelineCache(): can't create pipeline cache" << std::endl;
+			pipeline_cache = VK_NULL_HANDLE;
+		}
+	}
+
+	void PipelineCache::destroyPipelineCache()
+	{
+		vkDestroyPipelineCache(device->getDevice(), pipeline_cache, nullptr);
+		pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	bool PipelineCache::isCompatible(size_t size, const void *data) const
+	{
+		if (size < sizeof(PipelineCacheHeader))
+			return false;
+
+		PipelineCacheHeader header = {};
+		memcpy(&header, data, sizeof(PipelineCacheHeader));
+
+		if (header.size < sizeof(PipelineCacheHeader) || header.version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+			return false;
+
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+
+		if (header.vendor_id != properties.vendorID || header.device_id != properties.deviceID)
+			return false;
+
+		return memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
 	}
 
-	VkPipeline PipelineCache::fetch(VkPipelineLayout layout, const PipelineState *pipeline_state)
+	/*
+	 */
+	VkPipeline PipelineCache::fetch(VkPipelineLayout layout, const PipelineState *pipeline_state, bool blocking)
 	{
 		assert(layout != VK_NULL_HANDLE);
 		assert(pipeline_state);
@@ -61,16 +208,211 @@ namespace render::backend::vulkan
 
 		uint64_t hash = getHash(layout, pipeline_state);
 
-		auto it = cache.find(hash);
-		if (it != cache.end())
-			return it->second;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			auto it = cache.find(hash);
+			if (it != cache.end())
+				return it->second;
 
-		GraphicsPipelineBuilder builder(layout, pipeline_state->render_pass);
+			if (pending.find(hash) != pending.end())
+			{
+				if (!blocking)
+					return VK_NULL_HANDLE;
 
-		builder.addViewport(VkViewport());
-		builder.addScissor(VkRect2D());
-		builder.addDynamicState(VK_DYNAMIC_STATE_SCISSOR);
-		builder.addDynamicState(VK_DYNAMIC_STATE_VIEWPORT);
+				job_finished.wait(lock, [this, hash]() { return pending.find(hash) == pending.end(); });
+				return cache[hash];
+			}
+
+			// claim the hash, concurrent fetches wait for this build instead of starting their own
+			pending.insert(hash);
+		}
+
+		GraphicsPipelineBuilder *builder = createBuilder(layout, pipeline_state);
+
+		if (blocking || workers.empty())
+		{
+			VkPipeline result = builder->build(device->getDevice(), pipeline_cache);
+			delete builder;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				cache[hash] = result;
+				pending.erase(hash);
+			}
+
+			job_finished.notify_all();
+			return result;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back({hash, builder});
+		}
+
+		job_added.notify_one();
+		return VK_NULL_HANDLE;
+	}
+
+	VkPipeline PipelineCache::fetchCompute(VkPipelineLayout layout, VkShaderModule module)
+	{
+		assert(layout != VK_NULL_HANDLE);
+		assert(module != VK_NULL_HANDLE);
+
+		// compute pipelines are a single stage and cheap to build, always compiled in place
+		uint64_t hash = 0;
+		hashCombine(hash, layout);
+		hashCombine(hash, static_cast<uint8_t>(ShaderType::COMPUTE));
+		hashCombine(hash, module);
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			auto it = cache.find(hash);
+			if (it != cache.end())
+				return it->second;
+
+			if (pending.find(hash) != pending.end())
+			{
+				job_finished.wait(lock, [this, hash]() { return pending.find(hash) == pending.end(); });
+
+				// failed builds are not cached
+				it = cache.find(hash);
+				return (it != cache.end()) ? it->second : VK_NULL_HANDLE;
+			}
+
+			pending.insert(hash);
+		}
+
+		VkComputePipelineCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		info.stage.module = module;
+		info.stage.pName = "main";
+		info.layout = layout;
+
+		VkPipeline result = VK_NULL_HANDLE;
+		if (vkCreateComputePipelines(device->getDevice(), pipeline_cache, 1, &info, nullptr, &result) != VK_SUCCESS)
+		{
+			std::cerr << "PipelineCache::fetchCompute(): can't create compute pipeline" << std::endl;
+			result = VK_NULL_HANDLE;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (result != VK_NULL_HANDLE)
+				cache[hash] = result;
+
+			pending.erase(hash);
+		}
+
+		job_finished.notify_all();
+		return result;
+	}
+
+	void PipelineCache::clear()
+	{
+		wait();
+
+		// pipelines may still be referenced by submitted command buffers
+		for (auto it = cache.begin(); it != cache.end(); ++it)
+			destroy_queue->destroyPipeline(it->second);
+
+		cache.clear();
+	}
+
+	/*
+	 */
+	void PipelineCache::setAsync(bool enabled)
+	{
+		if (enabled == !workers.empty())
+			return;
+
+		if (!enabled)
+		{
+			stopWorkers();
+			return;
+		}
+
+		uint32_t num_threads = std::thread::hardware_concurrency();
+		uint32_t num_workers = (num_threads > 2) ? num_threads - 1 : 1;
+
+		stop_workers = false;
+		for (uint32_t i = 0; i < num_workers; ++i)
+			workers.emplace_back(&PipelineCache::workerLoop, this);
+	}
+
+	uint32_t PipelineCache::getNumPendingPipelines() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(pending.size());
+	}
+
+	void PipelineCache::wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		job_finished.wait(lock, [this]() { return pending.empty(); });
+	}
+
+	/*
+	 */
+	void PipelineCache::stopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop_workers = true;
+		}
+
+		job_added.notify_all();
+
+		for (std::thread &worker : workers)
+			worker.join();
+
+		workers.clear();
+	}
+
+	void PipelineCache::workerLoop()
+	{
+		while (true)
+		{
+			CompileJob job;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				job_added.wait(lock, [this]() { return stop_workers || !jobs.empty(); });
+
+				// drain the queue before exiting, so nobody waits on a pipeline forever
+				if (jobs.empty())
+					return;
+
+				job = jobs.front();
+				jobs.pop_front();
+			}
+
+			VkPipeline result = job.builder->build(device->getDevice(), pipeline_cache);
+			delete job.builder;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				cache[job.hash] = result;
+				pending.erase(job.hash);
+			}
+
+			job_finished.notify_all();
+		}
+	}
+
+	/*
+	 */
+	GraphicsPipelineBuilder *PipelineCache::createBuilder(VkPipelineLayout layout, const PipelineState *pipeline_state) const
+	{
+		GraphicsPipelineBuilder *builder = new GraphicsPipelineBuilder(layout, pipeline_state->render_pass, pipeline_state->subpass);
+
+		builder->addViewport(VkViewport());
+		builder->addScissor(VkRect2D());
+		builder->addDynamicState(VK_DYNAMIC_STATE_SCISSOR);
+		builder->addDynamicState(VK_DYNAMIC_STATE_VIEWPORT);
 
 		for (uint8_t i = 0; i < static_cast<uint8_t>(ShaderType::MAX); ++i)
 		{
@@ -78,7 +420,7 @@ namespace render::backend::vulkan
 			if (module == VK_NULL_HANDLE)
 				continue;
 
-			builder.addShaderStage(module, toShaderStage(static_cast<ShaderType>(i)));
+			builder->addShaderStage(module, toShaderStage(static_cast<ShaderType>(i)));
 		}
 
 		uint32_t attribute_location = 0;
@@ -92,22 +434,22 @@ namespace render::backend::vulkan
 			for (uint8_t j = 0; j < vertex_buffer->num_attributes; ++j)
 				attributes[j] = { attribute_location++, i, vertex_buffer->attribute_formats[j], vertex_buffer->attribute_offsets[j] };
 
-			builder.addVertexInput(input_binding, attributes);
+			builder->addVertexInput(input_binding, attributes);
 		}
 
-		builder.setInputAssemblyState(pipeline_state->primitive_topology);
+		builder->setInputAssemblyState(pipeline_state->primitive_topology);
 
-		builder.setRasterizerState(false, false, VK_POLYGON_MODE_FILL, 1.0f, pipeline_state->cull_mode, VK_FRONT_FACE_COUNTER_CLOCKWISE);
-		builder.setDepthStencilState(pipeline_state->depth_test, pipeline_state->depth_write, pipeline_state->depth_compare_func);
+		builder->setRasterizerState(false, false, VK_POLYGON_MODE_FILL, 1.0f, pipeline_state->cull_mode, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+		builder->setDepthStencilState(pipeline_state->depth_test, pipeline_state->depth_write, pipeline_state->depth_compare_func);
 
-		builder.setMultisampleState(pipeline_state->max_samples, true);
+		builder->setMultisampleState(pipeline_state->max_samples, true);
 
 		bool blending_enabled = pipeline_state->blending;
 		VkBlendFactor src_factor = pipeline_state->blend_src_factor;
 		VkBlendFactor dst_factor = pipeline_state->blend_dst_factor;
 
 		for (uint8_t i = 0; i < pipeline_state->num_color_attachments; ++i)
-			builder.addBlendColorAttachment(
+			builder->addBlendColorAttachment(
 				blending_enabled,
 				src_factor,
 				dst_factor,
@@ -115,18 +457,7 @@ namespace render::backend::vulkan
 				src_factor,
 				dst_factor);
 
-		VkPipeline result = builder.build(device->getDevice());
-
-		cache[hash] = result;
-		return result;
-	}
-
-	void PipelineCache::clear()
-	{
-		for (auto it = cache.begin(); it != cache.end(); ++it)
-			vkDestroyPipeline(device->getDevice(), it->second, nullptr);
-
-		cache.clear();
+		return builder;
 	}
 
 	uint64_t PipelineCache::getHash(VkPipelineLayout layout, const PipelineState *pipeline_state) const
@@ -136,6 +467,7 @@ namespace render::backend::vulkan
 		uint64_t hash = 0;
 		hashCombine(hash, layout);
 		hashCombine(hash, pipeline_state->render_pass);
+		hashCombine(hash, pipeline_state->subpass);
 
 		for (uint8_t i = 0; i < pipeline_state->num_vertex_streams; ++i)
 		{
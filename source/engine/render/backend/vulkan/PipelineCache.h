@@ -1,6 +1,13 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <volk.h>
 
 namespace render::backend
@@ -11,7 +18,9 @@ namespace render::backend
 namespace render::backend::vulkan
 {
 	class PipelineLayoutCache;
+	class GraphicsPipelineBuilder;
 	class Device;
+	class DestroyQueue;
 	struct PipelineState;
 
 	/*
@@ -19,20 +28,55 @@ namespace render::backend::vulkan
 	class PipelineCache
 	{
 	public:
-		PipelineCache(const Device *device, PipelineLayoutCache *layout_cache)
-			: device(device), layout_cache(layout_cache) { }
+		PipelineCache(const Device *device, PipelineLayoutCache *layout_cache, DestroyQueue *destroy_queue);
 		~PipelineCache();
 
-		VkPipeline fetch(VkPipelineLayout layout, const PipelineState *pipeline_state);
+		VkPipeline fetch(VkPipelineLayout layout, const PipelineState *pipeline_state, bool blocking = true);
+		VkPipeline fetchCompute(VkPipelineLayout layout, VkShaderModule module);
 		void clear();
 
+		void setAsync(bool enabled);
+		inline bool isAsync() const { return !workers.empty(); }
+		uint32_t getNumPendingPipelines() const;
+		void wait();
+
+		void setCachePath(const char *path);
+		bool save() const;
+
 	private:
+		struct CompileJob
+		{
+			uint64_t hash {0};
+			GraphicsPipelineBuilder *builder {nullptr};
+		};
+
 		uint64_t getHash(VkPipelineLayout layout, const PipelineState *pipeline_state) const;
+		GraphicsPipelineBuilder *createBuilder(VkPipelineLayout layout, const PipelineState *pipeline_state) const;
+
+		void stopWorkers();
+		void workerLoop();
+
+		void createPipelineCache(size_t size, const void *data);
+		void destroyPipelineCache();
+		bool isCompatible(size_t size, const void *data) const;
 
 	private:
 		const Device *device {nullptr};
 		PipelineLayoutCache *layout_cache {nullptr};
+		DestroyQueue *destroy_queue {nullptr};
+
+		VkPipelineCache pipeline_cache {VK_NULL_HANDLE};
+		std::string cache_path;
 
 		std::unordered_map<uint64_t, VkPipeline> cache;
+
+		// async compilation
+		mutable std::mutex mutex;
+		std::condition_variable job_added;
+		std::condition_variable job_finished;
+		std::deque<CompileJob> jobs;
+		std::unordered_set<uint64_t> pending; // being built, in place or by workers
+		std::vector<std::thread> workers;
+		bool stop_workers {false};
 	};
 }
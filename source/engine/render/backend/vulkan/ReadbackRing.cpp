@@ -0,0 +1,255 @@
+#include "render/backend/vulkan/ReadbackRing.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/MemoryTracker.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	ReadbackRing::~ReadbackRing()
+	{
+		if (buffer == VK_NULL_HANDLE)
+			return;
+
+		// copies recorded into command buffers that were never submitted don't touch the buffer
+		for (auto it = readbacks.rbegin(); it != readbacks.rend(); ++it)
+		{
+			if (it->serial >= submit_tracker->getCurrentSerial())
+				continue;
+
+			submit_tracker->wait(it->serial);
+			break;
+		}
+
+		readbacks.clear();
+
+		device->getMemoryTracker()->remove(memory);
+		vmaDestroyBuffer(device->getVRAMAllocator(), buffer, memory);
+
+		buffer = VK_NULL_HANDLE;
+		memory = VK_NULL_HANDLE;
+		data = nullptr;
+	}
+
+	/*
+	 */
+	uint64_t ReadbackRing::allocate(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &result_buffer, VkDeviceSize &result_offset)
+	{
+		assert(size != 0 && "Invalid size");
+
+		if (size >= capacity)
+		{
+			std::cerr << "ReadbackRing::allocate(): readback of " << size << " bytes doesn't fit into " << capacity << " bytes" << std::endl;
+			return 0;
+		}
+
+		if (buffer == VK_NULL_HANDLE && !createBuffer())
+			return 0;
+
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+
+		retire();
+
+		VkDeviceSize offset = 0;
+		bool allocated = tryAllocate(size, alignment, offset);
+
+		// ring is full, released readbacks may still be in flight
+		while (!allocated && !readbacks.empty())
+		{
+			const Readback &oldest = readbacks.front();
+			if (!oldest.released || oldest.serial >= submit_tracker->getCurrentSerial())
+				break;
+
+			submit_tracker->wait(oldest.serial);
+			retire();
+
+			allocated = tryAllocate(size, alignment, offset);
+		}
+
+		if (!allocated)
+		{
+			std::cerr << "ReadbackRing::allocate(): out of readback memory, release readbacks once their data is consumed" << std::endl;
+			return 0;
+		}
+
+		Readback readback;
+		readback.ticket = next_ticket++;
+		readback.serial = submit_tracker->getCurrentSerial();
+		readback.offset = offset;
+		readback.size = size;
+		readback.end = head;
+
+		readbacks.push_back(readback);
+
+		result_buffer = buffer;
+		result_offset = offset;
+
+		return readback.ticket;
+	}
+
+	/*
+	 */
+	bool ReadbackRing::isComplete(uint64_t ticket)
+	{
+		const Readback *readback = find(ticket);
+		if (readback == nullptr)
+			return false;
+
+		return submit_tracker->isComplete(readback->serial);
+	}
+
+	bool ReadbackRing::wait(uint64_t ticket)
+	{
+		const Readback *readback = find(ticket);
+		if (readback == nullptr)
+			return false;
+
+		if (readback->serial >= submit_tracker->getCurrentSerial())
+		{
+			std::cerr << "ReadbackRing::wait(): readback " << ticket << " is not submitted yet" << std::endl;
+			return false;
+		}
+
+		submit_tracker->wait(readback->serial);
+		return true;
+	}
+
+	const void *ReadbackRing::getData(uint64_t ticket, VkDeviceSize &size)
+	{
+		Readback *readback = find(ticket);
+		if (readback == nullptr || !submit_tracker->isComplete(readback->serial))
+			return nullptr;
+
+		// memory may be cached & non coherent, invalidate once before the first read
+		if (!readback->invalidated)
+		{
+			vmaInvalidateAllocation(device->getVRAMAllocator(), memory, readback->offset, readback->size);
+			readback->invalidated = true;
+		}
+
+		size = readback->size;
+		return data + readback->offset;
+	}
+
+	void ReadbackRing::release(uint64_t ticket)
+	{
+		Readback *readback = find(ticket);
+		if (readback == nullptr)
+			return;
+
+		readback->released = true;
+		retire();
+	}
+
+	/*
+	 */
+	bool ReadbackRing::createBuffer()
+	{
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = capacity;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo alloc_info = {};
+		alloc_info.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+		alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		alloc_info.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+		VmaAllocationInfo allocation_info = {};
+
+		if (vmaCreateBuffer(device->getVRAMAllocator(), &buffer_info, &alloc_info, &buffer, &memory, &allocation_info) != VK_SUCCESS)
+		{
+			std::cerr << "ReadbackRing::createBuffer(): can't create readback buffer" << std::endl;
+
+			buffer = VK_NULL_HANDLE;
+			memory = VK_NULL_HANDLE;
+			return false;
+		}
+
+		device->getMemoryTracker()->add(memory, MemoryCategory::STAGING);
+
+		data = reinterpret_cast<uint8_t *>(allocation_info.pMappedData);
+		return true;
+	}
+
+	ReadbackRing::Readback *ReadbackRing::find(uint64_t ticket)
+	{
+		// tickets are consecutive and retired in order
+		if (readbacks.empty() || ticket < readbacks.front().ticket)
+			return nullptr;
+
+		uint64_t index = ticket - readbacks.front().ticket;
+		if (index >= readbacks.size())
+			return nullptr;
+
+		Readback &readback = readbacks[static_cast<size_t>(index)];
+		if (readback.released)
+			return nullptr;
+
+		return &readback;
+	}
+
+	bool ReadbackRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+	{
+		VkDeviceSize aligned_head = (head + alignment - 1) / alignment * alignment;
+
+		if (head >= tail)
+		{
+			// free space is [head, capacity) and [0, tail)
+			if (aligned_head + size <= capacity)
+			{
+				offset = aligned_head;
+				head = aligned_head + size;
+				return true;
+			}
+
+			// wrap around, tail of the buffer is wasted until the readback is retired
+			if (size < tail)
+			{
+				offset = 0;
+				head = size;
+				return true;
+			}
+
+			return false;
+		}
+
+		// free space is [head, tail)
+		if (aligned_head + size < tail)
+		{
+			offset = aligned_head;
+			head = aligned_head + size;
+			return true;
+		}
+
+		return false;
+	}
+
+	void ReadbackRing::retire()
+	{
+		while (!readbacks.empty())
+		{
+			const Readback &readback = readbacks.front();
+
+			if (!readback.released || !submit_tracker->isComplete(readback.serial))
+				break;
+
+			tail = readback.end;
+			readbacks.pop_front();
+		}
+
+		// nothing is in use, start from the beginning to avoid wrapping
+		if (readbacks.empty())
+		{
+			head = 0;
+			tail = 0;
+		}
+	}
+}
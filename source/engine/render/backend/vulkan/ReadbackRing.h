@@ -0,0 +1,74 @@
+#pragma once
+
+#include <deque>
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+	class SubmitTracker;
+
+	/*
+	 * Ring of host visible memory GPU copies land in. Each readback gets a ticket,
+	 * its data is available once the submit it was recorded for is finished and
+	 * stays valid until the ticket is released; space is recycled in ticket order.
+	 * The buffer is created on first use. Not thread safe, meant to be used from
+	 * the render thread only.
+	 */
+	class ReadbackRing
+	{
+	public:
+		ReadbackRing(const Device *device, SubmitTracker *submit_tracker, VkDeviceSize capacity = DEFAULT_CAPACITY)
+			: device(device), submit_tracker(submit_tracker), capacity(capacity) { }
+		~ReadbackRing();
+
+		// returns 0 if the ring is full of readbacks that are not released yet
+		uint64_t allocate(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &buffer, VkDeviceSize &offset);
+
+		bool isComplete(uint64_t ticket);
+		bool wait(uint64_t ticket);
+
+		// null until the readback is complete
+		const void *getData(uint64_t ticket, VkDeviceSize &size);
+		void release(uint64_t ticket);
+
+	private:
+		struct Readback
+		{
+			uint64_t ticket {0};
+			uint64_t serial {0};
+			VkDeviceSize offset {0};
+			VkDeviceSize size {0};
+			VkDeviceSize end {0};
+			bool invalidated {false};
+			bool released {false};
+		};
+
+		bool createBuffer();
+		Readback *find(uint64_t ticket);
+		bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+		void retire();
+
+	private:
+		enum
+		{
+			DEFAULT_CAPACITY = 64 * 1024 * 1024,
+		};
+
+		const Device *device {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+
+		VkBuffer buffer {VK_NULL_HANDLE};
+		VmaAllocation memory {VK_NULL_HANDLE};
+		uint8_t *data {nullptr};
+		VkDeviceSize capacity {0};
+
+		// ring is empty when head == tail, allocations never make it full that way
+		VkDeviceSize head {0};
+		VkDeviceSize tail {0};
+
+		uint64_t next_ticket {1};
+		std::deque<Readback> readbacks;
+	};
+}
@@ -1,4 +1,5 @@
 #include "render/backend/vulkan/RenderPassBuilder.h"
+#include "render/backend/vulkan/Utils.h"
 
 namespace render::backend::vulkan
 {
@@ -57,10 +58,10 @@ namespace render::backend::vulkan
 		int attachment
 	)
 	{
-		if (subpass < 0 || subpass >= subpass_infos.size())
+		if (subpass < 0 || subpass >= static_cast<int>(subpass_infos.size()))
 			return *this;
 
-		if (attachment < 0 || attachment >= attachments.size())
+		if (attachment < 0 || attachment >= static_cast<int>(attachments.size()))
 			return *this;
 
 		VkAttachmentReference reference = {};
@@ -78,10 +79,10 @@ namespace render::backend::vulkan
 		int attachment
 	)
 	{
-		if (subpass < 0 || subpass >= subpass_infos.size())
+		if (subpass < 0 || subpass >= static_cast<int>(subpass_infos.size()))
 			return *this;
 
-		if (attachment < 0 || attachment >= attachments.size())
+		if (attachment < 0 || attachment >= static_cast<int>(attachments.size()))
 			return *this;
 
 		VkAttachmentReference reference = {};
@@ -99,10 +100,10 @@ namespace render::backend::vulkan
 		int attachment
 	)
 	{
-		if (subpass < 0 || subpass >= subpass_infos.size())
+		if (subpass < 0 || subpass >= static_cast<int>(subpass_infos.size()))
 			return *this;
 
-		if (attachment < 0 || attachment >= attachments.size())
+		if (attachment < 0 || attachment >= static_cast<int>(attachments.size()))
 			return *this;
 
 		SubpassData &data = subpass_datas[subpass];
@@ -119,11 +120,59 @@ namespace render::backend::vulkan
 		return *this;
 	}
 
+	RenderPassBuilder &RenderPassBuilder::addInputAttachmentReference(
+		int subpass,
+		int attachment
+	)
+	{
+		if (subpass < 0 || subpass >= static_cast<int>(subpass_infos.size()))
+			return *this;
+
+		if (attachment < 0 || attachment >= static_cast<int>(attachments.size()))
+			return *this;
+
+		VkImageAspectFlags aspect_flags = Utils::getImageAspectFlags(attachments[attachment].format);
+		bool depth = (aspect_flags & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+
+		VkAttachmentReference reference = {};
+		reference.attachment = attachment;
+		reference.layout = (depth) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		SubpassData &data = subpass_datas[subpass];
+		data.input_attachment_references.push_back(reference);
+
+		return *this;
+	}
+
+	RenderPassBuilder &RenderPassBuilder::addSubpassDependency(
+		int src_subpass,
+		int dst_subpass,
+		VkPipelineStageFlags src_stages,
+		VkPipelineStageFlags dst_stages,
+		VkAccessFlags src_access,
+		VkAccessFlags dst_access,
+		VkDependencyFlags flags
+	)
+	{
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = static_cast<uint32_t>(src_subpass);
+		dependency.dstSubpass = static_cast<uint32_t>(dst_subpass);
+		dependency.srcStageMask = src_stages;
+		dependency.dstStageMask = dst_stages;
+		dependency.srcAccessMask = src_access;
+		dependency.dstAccessMask = dst_access;
+		dependency.dependencyFlags = flags;
+
+		dependencies.push_back(dependency);
+
+		return *this;
+	}
+
 	/*
 	 */
 	VkRenderPass RenderPassBuilder::build(VkDevice device)
 	{
-		for (int i = 0; i < subpass_infos.size(); i++)
+		for (size_t i = 0; i < subpass_infos.size(); i++)
 		{
 			SubpassData &data = subpass_datas[i];
 			VkSubpassDescription &info = subpass_infos[i];
@@ -132,6 +181,8 @@ namespace render::backend::vulkan
 			info.colorAttachmentCount = static_cast<uint32_t>(data.color_attachment_references.size());
 			info.pColorAttachments = data.color_attachment_references.data();
 			info.pResolveAttachments = data.color_attachment_resolve_references.data();
+			info.inputAttachmentCount = static_cast<uint32_t>(data.input_attachment_references.size());
+			info.pInputAttachments = data.input_attachment_references.data();
 		}
 
 		VkRenderPassCreateInfo info = {};
@@ -140,6 +191,8 @@ namespace render::backend::vulkan
 		info.pAttachments = attachments.data();
 		info.subpassCount = static_cast<uint32_t>(subpass_infos.size());
 		info.pSubpasses = subpass_infos.data();
+		info.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		info.pDependencies = dependencies.data();
 
 		VkRenderPass result = VK_NULL_HANDLE;
 		if (vkCreateRenderPass(device, &info, nullptr, &result) != VK_SUCCESS)
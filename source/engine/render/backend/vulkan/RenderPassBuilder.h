@@ -13,7 +13,7 @@ namespace render::backend::vulkan
 		RenderPassBuilder() { }
 		~RenderPassBuilder();
 
-		RenderPassBuilder &RenderPassBuilder::addAttachment(
+		RenderPassBuilder &addAttachment(
 			VkFormat format,
 			VkSampleCountFlagBits num_samples,
 			VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
@@ -42,6 +42,21 @@ namespace render::backend::vulkan
 			int attachment
 		);
 
+		RenderPassBuilder &addInputAttachmentReference(
+			int subpass,
+			int attachment
+		);
+
+		RenderPassBuilder &addSubpassDependency(
+			int src_subpass,
+			int dst_subpass,
+			VkPipelineStageFlags src_stages,
+			VkPipelineStageFlags dst_stages,
+			VkAccessFlags src_access,
+			VkAccessFlags dst_access,
+			VkDependencyFlags flags = VK_DEPENDENCY_BY_REGION_BIT
+		);
+
 		VkRenderPass build(VkDevice device);
 
 	private:
@@ -49,11 +64,13 @@ namespace render::backend::vulkan
 		{
 			std::vector<VkAttachmentReference> color_attachment_references;
 			std::vector<VkAttachmentReference> color_attachment_resolve_references;
+			std::vector<VkAttachmentReference> input_attachment_references;
 			VkAttachmentReference *depth_stencil_attachment_reference {nullptr};
 		};
 
 		std::vector<VkAttachmentDescription> attachments;
 		std::vector<VkSubpassDescription> subpass_infos;
 		std::vector<SubpassData> subpass_datas;
+		std::vector<VkSubpassDependency> dependencies;
 	};
 }
@@ -0,0 +1,118 @@
+#include "render/backend/vulkan/SamplerCache.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	template <class T>
+	static void hashCombine(uint64_t &s, const T &v)
+	{
+		std::hash<T> h;
+		s^= h(v) + 0x9e3779b9 + (s<< 6) + (s>> 2);
+	}
+
+	/*
+	 */
+	SamplerCache::SamplerCache(const Device *device)
+		: device(device)
+	{
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+
+		max_anisotropy = properties.limits.maxSamplerAnisotropy;
+	}
+
+	SamplerCache::~SamplerCache()
+	{
+		clear();
+	}
+
+	/*
+	 */
+	VkSampler SamplerCache::fetch(const SamplerDescription &description)
+	{
+		assert(description.min_lod <= description.max_lod && "Invalid sampler LOD range");
+
+		uint64_t hash = getHash(description);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = cache.find(hash);
+		if (it != cache.end())
+			return it->second;
+
+		float anisotropy = std::min(description.max_anisotropy, max_anisotropy);
+
+		VkSamplerCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		info.magFilter = Utils::getSamplerFilter(description.mag_filter);
+		info.minFilter = Utils::getSamplerFilter(description.min_filter);
+		info.mipmapMode = Utils::getSamplerMipmapMode(description.mip_filter);
+		info.addressModeU = Utils::getSamplerAddressMode(description.wrap_u);
+		info.addressModeV = Utils::getSamplerAddressMode(description.wrap_v);
+		info.addressModeW = Utils::getSamplerAddressMode(description.wrap_w);
+		info.anisotropyEnable = (anisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+		info.maxAnisotropy = std::max(anisotropy, 1.0f);
+		info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		info.unnormalizedCoordinates = VK_FALSE;
+		info.compareEnable = description.depth_compare;
+		info.compareOp = Utils::getDepthCompareFunc(description.depth_compare_func);
+		info.mipLodBias = 0.0f;
+		info.minLod = description.min_lod;
+		info.maxLod = description.max_lod;
+
+		VkSampler result = VK_NULL_HANDLE;
+		if (vkCreateSampler(device->getDevice(), &info, nullptr, &result) != VK_SUCCESS)
+		{
+			std::cerr << "SamplerCache::fetch(): can't create sampler, " << cache.size() << " samplers are alive" << std::endl;
+			return VK_NULL_HANDLE;
+		}
+
+		cache[hash] = result;
+		return result;
+	}
+
+	void SamplerCache::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (auto it = cache.begin(); it != cache.end(); ++it)
+			vkDestroySampler(device->getDevice(), it->second, nullptr);
+
+		cache.clear();
+	}
+
+	uint32_t SamplerCache::getNumSamplers() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(cache.size());
+	}
+
+	/*
+	 */
+	uint64_t SamplerCache::getHash(const SamplerDescription &description) const
+	{
+		uint64_t hash = 0;
+
+		hashCombine(hash, description.min_filter);
+		hashCombine(hash, description.mag_filter);
+		hashCombine(hash, description.mip_filter);
+		hashCombine(hash, description.wrap_u);
+		hashCombine(hash, description.wrap_v);
+		hashCombine(hash, description.wrap_w);
+		hashCombine(hash, std::min(description.max_anisotropy, max_anisotropy));
+		hashCombine(hash, description.min_lod);
+		hashCombine(hash, description.max_lod);
+		hashCombine(hash, description.depth_compare);
+
+		// compare function is ignored by disabled compare
+		if (description.depth_compare)
+			hashCombine(hash, description.depth_compare_func);
+
+		return hash;
+	}
+}
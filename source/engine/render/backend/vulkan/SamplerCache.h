@@ -0,0 +1,38 @@
+#pragma once
+
+#include <render/backend/Driver.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <volk.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+
+	/*
+	 * Shares samplers between identical descriptions, samplers are kept alive
+	 * until the cache is destroyed. Textures may be created from loader threads.
+	 */
+	class SamplerCache
+	{
+	public:
+		SamplerCache(const Device *device);
+		~SamplerCache();
+
+		VkSampler fetch(const SamplerDescription &description);
+		void clear();
+
+		uint32_t getNumSamplers() const;
+
+	private:
+		uint64_t getHash(const SamplerDescription &description) const;
+
+	private:
+		const Device *device {nullptr};
+		float max_anisotropy {1.0f};
+
+		std::unordered_map<uint64_t, VkSampler> cache;
+		mutable std::mutex mutex;
+	};
+}
@@ -0,0 +1,118 @@
+#include "render/backend/vulkan/SubmitTracker.h"
+#include "render/backend/vulkan/Device.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	SubmitTracker::~SubmitTracker()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		while (!pending_submits.empty())
+			retire(true);
+
+		for (VkFence fence : free_fences)
+			vkDestroyFence(device->getDevice(), fence, nullptr);
+
+		free_fences.clear();
+	}
+
+	/*
+	 */
+	uint64_t SubmitTracker::getCompletedSerial()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		retire(false);
+		return completed_serial.load(std::memory_order_relaxed);
+	}
+
+	bool SubmitTracker::isComplete(uint64_t serial)
+	{
+		// completed serial only grows, no need to lock once it is past
+		if (serial <= completed_serial.load(std::memory_order_acquire))
+			return true;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		retire(false);
+		return serial <= completed_serial.load(std::memory_order_relaxed);
+	}
+
+	void SubmitTracker::wait(uint64_t serial)
+	{
+		assert(serial < current_serial.load(std::memory_order_acquire) && "Can't wait for work that is not submitted yet");
+
+		// fences are recycled by retire, so waits happen under the lock as well
+		std::lock_guard<std::mutex> lock(mutex);
+
+		while (completed_serial.load(std::memory_order_relaxed) < serial && !pending_submits.empty())
+			retire(true);
+	}
+
+	void SubmitTracker::submit()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		PendingSubmit pending;
+		pending.serial = current_serial.load(std::memory_order_relaxed);
+
+		if (free_fences.empty())
+		{
+			VkFenceCreateInfo fence_info = {};
+			fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			VkResult result = vkCreateFence(device->getDevice(), &fence_info, nullptr, &pending.fence);
+			assert((result == VK_SUCCESS) && "Can't create fence");
+		}
+		else
+		{
+			pending.fence = free_fences.back();
+			free_fences.pop_back();
+		}
+
+		current_serial.fetch_add(1, std::memory_order_release);
+
+		// empty submit, fence signals once all previously submitted work is finished
+		if (vkQueueSubmit(device->getGraphicsQueue(), 0, nullptr, pending.fence) != VK_SUCCESS)
+		{
+			std::cerr << "SubmitTracker::submit(): can't submit fence, waiting for the queue instead" << std::endl;
+
+			vkQueueWaitIdle(device->getGraphicsQueue());
+			free_fences.push_back(pending.fence);
+
+			completed_serial.store(pending.serial, std::memory_order_release);
+			return;
+		}
+
+		pending_submits.push_back(pending);
+	}
+
+	/*
+	 */
+	void SubmitTracker::retire(bool wait)
+	{
+		while (!pending_submits.empty())
+		{
+			PendingSubmit &pending = pending_submits.front();
+
+			if (wait)
+			{
+				vkWaitForFences(device->getDevice(), 1, &pending.fence, VK_TRUE, UINT64_MAX);
+				wait = false;
+			}
+			else if (vkGetFenceStatus(device->getDevice(), pending.fence) != VK_SUCCESS)
+				break;
+
+			vkResetFences(device->getDevice(), 1, &pending.fence);
+			free_fences.push_back(pending.fence);
+
+			completed_serial.store(pending.serial, std::memory_order_release);
+			pending_submits.pop_front();
+		}
+	}
+}
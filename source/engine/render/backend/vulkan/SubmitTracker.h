@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <volk.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+
+	/*
+	 * Tracks GPU progress of graphics queue submits with monotonically increasing
+	 * serials. Work recorded now belongs to getCurrentSerial(), it is finished once
+	 * isComplete() returns true for that serial. Serials may be read and polled from
+	 * loader threads while the render thread submits.
+	 */
+	class SubmitTracker
+	{
+	public:
+		SubmitTracker(const Device *device)
+			: device(device) { }
+		~SubmitTracker();
+
+		inline uint64_t getCurrentSerial() const { return current_serial.load(std::memory_order_acquire); }
+		uint64_t getCompletedSerial();
+
+		bool isComplete(uint64_t serial);
+		void wait(uint64_t serial);
+
+		// submits a fence to the graphics queue, caller must hold the device queue mutex
+		void submit();
+
+	private:
+		struct PendingSubmit
+		{
+			uint64_t serial {0};
+			VkFence fence {VK_NULL_HANDLE};
+		};
+
+		// caller must hold the mutex
+		void retire(bool wait);
+
+	private:
+		const Device *device {nullptr};
+
+		std::atomic<uint64_t> current_serial {1};
+		std::atomic<uint64_t> completed_serial {0};
+
+		std::deque<PendingSubmit> pending_submits;
+		std::vector<VkFence> free_fences;
+		std::mutex mutex;
+	};
+}
@@ -0,0 +1,168 @@
+#include "render/backend/vulkan/TransientAllocator.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/MemoryTracker.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	/*
+	 */
+	TransientAllocator::TransientAllocator(const Device *device, SubmitTracker *submit_tracker, VkDeviceSize capacity)
+		: device(device), submit_tracker(submit_tracker), capacity(capacity)
+	{
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+
+		uniform_alignment = properties.limits.minUniformBufferOffsetAlignment;
+
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = capacity;
+		buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo alloc_info = {};
+		alloc_info.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		VmaAllocationInfo allocation_info = {};
+
+		VkResult result = vmaCreateBuffer(device->getVRAMAllocator(), &buffer_info, &alloc_info, &buffer, &memory, &allocation_info);
+		assert((result == VK_SUCCESS) && "Can't create transient buffer");
+
+		device->getMemoryTracker()->add(memory, MemoryCategory::UNIFORMS);
+
+		data = reinterpret_cast<uint8_t *>(allocation_info.pMappedData);
+	}
+
+	TransientAllocator::~TransientAllocator()
+	{
+		while (!frames.empty())
+			retire(true);
+
+		device->getMemoryTracker()->remove(memory);
+		vmaDestroyBuffer(device->getVRAMAllocator(), buffer, memory);
+
+		buffer = VK_NULL_HANDLE;
+		memory = VK_NULL_HANDLE;
+		data = nullptr;
+	}
+
+	/*
+	 */
+	TransientAllocation TransientAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		assert(size != 0 && "Invalid size");
+
+		TransientAllocation result;
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+
+		retire(false);
+
+		VkDeviceSize offset = 0;
+		bool allocated = tryAllocate(size, alignment, offset);
+
+		// ring is full, wait for the oldest frames in flight
+		while (!allocated && !frames.empty())
+		{
+			retire(true);
+			allocated = tryAllocate(size, alignment, offset);
+		}
+
+		if (!allocated)
+		{
+			std::cerr << "TransientAllocator::allocate(): out of transient memory, current frame needs more than " << capacity << " bytes" << std::endl;
+			return result;
+		}
+
+		frame_used = true;
+
+		result.data = data + offset;
+		result.buffer = buffer;
+		result.offset = offset;
+
+		return result;
+	}
+
+	void TransientAllocator::endFrame()
+	{
+		if (!frame_used)
+			return;
+
+		Frame frame;
+		frame.serial = submit_tracker->getCurrentSerial();
+		frame.end = head;
+
+		frames.push_back(frame);
+		frame_used = false;
+	}
+
+	/*
+	 */
+	bool TransientAllocator::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+	{
+		VkDeviceSize aligned_head = (head + alignment - 1) / alignment * alignment;
+
+		if (head >= tail)
+		{
+			// free space is [head, capacity) and [0, tail)
+			if (aligned_head + size <= capacity)
+			{
+				offset = aligned_head;
+				head = aligned_head + size;
+				return true;
+			}
+
+			// wrap around, tail of the buffer is wasted until the frame is retired
+			if (size < tail)
+			{
+				offset = 0;
+				head = size;
+				return true;
+			}
+
+			return false;
+		}
+
+		// free space is [head, tail)
+		if (aligned_head + size < tail)
+		{
+			offset = aligned_head;
+			head = aligned_head + size;
+			return true;
+		}
+
+		return false;
+	}
+
+	void TransientAllocator::retire(bool wait)
+	{
+		while (!frames.empty())
+		{
+			Frame &frame = frames.front();
+
+			if (wait)
+			{
+				submit_tracker->wait(frame.serial);
+				wait = false;
+			}
+			else if (!submit_tracker->isComplete(frame.serial))
+				break;
+
+			tail = frame.end;
+			frames.pop_front();
+		}
+
+		// nothing is in use, start from the beginning to avoid wrapping
+		if (frames.empty() && !frame_used)
+		{
+			head = 0;
+			tail = 0;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <deque>
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+	class SubmitTracker;
+
+	struct TransientAllocation
+	{
+		void *data {nullptr};
+		VkBuffer buffer {VK_NULL_HANDLE};
+		VkDeviceSize offset {0};
+	};
+
+	/*
+	 * Linear ring over a single persistently mapped buffer. Allocations are
+	 * valid until the frame they were made in is finished on GPU: endFrame()
+	 * closes the current frame with the current submit serial, space is recycled
+	 * once it completes. Not thread safe, meant to be used from the render thread only.
+	 */
+	class TransientAllocator
+	{
+	public:
+		TransientAllocator(const Device *device, SubmitTracker *submit_tracker, VkDeviceSize capacity = DEFAULT_CAPACITY);
+		~TransientAllocator();
+
+		TransientAllocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+		// must be called before the submit tracker advances
+		void endFrame();
+
+		inline VkBuffer getBuffer() const { return buffer; }
+		inline VkDeviceSize getCapacity() const { return capacity; }
+		inline VkDeviceSize getUniformAlignment() const { return uniform_alignment; }
+
+	private:
+		bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+		void retire(bool wait);
+
+	private:
+		enum
+		{
+			DEFAULT_CAPACITY = 32 * 1024 * 1024,
+		};
+
+		struct Frame
+		{
+			uint64_t serial {0};
+			VkDeviceSize end {0};
+		};
+
+		const Device *device {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+
+		VkBuffer buffer {VK_NULL_HANDLE};
+		VmaAllocation memory {VK_NULL_HANDLE};
+		uint8_t *data {nullptr};
+		VkDeviceSize capacity {0};
+		VkDeviceSize uniform_alignment {1};
+
+		// ring is empty when head == tail, allocations never make it full that way
+		VkDeviceSize head {0};
+		VkDeviceSize tail {0};
+		bool frame_used {false};
+
+		std::deque<Frame> frames;
+	};
+}
@@ -0,0 +1,766 @@
+#include "render/backend/vulkan/UploadContext.h"
+#include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/MemoryTracker.h"
+#include "render/backend/vulkan/Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace render::backend::vulkan
+{
+	std::atomic<uint64_t> UploadContext::next_ticket {1};
+
+	// makes transfer writes visible to later transfers and vertex input
+	static void transferBarrier(VkCommandBuffer command_buffer)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+	}
+
+	/*
+	 */
+	UploadContext::~UploadContext()
+	{
+		submit();
+
+		{
+			std::lock_guard<std::mutex> lock(in_flight_mutex);
+
+			for (Batch *batch : in_flight_batches)
+				vkWaitForFences(device->getDevice(), 1, &batch->fence, VK_TRUE, UINT64_MAX);
+		}
+
+		retire();
+
+		for (Batch *batch : free_batches)
+			destroyBatch(batch);
+
+		free_batches.clear();
+
+		vkDestroyCommandPool(device->getDevice(), transfer_pool, nullptr);
+		transfer_pool = VK_NULL_HANDLE;
+
+		vkDestroyCommandPool(device->getDevice(), graphics_pool, nullptr);
+		graphics_pool = VK_NULL_HANDLE;
+	}
+
+	/*
+	 */
+	void UploadContext::beginBatch()
+	{
+		num_batches++;
+	}
+
+	bool UploadContext::endBatch()
+	{
+		assert(num_batches > 0 && "Unbalanced upload batch");
+
+		num_batches--;
+		if (num_batches > 0)
+			return true;
+
+		if (!submit())
+			return false;
+
+		return wait(last_ticket);
+	}
+
+	uint64_t UploadContext::endBatchAsync()
+	{
+		assert(num_batches > 0 && "Unbalanced upload batch");
+
+		num_batches--;
+		if (num_batches > 0)
+			return 0;
+
+		if (!submit())
+			return 0;
+
+		return last_ticket;
+	}
+
+	/*
+	 */
+	bool UploadContext::isComplete(uint64_t ticket)
+	{
+		if (ticket == 0)
+			return true;
+
+		std::lock_guard<std::mutex> lock(in_flight_mutex);
+
+		for (Batch *batch : in_flight_batches)
+			if (batch->ticket == ticket)
+				return vkGetFenceStatus(device->getDevice(), batch->fence) == VK_SUCCESS;
+
+		// retired batches are complete by definition
+		return true;
+	}
+
+	bool UploadContext::wait(uint64_t ticket)
+	{
+		if (ticket == 0)
+			return true;
+
+		VkFence fence = VK_NULL_HANDLE;
+
+		{
+			std::lock_guard<std::mutex> lock(in_flight_mutex);
+
+			for (Batch *batch : in_flight_batches)
+				if (batch->ticket == ticket)
+					fence = batch->fence;
+		}
+
+		if (fence == VK_NULL_HANDLE)
+			return true;
+
+		bool result = (vkWaitForFences(device->getDevice(), 1, &fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS);
+		if (!result)
+			std::cerr << "UploadContext::wait(): can't wait for upload commands" << std::endl;
+
+		retire();
+		return result;
+	}
+
+	/*
+	 */
+	void UploadContext::fillBuffer(VkBuffer buffer, VkDeviceSize size, const void *data)
+	{
+		beginBatch();
+
+		VkBuffer staging_buffer = VK_NULL_HANDLE;
+		VkDeviceSize staging_offset = 0;
+
+		uint8_t *staging_data = allocateStaging(size, 4, staging_buffer, staging_offset);
+		if (staging_data == nullptr)
+		{
+			std::cerr << "UploadContext::fillBuffer(): can't allocate staging memory" << std::endl;
+			endBatch();
+			return;
+		}
+
+		memcpy(staging_data, data, static_cast<size_t>(size));
+
+		VkBufferCopy region = {};
+		region.srcOffset = staging_offset;
+		region.size = size;
+
+		vkCmdCopyBuffer(getTransferCommands(), staging_buffer, buffer, 1, &region);
+
+		if (device->hasDedicatedTransferQueue() && std::find(released_buffers.begin(), released_buffers.end(), buffer) == released_buffers.end())
+			released_buffers.push_back(buffer);
+
+		endBatch();
+	}
+
+	void UploadContext::fillBufferRange(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void *data)
+	{
+		beginBatch();
+
+		VkBuffer staging_buffer = VK_NULL_HANDLE;
+		VkDeviceSize staging_offset = 0;
+
+		uint8_t *staging_data = allocateStaging(size, 4, staging_buffer, staging_offset);
+		if (staging_data == nullptr)
+		{
+			std::cerr << "UploadContext::fillBufferRange(): can't allocate staging memory" << std::endl;
+			endBatch();
+			return;
+		}
+
+		memcpy(staging_data, data, static_cast<size_t>(size));
+
+		VkBufferCopy region = {};
+		region.srcOffset = staging_offset;
+		region.dstOffset = offset;
+		region.size = size;
+
+		VkCommandBuffer command_buffer = getGraphicsCommands();
+		vkCmdCopyBuffer(command_buffer, staging_buffer, buffer, 1, &region);
+
+		transferBarrier(command_buffer);
+
+		endBatch();
+	}
+
+	void UploadContext::copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, uint32_t num_regions, const VkBufferCopy *regions)
+	{
+		if (num_regions == 0)
+			return;
+
+		beginBatch();
+
+		// source may have been written earlier in this batch
+		VkCommandBuffer command_buffer = getGraphicsCommands();
+		transferBarrier(command_buffer);
+
+		vkCmdCopyBuffer(command_buffer, src_buffer, dst_buffer, num_regions, regions);
+
+		transferBarrier(command_buffer);
+
+		endBatch();
+	}
+
+	void UploadContext::fillImage(
+		VkImage image,
+		uint32_t width,
+		uint32_t height,
+		uint32_t depth,
+		uint32_t pixel_size,
+		const void *data,
+		uint32_t num_data_mipmaps,
+		uint32_t num_data_layers
+	)
+	{
+		beginBatch();
+
+		VkDeviceSize size = Utils::getImageDataSize(width, height, depth, pixel_size, num_data_mipmaps, num_data_layers);
+
+		// buffer offset must be a multiple of both texel size and 4
+		VkDeviceSize alignment = std::max<VkDeviceSize>(pixel_size, 1) * 4;
+
+		VkBuffer staging_buffer = VK_NULL_HANDLE;
+		VkDeviceSize staging_offset = 0;
+
+		uint8_t *staging_data = allocateStaging(size, alignment, staging_buffer, staging_offset);
+		if (staging_data == nullptr)
+		{
+			std::cerr << "UploadContext::fillImage(): can't allocate staging memory" << std::endl;
+			endBatch();
+			return;
+		}
+
+		memcpy(staging_data, data, static_cast<size_t>(size));
+
+		Utils::copyBufferToImage(
+			getTransferCommands(),
+			staging_buffer,
+			staging_offset,
+			image,
+			width, height, depth,
+			pixel_size,
+			num_data_mipmaps,
+			num_data_layers
+		);
+
+		if (device->hasDedicatedTransferQueue() && std::find(released_images.begin(), released_images.end(), image) == released_images.end())
+			released_images.push_back(image);
+
+		endBatch();
+	}
+
+	void UploadContext::transitionImageLayout(
+		VkImage image,
+		VkFormat format,
+		VkImageLayout old_layout,
+		VkImageLayout new_layout,
+		uint32_t base_mip,
+		uint32_t num_mips,
+		uint32_t base_layer,
+		uint32_t num_layers
+	)
+	{
+		beginBatch();
+
+		// first transition after a copy on the transfer queue doubles as ownership transfer
+		auto it = std::find(released_images.begin(), released_images.end(), image);
+		if (it != released_images.end())
+		{
+			releaseImage(image, format, old_layout, new_layout, base_mip, num_mips, base_layer, num_layers);
+			released_images.erase(it);
+
+			endBatch();
+			return;
+		}
+
+		// preparing for a copy happens on the queue that does the copy
+		bool before_copy = (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+		Utils::transitionImageLayout(
+			(before_copy) ? getTransferCommands() : getGraphicsCommands(),
+			image,
+			format,
+			old_layout,
+			new_layout,
+			base_mip, num_mips,
+			base_layer, num_layers
+		);
+
+		endBatch();
+	}
+
+	void UploadContext::generateImage2DMipmaps(
+		VkImage image,
+		VkFormat format,
+		uint32_t width,
+		uint32_t height,
+		uint32_t num_mips,
+		VkFilter filter
+	)
+	{
+		beginBatch();
+
+		// blits are not supported on transfer-only queues
+		Utils::generateImage2DMipmaps(
+			device,
+			getGraphicsCommands(),
+			image,
+			format,
+			width, height,
+			num_mips,
+			format,
+			filter
+		);
+
+		endBatch();
+	}
+
+	/*
+	 */
+	UploadContext::Batch *UploadContext::getBatch()
+	{
+		if (current_batch != nullptr)
+			return current_batch;
+
+		retire();
+
+		if (free_batches.empty())
+		{
+			current_batch = createBatch();
+		}
+		else
+		{
+			current_batch = free_batches.back();
+			free_batches.pop_back();
+		}
+
+		return current_batch;
+	}
+
+	VkCommandBuffer UploadContext::getTransferCommands()
+	{
+		if (!device->hasDedicatedTransferQueue())
+			return getGraphicsCommands();
+
+		Batch *batch = getBatch();
+		return beginCommands(batch->transfer_commands, batch->transfer_recording);
+	}
+
+	VkCommandBuffer UploadContext::getGraphicsCommands()
+	{
+		Batch *batch = getBatch();
+		return beginCommands(batch->graphics_commands, batch->graphics_recording);
+	}
+
+	VkCommandBuffer UploadContext::beginCommands(VkCommandBuffer command_buffer, bool &recording)
+	{
+		if (recording)
+			return command_buffer;
+
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(command_buffer, &begin_info);
+		recording = true;
+
+		return command_buffer;
+	}
+
+	/*
+	 */
+	void UploadContext::releaseBuffers()
+	{
+		if (released_buffers.empty())
+			return;
+
+		std::vector<VkBufferMemoryBarrier> release_barriers(released_buffers.size());
+		std::vector<VkBufferMemoryBarrier> acquire_barriers(released_buffers.size());
+
+		for (size_t i = 0; i < released_buffers.size(); ++i)
+		{
+			VkBufferMemoryBarrier &release = release_barriers[i];
+			release = {};
+			release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			release.dstAccessMask = 0;
+			release.srcQueueFamilyIndex = device->getTransferQueueFamily();
+			release.dstQueueFamilyIndex = device->getGraphicsQueueFamily();
+			release.buffer = released_buffers[i];
+			release.offset = 0;
+			release.size = VK_WHOLE_SIZE;
+
+			VkBufferMemoryBarrier &acquire = acquire_barriers[i];
+			acquire = release;
+			acquire.srcAccessMask = 0;
+			acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		}
+
+		vkCmdPipelineBarrier(
+			getTransferCommands(),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(release_barriers.size()), release_barriers.data(),
+			0, nullptr
+		);
+
+		vkCmdPipelineBarrier(
+			getGraphicsCommands(),
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(acquire_barriers.size()), acquire_barriers.data(),
+			0, nullptr
+		);
+
+		released_buffers.clear();
+	}
+
+	void UploadContext::releaseImage(
+		VkImage image,
+		VkFormat format,
+		VkImageLayout old_layout,
+		VkImageLayout new_layout,
+		uint32_t base_mip,
+		uint32_t num_mips,
+		uint32_t base_layer,
+		uint32_t num_layers
+	)
+	{
+		// layout transition is performed once, release and acquire must specify the same layouts
+		VkImageMemoryBarrier release = {};
+		release.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		release.dstAccessMask = 0;
+		release.oldLayout = old_layout;
+		release.newLayout = new_layout;
+		release.srcQueueFamilyIndex = device->getTransferQueueFamily();
+		release.dstQueueFamilyIndex = device->getGraphicsQueueFamily();
+		release.image = image;
+		release.subresourceRange.aspectMask = Utils::getImageAspectFlags(format);
+		release.subresourceRange.baseMipLevel = base_mip;
+		release.subresourceRange.levelCount = num_mips;
+		release.subresourceRange.baseArrayLayer = base_layer;
+		release.subresourceRange.layerCount = num_layers;
+
+		VkImageMemoryBarrier acquire = release;
+		acquire.srcAccessMask = 0;
+		acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+		vkCmdPipelineBarrier(
+			getTransferCommands(),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &release
+		);
+
+		vkCmdPipelineBarrier(
+			getGraphicsCommands(),
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &acquire
+		);
+	}
+
+	/*
+	 */
+	uint8_t *UploadContext::allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &buffer, VkDeviceSize &offset)
+	{
+		Batch *batch = getBatch();
+
+		for (StagingChunk &chunk : batch->staging_chunks)
+		{
+			VkDeviceSize aligned_offset = (chunk.offset + alignment - 1) / alignment * alignment;
+			if (aligned_offset + size > chunk.size)
+				continue;
+
+			chunk.offset = aligned_offset + size;
+
+			buffer = chunk.buffer;
+			offset = aligned_offset;
+			return chunk.data + aligned_offset;
+		}
+
+		// staging arena is too big, flush recorded work and continue in a new batch
+		if (!batch->staging_chunks.empty() && batch->staging_size + size > MAX_STAGING_SIZE)
+		{
+			submit();
+			return allocateStaging(size, alignment, buffer, offset);
+		}
+
+		if (!createStagingChunk(batch, std::max<VkDeviceSize>(size, STAGING_CHUNK_SIZE)))
+			return nullptr;
+
+		StagingChunk &chunk = batch->staging_chunks.back();
+		chunk.offset = size;
+
+		buffer = chunk.buffer;
+		offset = 0;
+		return chunk.data;
+	}
+
+	bool UploadContext::submit()
+	{
+		if (current_batch == nullptr)
+			return true;
+
+		Batch *batch = current_batch;
+
+		// graphics submit always happens, it carries acquire barriers and the fence
+		releaseBuffers();
+		getGraphicsCommands();
+
+		current_batch = nullptr;
+		batch->ticket = next_ticket++;
+
+		bool wait_transfer = batch->transfer_recording;
+		bool result = true;
+
+		{
+			std::lock_guard<std::mutex> lock(device->getQueueMutex());
+
+			if (batch->transfer_recording)
+			{
+				batch->transfer_recording = false;
+				vkEndCommandBuffer(batch->transfer_commands);
+
+				VkSubmitInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+				info.commandBufferCount = 1;
+				info.pCommandBuffers = &batch->transfer_commands;
+				info.signalSemaphoreCount = 1;
+				info.pSignalSemaphores = &batch->transfer_finished;
+
+				result = (vkQueueSubmit(device->getTransferQueue(), 1, &info, VK_NULL_HANDLE) == VK_SUCCESS);
+			}
+
+			batch->graphics_recording = false;
+			vkEndCommandBuffer(batch->graphics_commands);
+
+			VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			VkSubmitInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			info.commandBufferCount = 1;
+			info.pCommandBuffers = &batch->graphics_commands;
+
+			if (wait_transfer)
+			{
+				info.waitSemaphoreCount = 1;
+				info.pWaitSemaphores = &batch->transfer_finished;
+				info.pWaitDstStageMask = &wait_stage;
+			}
+
+			if (result)
+				result = (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, batch->fence) == VK_SUCCESS);
+
+			// semaphore might be left signaled, don't reuse anything from a failed batch
+			if (!result)
+			{
+				vkQueueWaitIdle(device->getTransferQueue());
+				vkQueueWaitIdle(device->getGraphicsQueue());
+			}
+		}
+
+		if (!result)
+		{
+			std::cerr << "UploadContext::submit(): can't submit upload commands" << std::endl;
+			destroyBatch(batch);
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(in_flight_mutex);
+			in_flight_batches.push_back(batch);
+		}
+
+		last_ticket = batch->ticket;
+		return true;
+	}
+
+	void UploadContext::retire()
+	{
+		std::lock_guard<std::mutex> lock(in_flight_mutex);
+
+		for (auto it = in_flight_batches.begin(); it != in_flight_batches.end(); )
+		{
+			Batch *batch = *it;
+			if (vkGetFenceStatus(device->getDevice(), batch->fence) != VK_SUCCESS)
+			{
+				++it;
+				continue;
+			}
+
+			resetBatch(batch);
+			free_batches.push_back(batch);
+
+			it = in_flight_batches.erase(it);
+		}
+	}
+
+	/*
+	 */
+	UploadContext::Batch *UploadContext::createBatch()
+	{
+		bool dedicated_transfer = device->hasDedicatedTransferQueue();
+
+		VkCommandPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (graphics_pool == VK_NULL_HANDLE)
+		{
+			pool_info.queueFamilyIndex = device->getGraphicsQueueFamily();
+
+			VkResult result = vkCreateCommandPool(device->getDevice(), &pool_info, nullptr, &graphics_pool);
+			assert((result == VK_SUCCESS) && "Can't create command pool");
+		}
+
+		if (dedicated_transfer && transfer_pool == VK_NULL_HANDLE)
+		{
+			pool_info.queueFamilyIndex = device->getTransferQueueFamily();
+
+			VkResult result = vkCreateCommandPool(device->getDevice(), &pool_info, nullptr, &transfer_pool);
+			assert((result == VK_SUCCESS) && "Can't create command pool");
+		}
+
+		Batch *batch = new Batch();
+
+		VkCommandBufferAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocate_info.commandPool = graphics_pool;
+		allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocate_info.commandBufferCount = 1;
+
+		VkResult result = vkAllocateCommandBuffers(device->getDevice(), &allocate_info, &batch->graphics_commands);
+		assert((result == VK_SUCCESS) && "Can't allocate command buffer");
+
+		if (dedicated_transfer)
+		{
+			allocate_info.commandPool = transfer_pool;
+
+			result = vkAllocateCommandBuffers(device->getDevice(), &allocate_info, &batch->transfer_commands);
+			assert((result == VK_SUCCESS) && "Can't allocate command buffer");
+
+			VkSemaphoreCreateInfo semaphore_info = {};
+			semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			result = vkCreateSemaphore(device->getDevice(), &semaphore_info, nullptr, &batch->transfer_finished);
+			assert((result == VK_SUCCESS) && "Can't create semaphore");
+		}
+
+		VkFenceCreateInfo fence_info = {};
+		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		result = vkCreateFence(device->getDevice(), &fence_info, nullptr, &batch->fence);
+		assert((result == VK_SUCCESS) && "Can't create fence");
+
+		return batch;
+	}
+
+	void UploadContext::resetBatch(Batch *batch)
+	{
+		vkResetFences(device->getDevice(), 1, &batch->fence);
+		vkResetCommandBuffer(batch->graphics_commands, 0);
+
+		if (batch->transfer_commands != VK_NULL_HANDLE)
+			vkResetCommandBuffer(batch->transfer_commands, 0);
+
+		batch->ticket = 0;
+
+		// keep a single regular chunk for the next batch, release the rest
+		while (!batch->staging_chunks.empty())
+		{
+			StagingChunk &chunk = batch->staging_chunks.back();
+			if (batch->staging_chunks.size() == 1 && chunk.size == STAGING_CHUNK_SIZE)
+				break;
+
+			destroyStagingChunk(batch, chunk);
+			batch->staging_chunks.pop_back();
+		}
+
+		for (StagingChunk &chunk : batch->staging_chunks)
+			chunk.offset = 0;
+	}
+
+	void UploadContext::destroyBatch(Batch *batch)
+	{
+		for (StagingChunk &chunk : batch->staging_chunks)
+			destroyStagingChunk(batch, chunk);
+
+		batch->staging_chunks.clear();
+
+		vkDestroyFence(device->getDevice(), batch->fence, nullptr);
+		vkDestroySemaphore(device->getDevice(), batch->transfer_finished, nullptr);
+
+		vkFreeCommandBuffers(device->getDevice(), graphics_pool, 1, &batch->graphics_commands);
+
+		if (batch->transfer_commands != VK_NULL_HANDLE)
+			vkFreeCommandBuffers(device->getDevice(), transfer_pool, 1, &batch->transfer_commands);
+
+		delete batch;
+	}
+
+	/*
+	 */
+	bool UploadContext::createStagingChunk(Batch *batch, VkDeviceSize size)
+	{
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = size;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo alloc_info = {};
+		alloc_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+		alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		StagingChunk chunk;
+		VmaAllocationInfo allocation_info = {};
+
+		if (vmaCreateBuffer(device->getVRAMAllocator(), &buffer_info, &alloc_info, &chunk.buffer, &chunk.memory, &allocation_info) != VK_SUCCESS)
+			return false;
+
+		device->getMemoryTracker()->add(chunk.memory, MemoryCategory::STAGING);
+
+		chunk.data = reinterpret_cast<uint8_t *>(allocation_info.pMappedData);
+		chunk.size = size;
+		chunk.offset = 0;
+
+		batch->staging_chunks.push_back(chunk);
+		batch->staging_size += size;
+
+		return true;
+	}
+
+	void UploadContext::destroyStagingChunk(Batch *batch, StagingChunk &chunk)
+	{
+		device->getMemoryTracker()->remove(chunk.memory);
+		vmaDestroyBuffer(device->getVRAMAllocator(), chunk.buffer, chunk.memory);
+		batch->staging_size -= chunk.size;
+
+		chunk.buffer = VK_NULL_HANDLE;
+		chunk.memory = VK_NULL_HANDLE;
+		chunk.data = nullptr;
+		chunk.size = 0;
+		chunk.offset = 0;
+	}
+}
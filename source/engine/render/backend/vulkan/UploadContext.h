@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+namespace render::backend::vulkan
+{
+	class Device;
+
+	/*
+	 * Records resource uploads into batches. Copies go to the transfer queue
+	 * (if the device has a dedicated one) and are handed over to the graphics
+	 * queue with queue family ownership transfers. Each thread is expected to
+	 * use its own context, contexts own their command pools.
+	 */
+	class UploadContext
+	{
+	public:
+		UploadContext(const Device *device)
+			: device(device) { }
+		~UploadContext();
+
+		void beginBatch();
+		bool endBatch();
+		uint64_t endBatchAsync();
+		inline bool isBatching() const { return num_batches > 0; }
+
+		bool isComplete(uint64_t ticket);
+
+		void fillBuffer(
+			VkBuffer buffer,
+			VkDeviceSize size,
+			const void *data
+		);
+
+		// suballocated buffers are written on the graphics queue, other ranges may be in use
+		void fillBufferRange(
+			VkBuffer buffer,
+			VkDeviceSize offset,
+			VkDeviceSize size,
+			const void *data
+		);
+
+		void copyBuffer(
+			VkBuffer src_buffer,
+			VkBuffer dst_buffer,
+			uint32_t num_regions,
+			const VkBufferCopy *regions
+		);
+
+		void fillImage(
+			VkImage image,
+			uint32_t width,
+			uint32_t height,
+			uint32_t depth,
+			uint32_t pixel_size,
+			const void *data,
+			uint32_t num_data_mipmaps,
+			uint32_t num_data_layers
+		);
+
+		void transitionImageLayout(
+			VkImage image,
+			VkFormat format,
+			VkImageLayout old_layout,
+			VkImageLayout new_layout,
+			uint32_t base_mip = 0,
+			uint32_t num_mips = 1,
+			uint32_t base_layer = 0,
+			uint32_t num_layers = 1
+		);
+
+		void generateImage2DMipmaps(
+			VkImage image,
+			VkFormat format,
+			uint32_t width,
+			uint32_t height,
+			uint32_t num_mips,
+			VkFilter filter
+		);
+
+	private:
+		struct StagingChunk
+		{
+			VkBuffer buffer {VK_NULL_HANDLE};
+			VmaAllocation memory {VK_NULL_HANDLE};
+			uint8_t *data {nullptr};
+			VkDeviceSize size {0};
+			VkDeviceSize offset {0};
+		};
+
+		struct Batch
+		{
+			VkCommandBuffer transfer_commands {VK_NULL_HANDLE};
+			VkCommandBuffer graphics_commands {VK_NULL_HANDLE};
+			bool transfer_recording {false};
+			bool graphics_recording {false};
+
+			VkSemaphore transfer_finished {VK_NULL_HANDLE};
+			VkFence fence {VK_NULL_HANDLE};
+			uint64_t ticket {0};
+
+			std::vector<StagingChunk> staging_chunks;
+			VkDeviceSize staging_size {0};
+		};
+
+		Batch *getBatch();
+		VkCommandBuffer getTransferCommands();
+		VkCommandBuffer getGraphicsCommands();
+		VkCommandBuffer beginCommands(VkCommandBuffer command_buffer, bool &recording);
+
+		void releaseBuffers();
+		void releaseImage(
+			VkImage image,
+			VkFormat format,
+			VkImageLayout old_layout,
+			VkImageLayout new_layout,
+			uint32_t base_mip,
+			uint32_t num_mips,
+			uint32_t base_layer,
+			uint32_t num_layers
+		);
+
+		uint8_t *allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &buffer, VkDeviceSize &offset);
+		bool submit();
+		bool wait(uint64_t ticket);
+		void retire();
+
+		Batch *createBatch();
+		void resetBatch(Batch *batch);
+		void destroyBatch(Batch *batch);
+
+		bool createStagingChunk(Batch *batch, VkDeviceSize size);
+		void destroyStagingChunk(Batch *batch, StagingChunk &chunk);
+
+	private:
+		enum
+		{
+			STAGING_CHUNK_SIZE = 32 * 1024 * 1024,
+			MAX_STAGING_SIZE = 256 * 1024 * 1024, // batch is submitted early once staging grows past this
+		};
+
+		static std::atomic<uint64_t> next_ticket;
+
+		const Device *device {nullptr};
+
+		VkCommandPool transfer_pool {VK_NULL_HANDLE};
+		VkCommandPool graphics_pool {VK_NULL_HANDLE};
+
+		Batch *current_batch {nullptr};
+		std::vector<Batch *> free_batches;
+		std::vector<Batch *> in_flight_batches;
+		std::mutex in_flight_mutex;
+
+		uint32_t num_batches {0};
+		uint64_t last_ticket {0};
+
+		// resources written on the transfer queue that still need to be acquired by graphics
+		std::vector<VkBuffer> released_buffers;
+		std::vector<VkImage> released_images;
+	};
+}
@@ -22,6 +22,32 @@ namespace render::backend::vulkan
 		return supported_wrap_modes[static_cast<int>(mode)];
 	}
 
+	VkFilter Utils::getSamplerFilter(
+		SamplerFilter filter
+	)
+	{
+		static VkFilter supported_filters[static_cast<int>(SamplerFilter::MAX)] =
+		{
+			VK_FILTER_NEAREST,
+			VK_FILTER_LINEAR,
+		};
+
+		return supported_filters[static_cast<int>(filter)];
+	}
+
+	VkSamplerMipmapMode Utils::getSamplerMipmapMode(
+		SamplerFilter filter
+	)
+	{
+		static VkSamplerMipmapMode supported_mipmap_modes[static_cast<int>(SamplerFilter::MAX)] =
+		{
+			VK_SAMPLER_MIPMAP_MODE_NEAREST,
+			VK_SAMPLER_MIPMAP_MODE_LINEAR,
+		};
+
+		return supported_mipmap_modes[static_cast<int>(filter)];
+	}
+
 	/*
 	 */
 	VkFormat Utils::getFormat(Format format)
@@ -316,6 +342,20 @@ namespace render::backend::vulkan
 		}
 	}
 
+	VkSubpassContents Utils::getSubpassContents(RenderPassContents contents)
+	{
+		switch (contents)
+		{
+			case RenderPassContents::INLINE: return VK_SUBPASS_CONTENTS_INLINE;
+			case RenderPassContents::SECONDARY_COMMAND_BUFFERS: return VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+			default:
+			{
+				std::cerr << "vulkan::Utils::getSubpassContents(): unsupported render pass contents" << std::endl;
+				return VK_SUBPASS_CONTENTS_INLINE;
+			}
+		}
+	}
+
 	/*
 	 */
 	VkCullModeFlags Utils::getCullMode(CullMode mode)
@@ -595,6 +635,38 @@ namespace render::backend::vulkan
 		return 0xFFFF;
 	}
 
+	uint32_t Utils::getTransferQueueFamily(
+		VkPhysicalDevice physicalDevice,
+		uint32_t graphicsQueueFamily
+	)
+	{
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		// prefer pure transfer families (DMA engines), then async compute ones
+		uint32_t fallback = graphicsQueueFamily;
+
+		for (uint32_t i = 0; i < queueFamilyCount; i++) {
+			const auto &queueFamily = queueFamilies[i];
+			if (queueFamily.queueCount == 0 || !(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT))
+				continue;
+
+			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+				continue;
+
+			if (!(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT))
+				return i;
+
+			if (fallback == graphicsQueueFamily)
+				fallback = i;
+		}
+
+		return fallback;
+	}
+
 	uint32_t Utils::getPresentQueueFamily(
 		VkPhysicalDevice physicalDevice,
 		VkSurfaceKHR surface,
@@ -805,43 +877,81 @@ namespace render::backend::vulkan
 		return result;
 	}
 
-	VkSampler Utils::createSampler(
-		const Device *device,
-		uint32_t minMipLevel,
-		uint32_t maxMipLevel,
-		VkSamplerAddressMode addressModeU,
-		VkSamplerAddressMode addressModeV,
-		VkSamplerAddressMode addressModeW,
-		bool depthCompareEnabled,
-		VkCompareOp depthCompareFunc
+	/*
+	 */
+	VkDeviceSize Utils::getImageDataSize(
+		uint32_t width,
+		uint32_t height,
+		uint32_t depth,
+		uint32_t pixelSize,
+		uint32_t dataMipLevels,
+		uint32_t dataArrayLayers
 	)
 	{
-		VkSamplerCreateInfo samplerInfo = {};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
-		samplerInfo.addressModeU = addressModeU;
-		samplerInfo.addressModeV = addressModeV;
-		samplerInfo.addressModeW = addressModeW;
-		samplerInfo.anisotropyEnable = VK_FALSE;
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
-		samplerInfo.compareEnable = depthCompareEnabled;
-		samplerInfo.compareOp = depthCompareFunc;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;
-		samplerInfo.minLod = static_cast<float>(minMipLevel);
-		samplerInfo.maxLod = static_cast<float>(maxMipLevel);
-
-		VkSampler sampler = VK_NULL_HANDLE;
-		if (vkCreateSampler(device->getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
-			return VK_NULL_HANDLE;
+		VkDeviceSize resource_size = 0;
+		uint32_t mip_width = width;
+		uint32_t mip_height = height;
+		uint32_t mip_depth = depth;
+
+		for (uint32_t i = 0; i < dataMipLevels; i++)
+		{
+			resource_size += mip_width * mip_height * mip_depth * pixelSize;
+			mip_width = std::max<uint32_t>(mip_width / 2, 1);
+			mip_height = std::max<uint32_t>(mip_height / 2, 1);
+			mip_depth = std::max<uint32_t>(mip_depth / 2, 1);
+		}
 
-		return sampler;
+		return resource_size * dataArrayLayers;
+	}
+
+	void Utils::copyBufferToImage(
+		VkCommandBuffer commandBuffer,
+		VkBuffer srcBuffer,
+		VkDeviceSize srcOffset,
+		VkImage image,
+		uint32_t width,
+		uint32_t height,
+		uint32_t depth,
+		uint32_t pixelSize,
+		uint32_t dataMipLevels,
+		uint32_t dataArrayLayers
+	)
+	{
+		VkDeviceSize offset = srcOffset;
+
+		for (uint32_t i = 0; i < dataArrayLayers; i++)
+		{
+			uint32_t mip_width = width;
+			uint32_t mip_height = height;
+			uint32_t mip_depth = depth;
+
+			for (uint32_t j = 0; j < dataMipLevels; j++)
+			{
+				VkBufferImageCopy region = {};
+				region.bufferOffset = offset;
+				region.bufferRowLength = 0;
+				region.bufferImageHeight = 0;
+
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = j;
+				region.imageSubresource.baseArrayLayer = i;
+				region.imageSubresource.layerCount = 1;
+
+				region.imageOffset = {0, 0, 0};
+				region.imageExtent.width = mip_width;
+				region.imageExtent.height = mip_height;
+				region.imageExtent.depth = mip_depth;
+
+				vkCmdCopyBufferToImage(commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+				offset += mip_width * mip_height * mip_depth * pixelSize;
+				mip_width = std::max<uint32_t>(mip_width / 2, 1);
+				mip_height = std::max<uint32_t>(mip_height / 2, 1);
+				mip_depth = std::max<uint32_t>(mip_depth / 2, 1);
+			}
+		}
 	}
 
-	/*
-	 */
 	void Utils::fillImage(
 		const Device *device,
 		VkImage image,
@@ -857,18 +967,7 @@ namespace render::backend::vulkan
 		uint32_t dataArrayLayers
 	)
 	{
-		VkDeviceSize resource_size = 0;
-		uint32_t mip_width = width;
-		uint32_t mip_height = height;
-		uint32_t mip_depth = depth;
-
-		for (uint32_t i = 0; i < dataMipLevels; i++)
-		{
-			resource_size += mip_width * mip_height * pixelSize;
-			mip_width = std::max<int>(mip_width / 2, 1);
-			mip_height = std::max<int>(mip_height / 2, 1);
-			mip_depth = std::max<int>(mip_depth / 2, 1);
-		}
+		VkDeviceSize resource_size = getImageDataSize(width, height, depth, pixelSize, dataMipLevels, dataArrayLayers);
 
 		// Create staging buffer
 		VkBuffer staging_buffer = VK_NULL_HANDLE;
@@ -876,7 +975,7 @@ namespace render::backend::vulkan
 
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = resource_size * dataArrayLayers;
+		bufferInfo.size = resource_size;
 		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -891,44 +990,13 @@ namespace render::backend::vulkan
 		// Fill staging buffer
 		void *staging_data = nullptr;
 		vmaMapMemory(device->getVRAMAllocator(), staging_memory, &staging_data);
-		memcpy(staging_data, data, static_cast<size_t>(resource_size * dataArrayLayers));
+		memcpy(staging_data, data, static_cast<size_t>(resource_size));
 		vmaUnmapMemory(device->getVRAMAllocator(), staging_memory);
 
 		// Copy to the image memory on GPU
-		VkDeviceSize offset = 0;
-
 		VkCommandBuffer command_buffer = beginSingleTimeCommands(device);
 
-		for (uint32_t i = 0; i < dataArrayLayers; i++)
-		{
-			mip_width = width;
-			mip_height = height;
-			mip_depth = depth;
-
-			for (uint32_t j = 0; j < dataMipLevels; j++)
-			{
-				VkBufferImageCopy region = {};
-				region.bufferOffset = offset;
-				region.bufferRowLength = 0;
-				region.bufferImageHeight = 0;
-
-				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				region.imageSubresource.mipLevel = j;
-				region.imageSubresource.baseArrayLayer = i;
-				region.imageSubresource.layerCount = 1;
-
-				region.imageOffset = {0, 0, 0};
-				region.imageExtent.width = width;
-				region.imageExtent.height = height;
-				region.imageExtent.depth = 1;
-
-				vkCmdCopyBufferToImage(command_buffer, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-				offset += mip_width * mip_height * mip_depth * pixelSize;
-				mip_width /= 2;
-				mip_height /= 2;
-			}
-		}
+		copyBufferToImage(command_buffer, staging_buffer, 0, image, width, height, depth, pixelSize, dataMipLevels, dataArrayLayers);
 
 		Utils::endSingleTimeCommands(device, command_buffer);
 
@@ -946,6 +1014,26 @@ namespace render::backend::vulkan
 		VkFormat format,
 		VkFilter filter
 	)
+	{
+		if (mipLevels == 1)
+			return;
+
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands(device);
+		generateImage2DMipmaps(device, commandBuffer, image, imageFormat, width, height, mipLevels, format, filter);
+		endSingleTimeCommands(device, commandBuffer);
+	}
+
+	void Utils::generateImage2DMipmaps(
+		const Device *device,
+		VkCommandBuffer commandBuffer,
+		VkImage image,
+		VkFormat imageFormat,
+		uint32_t width,
+		uint32_t height,
+		uint32_t mipLevels,
+		VkFormat format,
+		VkFilter filter
+	)
 	{
 		if (mipLevels == 1)
 			return;
@@ -963,8 +1051,6 @@ namespace render::backend::vulkan
 			throw std::runtime_error("Cubic filtering is not supported on this device");
 
 		// generate mips
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands(device);
-
 		VkImageMemoryBarrier barrier = {};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.image = image;
@@ -1035,8 +1121,6 @@ namespace render::backend::vulkan
 			mipWidth = std::max(1, mipWidth / 2);
 			mipHeight = std::max(1, mipHeight / 2);
 		}
-
-		endSingleTimeCommands(device, commandBuffer);
 	}
 
 	/*
@@ -1052,6 +1136,23 @@ namespace render::backend::vulkan
 		uint32_t base_layer,
 		uint32_t num_layers
 	)
+	{
+		VkCommandBuffer command_buffer = beginSingleTimeCommands(device);
+		transitionImageLayout(command_buffer, image, format, old_layout, new_layout, base_mip, num_mips, base_layer, num_layers);
+		endSingleTimeCommands(device, command_buffer);
+	}
+
+	void Utils::transitionImageLayout(
+		VkCommandBuffer command_buffer,
+		VkImage image,
+		VkFormat format,
+		VkImageLayout old_layout,
+		VkImageLayout new_layout,
+		uint32_t base_mip,
+		uint32_t num_mips,
+		uint32_t base_layer,
+		uint32_t num_layers
+	)
 	{
 		struct LayoutTransition
 		{
@@ -1071,8 +1172,6 @@ namespace render::backend::vulkan
 			{ VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT },
 		};
 
-		VkCommandBuffer command_buffer = beginSingleTimeCommands(device);
-
 		VkImageMemoryBarrier barrier = {};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.oldLayout = old_layout;
@@ -1122,8 +1221,6 @@ namespace render::backend::vulkan
 			0, nullptr,
 			1, &barrier
 		);
-
-		endSingleTimeCommands(device, command_buffer);
 	}
 
 	/*
@@ -1166,8 +1263,12 @@ namespace render::backend::vulkan
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
-		result = vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, fence);
-		assert((result == VK_SUCCESS) && "Can't submit command buffer");
+		{
+			std::lock_guard<std::mutex> lock(device->getQueueMutex());
+
+			result = vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, fence);
+			assert((result == VK_SUCCESS) && "Can't submit command buffer");
+		}
 		
 		result = vkWaitForFences(device->getDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
 		assert((result == VK_SUCCESS) && "Can't wait for a fence");
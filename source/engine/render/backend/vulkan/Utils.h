@@ -14,6 +14,14 @@ namespace render::backend::vulkan
 			SamplerWrapMode mode
 		);
 
+		static VkFilter getSamplerFilter(
+			SamplerFilter filter
+		);
+
+		static VkSamplerMipmapMode getSamplerMipmapMode(
+			SamplerFilter filter
+		);
+
 		static VkFormat getFormat(
 			Format format
 		);
@@ -61,6 +69,10 @@ namespace render::backend::vulkan
 		static VkCommandBufferLevel getCommandBufferLevel(
 			CommandBufferType type
 		);
+		
+		static VkSubpassContents getSubpassContents(
+			RenderPassContents contents
+		);
 
 		static VkCullModeFlags getCullMode(
 			CullMode mode
@@ -117,6 +129,11 @@ namespace render::backend::vulkan
 			VkPhysicalDevice physicalDevice
 		);
 
+		static uint32_t getTransferQueueFamily(
+			VkPhysicalDevice physicalDevice,
+			uint32_t graphicsQueueFamily
+		);
+
 		static uint32_t getPresentQueueFamily(
 			VkPhysicalDevice physicalDevice,
 			VkSurfaceKHR surface,
@@ -178,15 +195,26 @@ namespace render::backend::vulkan
 			uint32_t num_layers = 1
 		);
 
-		static VkSampler createSampler(
-			const Device *device,
-			uint32_t minMipLevel,
-			uint32_t maxMipLevel,
-			VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-			VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-			VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-			bool depthCompareEnabled = false,
-			VkCompareOp depthCompareFunc = VK_COMPARE_OP_ALWAYS
+		static VkDeviceSize getImageDataSize(
+			uint32_t width,
+			uint32_t height,
+			uint32_t depth,
+			uint32_t pixelSize,
+			uint32_t dataMipLevels,
+			uint32_t dataArrayLayers
+		);
+
+		static void copyBufferToImage(
+			VkCommandBuffer commandBuffer,
+			VkBuffer srcBuffer,
+			VkDeviceSize srcOffset,
+			VkImage image,
+			uint32_t width,
+			uint32_t height,
+			uint32_t depth,
+			uint32_t pixelSize,
+			uint32_t dataMipLevels,
+			uint32_t dataArrayLayers
 		);
 
 		static void fillImage(
@@ -215,6 +243,18 @@ namespace render::backend::vulkan
 			VkFilter filter
 		);
 
+		static void generateImage2DMipmaps(
+			const Device *device,
+			VkCommandBuffer commandBuffer,
+			VkImage image,
+			VkFormat imageFormat,
+			uint32_t width,
+			uint32_t height,
+			uint32_t mipLevels,
+			VkFormat format,
+			VkFilter filter
+		);
+
 		static void transitionImageLayout(
 			const Device *device,
 			VkImage image,
@@ -227,6 +267,18 @@ namespace render::backend::vulkan
 			uint32_t numLayers = 1
 		);
 
+		static void transitionImageLayout(
+			VkCommandBuffer commandBuffer,
+			VkImage image,
+			VkFormat format,
+			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			uint32_t baseMipLevel = 0,
+			uint32_t numMipLevels = 1,
+			uint32_t baseLayer = 0,
+			uint32_t numLayers = 1
+		);
+
 		static VkCommandBuffer beginSingleTimeCommands(
 			const Device *context
 		);
@@ -1,10 +1,12 @@
 #include "render/backend/vulkan/Device.h"
+#include "render/backend/vulkan/MemoryTracker.h"
 #include "render/backend/vulkan/Platform.h"
 #include "render/backend/vulkan/Utils.h"
 
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <iostream>
@@ -12,25 +14,44 @@
 
 namespace render::backend::vulkan
 {
-	/*
-	 */
-	static int maxCombinedImageSamplers = 32;
-	static int maxUniformBuffers = 32;
-	static int maxDescriptorSets = 512;
-
 	/*
 	 */
 	static std::vector<const char*> requiredInstanceExtensions = {
 		VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+	};
+
+	// not needed by headless devices, platform surface extension is added on init
+	static std::vector<const char*> surfaceInstanceExtensions = {
 		VK_KHR_SURFACE_EXTENSION_NAME,
 	};
 
 	/*
 	 */
-	static std::vector<const char*> requiredPhysicalDeviceExtensions = {
+	static std::vector<const char*> surfacePhysicalDeviceExtensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 	};
 
+	/*
+	 */
+	static std::vector<const char*> descriptorIndexingInstanceExtensions = {
+		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+	};
+
+	static std::vector<const char*> descriptorIndexingPhysicalDeviceExtensions = {
+		VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+		VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+	};
+
+	static std::vector<const char*> drawIndirectCountPhysicalDeviceExtensions = {
+		VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+	};
+
+	static std::vector<const char*> memoryBudgetPhysicalDeviceExtensions = {
+		VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+	};
+
+	static constexpr uint32_t MAX_BINDLESS_TEXTURES = 16384;
+
 #ifdef SCAPES_VULKAN_USE_VALIDATION_LAYERS
 	static std::vector<const char *> requiredValidationLayers = {
 		"VK_LAYER_KHRONOS_validation",
@@ -51,16 +72,35 @@ namespace render::backend::vulkan
 
 	/*
 	 */
-	void Device::init(const char *applicationName, const char *engineName)
+	void Device::init(const char *applicationName, const char *engineName, bool headless)
 	{
 		if (volkInitialize() != VK_SUCCESS)
 			throw std::runtime_error("Can't initialize Vulkan helper library");
 
+		this->headless = headless;
+
 		// Check required instance extensions
-		requiredInstanceExtensions.push_back(render::backend::vulkan::Platform::getInstanceExtension());
-		if (!Utils::checkInstanceExtensions(requiredInstanceExtensions, true))
+		std::vector<const char*> instanceExtensions = requiredInstanceExtensions;
+
+		if (!headless)
+		{
+			const char *platformExtension = render::backend::vulkan::Platform::getInstanceExtension();
+			if (platformExtension == nullptr)
+				throw std::runtime_error("Windowed rendering is not supported on this platform, use headless mode");
+
+			instanceExtensions.insert(instanceExtensions.end(), surfaceInstanceExtensions.begin(), surfaceInstanceExtensions.end());
+			instanceExtensions.push_back(platformExtension);
+		}
+
+		if (!Utils::checkInstanceExtensions(instanceExtensions, true))
 			throw std::runtime_error("This device doesn't have required Vulkan extensions");
 
+		// Optional instance extensions, needed to query descriptor indexing features
+
+		bool hasPhysicalDeviceProperties2 = Utils::checkInstanceExtensions(descriptorIndexingInstanceExtensions);
+		if (hasPhysicalDeviceProperties2)
+			instanceExtensions.insert(instanceExtensions.end(), descriptorIndexingInstanceExtensions.begin(), descriptorIndexingInstanceExtensions.end());
+
 #if SCAPES_VULKAN_USE_VALIDATION_LAYERS
 		// Check required instance validation layers
 		if (!Utils::checkInstanceValidationLayers(requiredValidationLayers, true))
@@ -86,8 +126,8 @@ namespace render::backend::vulkan
 		VkInstanceCreateInfo instanceInfo = {};
 		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 		instanceInfo.pApplicationInfo = &appInfo;
-		instanceInfo.enabledExtensionCount = static_cast<uint32_t>(requiredInstanceExtensions.size());
-		instanceInfo.ppEnabledExtensionNames = requiredInstanceExtensions.data();
+		instanceInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+		instanceInfo.ppEnabledExtensionNames = instanceExtensions.data();
 		instanceInfo.pNext = &debugMessengerInfo;
 
 #if SCAPES_VULKAN_USE_VALIDATION_LAYERS
@@ -137,25 +177,95 @@ namespace render::backend::vulkan
 
 		// Create logical device
 		graphicsQueueFamily = Utils::getGraphicsQueueFamily(physicalDevice);
+		transferQueueFamily = Utils::getTransferQueueFamily(physicalDevice, graphicsQueueFamily);
 		const float queuePriority = 1.0f;
 
-		VkDeviceQueueCreateInfo graphicsQueueInfo = {};
+		std::array<VkDeviceQueueCreateInfo, 2> queueInfos = {};
+		uint32_t numQueueInfos = 1;
+
+		VkDeviceQueueCreateInfo &graphicsQueueInfo = queueInfos[0];
 		graphicsQueueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		graphicsQueueInfo.queueFamilyIndex = graphicsQueueFamily;
 		graphicsQueueInfo.queueCount = 1;
 		graphicsQueueInfo.pQueuePriorities = &queuePriority;
 
+		if (transferQueueFamily != graphicsQueueFamily)
+		{
+			VkDeviceQueueCreateInfo &transferQueueInfo = queueInfos[numQueueInfos++];
+			transferQueueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			transferQueueInfo.queueFamilyIndex = transferQueueFamily;
+			transferQueueInfo.queueCount = 1;
+			transferQueueInfo.pQueuePriorities = &queuePriority;
+		}
+
+		VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
+		vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 		deviceFeatures.sampleRateShading = VK_TRUE;
 
+		// Optional indirect draw features, draws are split into single ones otherwise
+		multiDrawIndirect = physicalDeviceFeatures.multiDrawIndirect && physicalDeviceFeatures.drawIndirectFirstInstance;
+		deviceFeatures.multiDrawIndirect = multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = multiDrawIndirect;
+
+		// Optional GPU profiling
+		pipelineStatistics = physicalDeviceFeatures.pipelineStatisticsQuery;
+		deviceFeatures.pipelineStatisticsQuery = pipelineStatistics;
+
+		std::vector<const char*> physicalDeviceExtensions;
+		if (!headless)
+			physicalDeviceExtensions = surfacePhysicalDeviceExtensions;
+
+		drawIndirectCount = Utils::checkPhysicalDeviceExtensions(physicalDevice, drawIndirectCountPhysicalDeviceExtensions);
+		if (drawIndirectCount)
+			physicalDeviceExtensions.insert(physicalDeviceExtensions.end(), drawIndirectCountPhysicalDeviceExtensions.begin(), drawIndirectCountPhysicalDeviceExtensions.end());
+
+		// Optional memory budget, heap usage is estimated by the allocator otherwise
+		memoryBudget = hasPhysicalDeviceProperties2 && Utils::checkPhysicalDeviceExtensions(physicalDevice, memoryBudgetPhysicalDeviceExtensions);
+		if (memoryBudget)
+			physicalDeviceExtensions.insert(physicalDeviceExtensions.end(), memoryBudgetPhysicalDeviceExtensions.begin(), memoryBudgetPhysicalDeviceExtensions.end());
+
+		// Optional descriptor indexing, enables bindless textures
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+		if (hasPhysicalDeviceProperties2 && checkDescriptorIndexingSupport(physicalDevice))
+		{
+			physicalDeviceExtensions.insert(physicalDeviceExtensions.end(), descriptorIndexingPhysicalDeviceExtensions.begin(), descriptorIndexingPhysicalDeviceExtensions.end());
+
+			descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+			descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+
+			VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties = {};
+			descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+			VkPhysicalDeviceProperties2KHR properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+			properties.pNext = &descriptorIndexingProperties;
+
+			vkGetPhysicalDeviceProperties2KHR(physicalDevice, &properties);
+
+			maxBindlessTextures = MAX_BINDLESS_TEXTURES;
+			maxBindlessTextures = std::min(maxBindlessTextures, descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages);
+			maxBindlessTextures = std::min(maxBindlessTextures, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+		}
+
 		VkDeviceCreateInfo deviceCreateInfo = {};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
-		deviceCreateInfo.queueCreateInfoCount = 1;
-		deviceCreateInfo.pQueueCreateInfos = &graphicsQueueInfo;
-		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(requiredPhysicalDeviceExtensions.size());
-		deviceCreateInfo.ppEnabledExtensionNames = requiredPhysicalDeviceExtensions.data();
+		deviceCreateInfo.queueCreateInfoCount = numQueueInfos;
+		deviceCreateInfo.pQueueCreateInfos = queueInfos.data();
+		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(physicalDeviceExtensions.size());
+		deviceCreateInfo.ppEnabledExtensionNames = physicalDeviceExtensions.data();
+
+		if (maxBindlessTextures > 0)
+			deviceCreateInfo.pNext = &descriptorIndexingFeatures;
 
 		// next two parameters are ignored, but it's still good to pass layers for backward compatibility
 #if SCAPES_VULKAN_USE_VALIDATION_LAYERS
@@ -174,6 +284,14 @@ namespace render::backend::vulkan
 		if (graphicsQueue == VK_NULL_HANDLE)
 			throw std::runtime_error("Can't get graphics queue from logical device");
 
+		// Get transfer queue, falls back to graphics queue if there's no dedicated family
+		transferQueue = graphicsQueue;
+		if (transferQueueFamily != graphicsQueueFamily)
+			vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+
+		if (transferQueue == VK_NULL_HANDLE)
+			throw std::runtime_error("Can't get transfer queue from logical device");
+
 		// Create command pool
 		VkCommandPoolCreateInfo commandPoolInfo = {};
 		commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -183,42 +301,43 @@ namespace render::backend::vulkan
 		if (vkCreateCommandPool(device, &commandPoolInfo, nullptr, &commandPool) != VK_SUCCESS)
 			throw std::runtime_error("Can't create command pool");
 
-		// Create descriptor pools
-		std::array<VkDescriptorPoolSize, 2> descriptorPoolSizes = {};
-		descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorPoolSizes[0].descriptorCount = maxUniformBuffers;
-		descriptorPoolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorPoolSizes[1].descriptorCount = maxCombinedImageSamplers;
+		maxMSAASamples = Utils::getMaxUsableSampleCount(physicalDevice);
 
-		VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
-		descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
-		descriptorPoolInfo.pPoolSizes = descriptorPoolSizes.data();
-		descriptorPoolInfo.maxSets = maxDescriptorSets;
-		descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		// Timestamps are written by the graphics queue only
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
 
-		if (vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
-			throw std::runtime_error("Can't create descriptor pool");
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
 
-		maxMSAASamples = Utils::getMaxUsableSampleCount(physicalDevice);
+		VkPhysicalDeviceProperties physicalDeviceProperties = {};
+		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+		timestampValidBits = queueFamilies[graphicsQueueFamily].timestampValidBits;
+		timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
 
 		VmaAllocatorCreateInfo allocatorInfo = {};
 		allocatorInfo.physicalDevice = physicalDevice;
 		allocatorInfo.device = device;
 		allocatorInfo.instance = instance;
 
+		if (memoryBudget)
+			allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+
 		if (vmaCreateAllocator(&allocatorInfo, &vram_allocator) != VK_SUCCESS)
 			throw std::runtime_error("Can't create VRAM allocator");
+
+		memoryTracker = new MemoryTracker(vram_allocator);
 	}
 
 	void Device::shutdown()
 	{
+		delete memoryTracker;
+		memoryTracker = nullptr;
+
 		vmaDestroyAllocator(vram_allocator);
 		vram_allocator = VK_NULL_HANDLE;
 
-		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-		descriptorPool = VK_NULL_HANDLE;
-
 		vkDestroyCommandPool(device, commandPool, nullptr);
 		commandPool = VK_NULL_HANDLE;
 
@@ -234,7 +353,18 @@ namespace render::backend::vulkan
 		graphicsQueueFamily = 0xFFFF;
 		graphicsQueue = VK_NULL_HANDLE;
 
+		transferQueueFamily = 0xFFFF;
+		transferQueue = VK_NULL_HANDLE;
+
 		maxMSAASamples = VK_SAMPLE_COUNT_1_BIT;
+		maxBindlessTextures = 0;
+		multiDrawIndirect = false;
+		drawIndirectCount = false;
+		timestampValidBits = 0;
+		timestampPeriod = 0.0f;
+		pipelineStatistics = false;
+		memoryBudget = false;
+		headless = false;
 		physicalDevice = VK_NULL_HANDLE;
 	}
 
@@ -242,7 +372,7 @@ namespace render::backend::vulkan
 	 */
 	int Device::examinePhysicalDevice(VkPhysicalDevice physicalDevice) const
 	{
-		if (!Utils::checkPhysicalDeviceExtensions(physicalDevice, requiredPhysicalDeviceExtensions))
+		if (!headless && !Utils::checkPhysicalDeviceExtensions(physicalDevice, surfacePhysicalDeviceExtensions))
 			return -1;
 
 		VkPhysicalDeviceProperties physicalDeviceProperties;
@@ -273,4 +403,25 @@ namespace render::backend::vulkan
 		return estimate;
 	}
 
+	bool Device::checkDescriptorIndexingSupport(VkPhysicalDevice physicalDevice) const
+	{
+		if (!Utils::checkPhysicalDeviceExtensions(physicalDevice, descriptorIndexingPhysicalDeviceExtensions))
+			return false;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2KHR features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+		features.pNext = &descriptorIndexingFeatures;
+
+		vkGetPhysicalDeviceFeatures2KHR(physicalDevice, &features);
+
+		return descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing
+			&& descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+			&& descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending
+			&& descriptorIndexingFeatures.descriptorBindingPartiallyBound
+			&& descriptorIndexingFeatures.runtimeDescriptorArray;
+	}
+
 }
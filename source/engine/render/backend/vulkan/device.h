@@ -3,10 +3,13 @@
 #include <volk.h>
 #include <vk_mem_alloc.h>
 
+#include <mutex>
 #include <optional>
 
 namespace render::backend::vulkan
 {
+	class MemoryTracker;
+
 	/*
 	 */
 	class Device
@@ -16,14 +19,28 @@ namespace render::backend::vulkan
 		inline VkDevice getDevice() const { return device; }
 		inline VkPhysicalDevice getPhysicalDevice() const { return physicalDevice; }
 		inline VkCommandPool getCommandPool() const { return commandPool; }
-		inline VkDescriptorPool getDescriptorPool() const { return descriptorPool; }
 		inline uint32_t getGraphicsQueueFamily() const { return graphicsQueueFamily; }
 		inline VkQueue getGraphicsQueue() const { return graphicsQueue; }
+		inline uint32_t getTransferQueueFamily() const { return transferQueueFamily; }
+		inline VkQueue getTransferQueue() const { return transferQueue; }
+		inline bool hasDedicatedTransferQueue() const { return transferQueueFamily != graphicsQueueFamily; }
+		inline std::mutex &getQueueMutex() const { return queueMutex; }
 		inline VkSampleCountFlagBits getMaxSampleCount() const { return maxMSAASamples; }
+		inline bool hasDescriptorIndexing() const { return maxBindlessTextures > 0; }
+		inline uint32_t getMaxBindlessTextures() const { return maxBindlessTextures; }
+		inline bool hasMultiDrawIndirect() const { return multiDrawIndirect; }
+		inline bool hasDrawIndirectCount() const { return drawIndirectCount; }
+		inline bool hasTimestamps() const { return timestampValidBits > 0; }
+		inline uint32_t getTimestampValidBits() const { return timestampValidBits; }
+		inline float getTimestampPeriod() const { return timestampPeriod; }
+		inline bool hasPipelineStatistics() const { return pipelineStatistics; }
+		inline bool hasMemoryBudget() const { return memoryBudget; }
+		inline bool isHeadless() const { return headless; }
 		inline VmaAllocator getVRAMAllocator() const { return vram_allocator; }
+		inline MemoryTracker *getMemoryTracker() const { return memoryTracker; }
 
 	public:
-		void init(const char *applicationName, const char *engineName);
+		void init(const char *applicationName, const char *engineName, bool headless = false);
 		void shutdown();
 
 	private:
@@ -36,6 +53,7 @@ namespace render::backend::vulkan
 		};
 
 		int examinePhysicalDevice(VkPhysicalDevice physicalDevice) const;
+		bool checkDescriptorIndexingSupport(VkPhysicalDevice physicalDevice) const;
 
 	private:
 		VkInstance instance {VK_NULL_HANDLE};
@@ -44,14 +62,28 @@ namespace render::backend::vulkan
 		VkPhysicalDevice physicalDevice {VK_NULL_HANDLE};
 
 		VkCommandPool commandPool {VK_NULL_HANDLE};
-		VkDescriptorPool descriptorPool {VK_NULL_HANDLE};
 
 		uint32_t graphicsQueueFamily {0xFFFF};
 		VkQueue graphicsQueue {VK_NULL_HANDLE};
 
+		uint32_t transferQueueFamily {0xFFFF};
+		VkQueue transferQueue {VK_NULL_HANDLE};
+
+		// queue submits may come from loader threads
+		mutable std::mutex queueMutex;
+
 		VkSampleCountFlagBits maxMSAASamples {VK_SAMPLE_COUNT_1_BIT};
+		uint32_t maxBindlessTextures {0};
+		bool multiDrawIndirect {false};
+		bool drawIndirectCount {false};
+		uint32_t timestampValidBits {0};
+		float timestampPeriod {0.0f};
+		bool pipelineStatistics {false};
+		bool memoryBudget {false};
+		bool headless {false};
 		VkDebugUtilsMessengerEXT debugMessenger {VK_NULL_HANDLE};
 
 		VmaAllocator vram_allocator {VK_NULL_HANDLE};
+		MemoryTracker *memoryTracker {nullptr};
 	};
 }
@@ -1,11 +1,22 @@
 #include "render/backend/vulkan/Driver.h"
 #include "render/backend/vulkan/Device.h"
 #include "render/backend/vulkan/Platform.h"
+#include "render/backend/vulkan/BindlessTable.h"
+#include "render/backend/vulkan/DescriptorAllocator.h"
 #include "render/backend/vulkan/DescriptorSetLayoutCache.h"
+#include "render/backend/vulkan/DestroyQueue.h"
+#include "render/backend/vulkan/FrameBufferCache.h"
+#include "render/backend/vulkan/GeometryArena.h"
 #include "render/backend/vulkan/ImageViewCache.h"
+#include "render/backend/vulkan/MemoryTracker.h"
 #include "render/backend/vulkan/PipelineLayoutCache.h"
 #include "render/backend/vulkan/PipelineCache.h"
+#include "render/backend/vulkan/ReadbackRing.h"
 #include "render/backend/vulkan/RenderPassBuilder.h"
+#include "render/backend/vulkan/SamplerCache.h"
+#include "render/backend/vulkan/SubmitTracker.h"
+#include "render/backend/vulkan/TransientAllocator.h"
+#include "render/backend/vulkan/UploadContext.h"
 #include "render/backend/vulkan/Utils.h"
 
 #include "render/shaders/spirv/Compiler.h"
@@ -13,17 +24,44 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <string>
 
 namespace render::backend::vulkan
 {
+	static_assert(sizeof(DrawIndexedIndirectCommand) == sizeof(VkDrawIndexedIndirectCommand), "Indirect draw layout must match Vulkan one");
+	static_assert(sizeof(PipelineStatistics) == sizeof(uint64_t) * 6, "Pipeline statistics layout must match enabled query flags");
+
 	namespace helpers
 	{
-		static void createTextureData(const Device *device, Texture *texture, Format format, const void *data, int num_data_mipmaps, int num_data_layers)
+		static VkImageUsageFlags getTextureUsage(uint32_t usage_flags)
+		{
+			VkImageUsageFlags result = 0;
+
+			if (usage_flags & TEXTURE_USAGE_STORAGE)
+				result |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+			if (usage_flags & TEXTURE_USAGE_INPUT_ATTACHMENT)
+				result |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+			return result;
+		}
+
+		static void createTextureData(const Device *device, UploadContext *upload_context, SamplerCache *sampler_cache, Texture *texture, Format format, const void *data, int num_data_mipmaps, int num_data_layers)
 		{
-			VkImageUsageFlags usage_flags = Utils::getImageUsageFlags(texture->format);
+			VkImageUsageFlags usage_flags = Utils::getImageUsageFlags(texture->format) | texture->usage;
+
+			if (texture->usage & VK_IMAGE_USAGE_STORAGE_BIT)
+			{
+				VkFormatProperties format_properties = {};
+				vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), texture->format, &format_properties);
+
+				assert(data == nullptr && "Storage textures must be created without data");
+				assert(texture->samples == VK_SAMPLE_COUNT_1_BIT && "Storage textures can't be multisampled");
+				assert((format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) && "Format can't be used for storage textures");
+			}
 
 			Utils::createImage(
 				device,
@@ -37,13 +75,17 @@ namespace render::backend::vulkan
 				texture->memory
 			);
 
+			MemoryCategory category = (data != nullptr) ? MemoryCategory::TEXTURES : MemoryCategory::RENDER_TARGETS;
+			device->getMemoryTracker()->add(texture->memory, category);
+
 			VkImageLayout source_layout = VK_IMAGE_LAYOUT_UNDEFINED;
 
+			upload_context->beginBatch();
+
 			if (data != nullptr)
 			{
 				// prepare for transfer
-				Utils::transitionImageLayout(
-					device,
+				upload_context->transitionImageLayout(
 					texture->image,
 					texture->format,
 					VK_IMAGE_LAYOUT_UNDEFINED,
@@ -53,13 +95,10 @@ namespace render::backend::vulkan
 				);
 
 				// transfer data to GPU
-				Utils::fillImage(
-					device,
+				upload_context->fillImage(
 					texture->image,
 					texture->width, texture->height, texture->depth,
-					texture->num_mipmaps, texture->num_layers,
 					Utils::getPixelSize(format),
-					texture->format,
 					data,
 					num_data_mipmaps,
 					num_data_layers
@@ -69,8 +108,7 @@ namespace render::backend::vulkan
 			}
 
 			// prepare for shader access
-			Utils::transitionImageLayout(
-				device,
+			upload_context->transitionImageLayout(
 				texture->image,
 				texture->format,
 				source_layout,
@@ -79,11 +117,25 @@ namespace render::backend::vulkan
 				0, texture->num_layers
 			);
 
-			// create base sampler & view cache
-			texture->sampler = Utils::createSampler(device, 0, texture->num_mipmaps);
+			upload_context->endBatch();
+
+			// upload batch is complete before any frame command buffer runs
+			texture->states.assign(texture->num_mipmaps * texture->num_layers, { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, 0 });
+
+			// fetch base sampler & create view cache
+			texture->sampler = sampler_cache->fetch(texture->sampler_description);
 			texture->image_view_cache = new ImageViewCache(device);
 		}
 
+		static void updateBindlessSampler(BindlessTable *bindless_table, Texture *texture)
+		{
+			if (texture->bindless_index == INVALID_BINDLESS_INDEX)
+				return;
+
+			VkImageView view = texture->image_view_cache->fetch(texture, 0, texture->num_mipmaps, 0, texture->num_layers);
+			bindless_table->update(texture->bindless_index, view, texture->sampler);
+		}
+
 		static void selectOptimalSwapChainSettings(const Device *device, SwapChain *swap_chain)
 		{
 			// Get surface capabilities
@@ -158,10 +210,17 @@ namespace render::backend::vulkan
 				swap_chain->num_images = std::min(swap_chain->num_images, capabilities.maxImageCount);
 		}
 
-		static bool createSwapChainObjects(Driver *driver, const Device *device, SwapChain *swap_chain)
+		static bool createSurfaceSwapChainImages(const Device *device, SwapChain *swap_chain)
 		{
 			const VkSurfaceCapabilitiesKHR &capabilities = swap_chain->surface_capabilities;
 
+			// readbacks copy straight from swap chain images
+			VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			swap_chain->readable = (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+
+			if (swap_chain->readable)
+				usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
 			VkSwapchainCreateInfoKHR info = {};
 			info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 			info.surface = swap_chain->surface;
@@ -170,7 +229,7 @@ namespace render::backend::vulkan
 			info.imageColorSpace = swap_chain->surface_format.colorSpace;
 			info.imageExtent = swap_chain->sizes;
 			info.imageArrayLayers = 1;
-			info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			info.imageUsage = usage;
 			info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			info.preTransform = capabilities.currentTransform;
 			info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
@@ -197,6 +256,46 @@ namespace render::backend::vulkan
 			assert(swap_chain->num_images != 0 && swap_chain->num_images < SwapChain::MAX_IMAGES);
 			vkGetSwapchainImagesKHR(device->getDevice(), swap_chain->swap_chain, &swap_chain->num_images, swap_chain->images);
 
+			return true;
+		}
+
+		static bool createOffscreenSwapChainImages(const Device *device, SwapChain *swap_chain)
+		{
+			for (uint32_t i = 0; i < swap_chain->num_images; ++i)
+			{
+				Utils::createImage(
+					device,
+					VK_IMAGE_TYPE_2D,
+					swap_chain->sizes.width, swap_chain->sizes.height, 1,
+					1, 1,
+					VK_SAMPLE_COUNT_1_BIT, swap_chain->surface_format.format, VK_IMAGE_TILING_OPTIMAL,
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+					0,
+					swap_chain->images[i],
+					swap_chain->image_memory[i]
+				);
+
+				device->getMemoryTracker()->add(swap_chain->image_memory[i], MemoryCategory::RENDER_TARGETS);
+
+				// images look presented before their first acquire, like surface ones
+				Utils::transitionImageLayout(
+					device,
+					swap_chain->images[i],
+					swap_chain->surface_format.format,
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					swap_chain->present_layout
+				);
+			}
+
+			return true;
+		}
+
+		static bool createSwapChainObjects(Driver *driver, const Device *device, SwapChain *swap_chain)
+		{
+			bool images_created = (swap_chain->offscreen) ? createOffscreenSwapChainImages(device, swap_chain) : createSurfaceSwapChainImages(device, swap_chain);
+			if (!images_created)
+				return false;
+
 			// Create dummy render pass
 			RenderPassBuilder render_pass_builder;
 			swap_chain->dummy_render_pass = render_pass_builder
@@ -207,7 +306,7 @@ namespace render::backend::vulkan
 					VK_ATTACHMENT_STORE_OP_DONT_CARE,
 					VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 					VK_ATTACHMENT_STORE_OP_DONT_CARE,
-					VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+					swap_chain->present_layout
 				)
 				.addSubpass(VK_PIPELINE_BIND_POINT_GRAPHICS)
 				.addColorAttachmentReference(0, 0)
@@ -266,8 +365,6 @@ namespace render::backend::vulkan
 		{
 			for (size_t i = 0; i < swap_chain->num_images; ++i)
 			{
-				swap_chain->images[i] = VK_NULL_HANDLE;
-
 				vkDestroySemaphore(device->getDevice(), swap_chain->image_available_gpu[i], nullptr);
 				swap_chain->image_available_gpu[i] = VK_NULL_HANDLE;
 
@@ -276,33 +373,58 @@ namespace render::backend::vulkan
 
 				vkDestroyFramebuffer(device->getDevice(), swap_chain->frame_buffers[i], nullptr);
 				swap_chain->frame_buffers[i] = VK_NULL_HANDLE;
+
+				// surface images are owned by the swap chain
+				if (swap_chain->image_memory[i] != VK_NULL_HANDLE)
+				{
+					device->getMemoryTracker()->remove(swap_chain->image_memory[i]);
+					vmaDestroyImage(device->getVRAMAllocator(), swap_chain->images[i], swap_chain->image_memory[i]);
+					swap_chain->image_memory[i] = VK_NULL_HANDLE;
+				}
+
+				swap_chain->images[i] = VK_NULL_HANDLE;
 			}
 
 			vkDestroyRenderPass(device->getDevice(), swap_chain->dummy_render_pass, nullptr);
 			swap_chain->dummy_render_pass = VK_NULL_HANDLE;
 
-			vkDestroySwapchainKHR(device->getDevice(), swap_chain->swap_chain, nullptr);
+			// swap chain entry points are not loaded on headless devices
+			if (swap_chain->swap_chain != VK_NULL_HANDLE)
+				vkDestroySwapchainKHR(device->getDevice(), swap_chain->swap_chain, nullptr);
+
 			swap_chain->swap_chain = VK_NULL_HANDLE;
 		}
 
-		static void updateBindSetLayout(const Device *device, BindSet *bind_set, VkDescriptorSetLayout new_layout)
+		static void freeBindSetVersions(DescriptorAllocator *descriptor_allocator, BindSet *bind_set)
+		{
+			for (uint8_t i = 0; i < bind_set->num_versions; ++i)
+			{
+				BindSet::Version &version = bind_set->versions[i];
+				descriptor_allocator->free(version.set, version.pool, version.serial);
+
+				version = {};
+			}
+
+			bind_set->num_versions = 0;
+			bind_set->current_version = 0;
+			bind_set->set = VK_NULL_HANDLE;
+		}
+
+		static void updateBindSetLayout(DescriptorAllocator *descriptor_allocator, BindSet *bind_set, VkDescriptorSetLayout new_layout)
 		{
 			if (new_layout == bind_set->set_layout)
 				return;
 
 			bind_set->set_layout = new_layout;
 
-			if (bind_set->set != VK_NULL_HANDLE)
-				vkFreeDescriptorSets(device->getDevice(), device->getDescriptorPool(), 1, &bind_set->set);
+			freeBindSetVersions(descriptor_allocator, bind_set);
 
-			VkDescriptorSetAllocateInfo info = {};
-			info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			info.descriptorPool = device->getDescriptorPool();
-			info.descriptorSetCount = 1;
-			info.pSetLayouts = &new_layout;
+			BindSet::Version &version = bind_set->versions[0];
+			version.set = descriptor_allocator->allocate(new_layout, version.pool);
+			assert(version.set);
 
-			vkAllocateDescriptorSets(device->getDevice(), &info, &bind_set->set);
-			assert(bind_set->set);
+			bind_set->set = version.set;
+			bind_set->num_versions = 1;
 
 			for (uint8_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
 			{
@@ -312,32 +434,467 @@ namespace render::backend::vulkan
 				bind_set->binding_dirty[i] = true;
 			}
 		}
+
+		static VkDescriptorSet switchBindSetVersion(DescriptorAllocator *descriptor_allocator, SubmitTracker *submit_tracker, BindSet *bind_set)
+		{
+			uint8_t current_version = bind_set->current_version;
+
+			// current version is not used by GPU, safe to update in place
+			if (current_version != BindSet::TRANSIENT_VERSION && submit_tracker->isComplete(bind_set->versions[current_version].serial))
+				return VK_NULL_HANDLE;
+
+			VkDescriptorSet old_set = bind_set->set;
+			uint8_t new_version = BindSet::TRANSIENT_VERSION;
+
+			for (uint8_t i = 0; i < bind_set->num_versions; ++i)
+			{
+				if (i == current_version)
+					continue;
+
+				if (!submit_tracker->isComplete(bind_set->versions[i].serial))
+					continue;
+
+				new_version = i;
+				break;
+			}
+
+			if (new_version == BindSet::TRANSIENT_VERSION && bind_set->num_versions < BindSet::MAX_VERSIONS)
+			{
+				new_version = bind_set->num_versions;
+
+				BindSet::Version &version = bind_set->versions[new_version];
+				version.set = descriptor_allocator->allocate(bind_set->set_layout, version.pool);
+				assert(version.set);
+
+				bind_set->num_versions++;
+			}
+
+			if (new_version == BindSet::TRANSIENT_VERSION)
+			{
+				uint8_t oldest_version = 0;
+				for (uint8_t i = 1; i < bind_set->num_versions; ++i)
+				{
+					if (bind_set->versions[i].serial < bind_set->versions[oldest_version].serial)
+						oldest_version = i;
+				}
+
+				// versions recorded into the current frame can't be waited for, fall back to a single frame set
+				uint64_t oldest_serial = bind_set->versions[oldest_version].serial;
+				if (oldest_serial < submit_tracker->getCurrentSerial())
+				{
+					submit_tracker->wait(oldest_serial);
+					new_version = oldest_version;
+				}
+			}
+
+			bind_set->current_version = new_version;
+
+			if (new_version == BindSet::TRANSIENT_VERSION)
+			{
+				bind_set->set = descriptor_allocator->allocateTransient(bind_set->set_layout);
+				bind_set->transient_serial = submit_tracker->getCurrentSerial();
+			}
+			else
+				bind_set->set = bind_set->versions[new_version].set;
+
+			assert(bind_set->set);
+			return old_set;
+		}
+
+		static void markBindSetUsed(BindSet *bind_set, uint64_t serial)
+		{
+			if (bind_set->bindless || bind_set->current_version == BindSet::TRANSIENT_VERSION)
+				return;
+
+			bind_set->versions[bind_set->current_version].serial = serial;
+		}
+
+		static void getBarrierMasks(
+			BarrierType type,
+			VkPipelineStageFlags &src_stages,
+			VkPipelineStageFlags &dst_stages,
+			VkAccessFlags &src_access,
+			VkAccessFlags &dst_access
+		)
+		{
+			switch (type)
+			{
+				case BarrierType::COMPUTE_TO_COMPUTE:
+				{
+					src_stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+					dst_stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+					src_access = VK_ACCESS_SHADER_WRITE_BIT;
+					dst_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				}
+				break;
+				case BarrierType::COMPUTE_TO_GRAPHICS:
+				{
+					src_stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+					dst_stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+					src_access = VK_ACCESS_SHADER_WRITE_BIT;
+					dst_access = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+				}
+				break;
+				case BarrierType::GRAPHICS_TO_COMPUTE:
+				{
+					src_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+					dst_stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+					src_access = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+					dst_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				}
+				break;
+				default:
+				{
+					assert(false && "Unsupported barrier type");
+				}
+				break;
+			}
+		}
+
+		static void getTextureStateMasks(
+			TextureState state,
+			VkImageLayout &layout,
+			VkAccessFlags &access,
+			VkPipelineStageFlags &stages
+		)
+		{
+			switch (state)
+			{
+				case TextureState::UNDEFINED:
+				{
+					layout = VK_IMAGE_LAYOUT_UNDEFINED;
+					access = 0;
+					stages = 0;
+				}
+				break;
+				case TextureState::GRAPHICS_SAMPLED:
+				{
+					layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					access = VK_ACCESS_SHADER_READ_BIT;
+					stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				}
+				break;
+				case TextureState::COMPUTE_SAMPLED:
+				{
+					layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					access = VK_ACCESS_SHADER_READ_BIT;
+					stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+				}
+				break;
+				case TextureState::COMPUTE_STORAGE:
+				{
+					layout = VK_IMAGE_LAYOUT_GENERAL;
+					access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+					stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+				}
+				break;
+				case TextureState::COLOR_ATTACHMENT:
+				{
+					layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+					stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				}
+				break;
+				case TextureState::DEPTHSTENCIL_ATTACHMENT:
+				{
+					layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+					access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+					stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				}
+				break;
+				case TextureState::TRANSFER_SRC:
+				{
+					layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+					access = VK_ACCESS_TRANSFER_READ_BIT;
+					stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				}
+				break;
+				case TextureState::TRANSFER_DST:
+				{
+					layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+					access = VK_ACCESS_TRANSFER_WRITE_BIT;
+					stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				}
+				break;
+				default:
+				{
+					assert(false && "Unsupported texture state");
+				}
+				break;
+			}
+		}
+
+		static VkAccessFlags getWriteAccess(VkAccessFlags access)
+		{
+			constexpr VkAccessFlags write_access =
+				VK_ACCESS_SHADER_WRITE_BIT |
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_TRANSFER_WRITE_BIT |
+				VK_ACCESS_HOST_WRITE_BIT |
+				VK_ACCESS_MEMORY_WRITE_BIT;
+
+			return access & write_access;
+		}
+
+		static void setTextureState(
+			const Texture *texture,
+			uint32_t base_mip,
+			uint32_t num_mips,
+			uint32_t base_layer,
+			uint32_t num_layers,
+			VkImageLayout layout,
+			VkAccessFlags access,
+			VkPipelineStageFlags stages
+		)
+		{
+			for (uint32_t layer = base_layer; layer < base_layer + num_layers; ++layer)
+			{
+				for (uint32_t mip = base_mip; mip < base_mip + num_mips; ++mip)
+				{
+					TextureSubresourceState &state = texture->states[layer * texture->num_mipmaps + mip];
+					state.layout = layout;
+					state.access = access;
+					state.stages = stages;
+				}
+			}
+		}
+
+		static void flushBarriers(CommandBuffer *command_buffer)
+		{
+			if (command_buffer->pending_barriers.empty())
+				return;
+
+			vkCmdPipelineBarrier(
+				command_buffer->command_buffer,
+				command_buffer->pending_src_stages,
+				command_buffer->pending_dst_stages,
+				0,
+				0, nullptr,
+				0, nullptr,
+				static_cast<uint32_t>(command_buffer->pending_barriers.size()),
+				command_buffer->pending_barriers.data()
+			);
+
+			command_buffer->pending_barriers.clear();
+			command_buffer->pending_src_stages = 0;
+			command_buffer->pending_dst_stages = 0;
+		}
+
+		// render passes leave attachments written & in shader read layout
+		static void updateAttachmentStates(const FrameBuffer *frame_buffer)
+		{
+			for (uint32_t i = 0; i < frame_buffer->num_attachments; ++i)
+			{
+				const Texture *texture = frame_buffer->attachment_textures[i];
+
+				VkAccessFlags access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+				if (Utils::getImageAspectFlags(texture->format) & VK_IMAGE_ASPECT_DEPTH_BIT)
+				{
+					access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+					stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				}
+
+				setTextureState(
+					texture,
+					frame_buffer->attachment_base_mips[i], 1,
+					frame_buffer->attachment_base_layers[i], frame_buffer->attachment_num_layers[i],
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					access,
+					stages
+				);
+			}
+		}
+
+		static uint8_t getDynamicOffsets(const BindSet *bind_set, const uint32_t *base_offsets, uint32_t *offsets)
+		{
+			uint8_t result = 0;
+
+			// dynamic offsets are consumed in binding order
+			for (uint8_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
+			{
+				if (!bind_set->binding_used[i])
+					continue;
+
+				if (bind_set->bindings[i].descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+					continue;
+
+				assert(result < BindSet::MAX_DYNAMIC_BINDINGS && "Too many dynamic uniform buffers in a bind set");
+
+				const UniformBuffer *uniform_buffer = bind_set->binding_data[i].ubo.uniform_buffer;
+				offsets[result++] = static_cast<uint32_t>(uniform_buffer->offset) + base_offsets[i];
+			}
+
+			return result;
+		}
+
+		static void invalidateBoundState(CommandBuffer *command_buffer)
+		{
+			command_buffer->viewport_bound = false;
+			command_buffer->scissor_bound = false;
+
+			command_buffer->bound_pipeline = VK_NULL_HANDLE;
+			command_buffer->bound_pipeline_layout = VK_NULL_HANDLE;
+
+			command_buffer->bound_push_constants_size = 0;
+			command_buffer->num_bound_sets = 0;
+			command_buffer->num_bound_vertex_buffers = 0;
+
+			command_buffer->bound_index_buffer = VK_NULL_HANDLE;
+			command_buffer->bound_index_offset = 0;
+			command_buffer->bound_index_type = VK_INDEX_TYPE_UINT16;
+		}
+
+		// only the depth aspect of depth stencil formats is read back
+		static uint32_t getReadbackTexelSize(VkFormat format)
+		{
+			switch (format)
+			{
+				case VK_FORMAT_D16_UNORM:
+				case VK_FORMAT_D16_UNORM_S8_UINT:
+					return 2;
+				case VK_FORMAT_X8_D24_UNORM_PACK32:
+				case VK_FORMAT_D24_UNORM_S8_UINT:
+				case VK_FORMAT_D32_SFLOAT:
+				case VK_FORMAT_D32_SFLOAT_S8_UINT:
+					return 4;
+				default:
+					return Utils::getPixelSize(Utils::getApiFormat(format));
+			}
+		}
+
+		static VkImageAspectFlags getReadbackAspect(VkFormat format)
+		{
+			VkImageAspectFlags aspect = Utils::getImageAspectFlags(format);
+			if (aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+			return aspect;
+		}
+
+		static void copyImageToReadback(
+			CommandBuffer *command_buffer,
+			VkImage image,
+			VkImageAspectFlags aspect,
+			uint32_t mip,
+			uint32_t layer,
+			VkExtent3D extent,
+			VkBuffer buffer,
+			VkDeviceSize offset
+		)
+		{
+			VkBufferImageCopy region = {};
+			region.bufferOffset = offset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = aspect;
+			region.imageSubresource.mipLevel = mip;
+			region.imageSubresource.baseArrayLayer = layer;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = {0, 0, 0};
+			region.imageExtent = extent;
+
+			vkCmdCopyImageToBuffer(command_buffer->command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+		}
+
+		// fence waits don't make device writes visible to the host on their own
+		static void makeReadbackHostVisible(CommandBuffer *command_buffer)
+		{
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+			vkCmdPipelineBarrier(command_buffer->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
 	}
 
-	Driver::Driver(const char *application_name, const char *engine_name)
+	Driver::Driver(const char *application_name, const char *engine_name, bool headless)
 	{
 		device = new Device();
-		device->init(application_name, engine_name);
+		device->init(application_name, engine_name, headless);
 
+		submit_tracker = new SubmitTracker(device);
+		destroy_queue = new DestroyQueue(device, submit_tracker);
+		frame_buffer_cache = new FrameBufferCache(device, destroy_queue);
+		descriptor_allocator = new DescriptorAllocator(device, submit_tracker);
 		descriptor_set_layout_cache = new DescriptorSetLayoutCache(device);
 		pipeline_layout_cache = new PipelineLayoutCache(device, descriptor_set_layout_cache);
-		pipeline_cache = new PipelineCache(device, pipeline_layout_cache);
+		pipeline_cache = new PipelineCache(device, pipeline_layout_cache, destroy_queue);
+		sampler_cache = new SamplerCache(device);
+		transient_allocator = new TransientAllocator(device, submit_tracker);
+		readback_ring = new ReadbackRing(device, submit_tracker);
+
+		if (device->hasDescriptorIndexing())
+		{
+			bindless_table = new BindlessTable(device, submit_tracker);
+
+			bindless_bind_set = bind_set_objects.allocate();
+			memset(bindless_bind_set, 0, sizeof(BindSet));
+
+			bindless_bind_set->set_layout = bindless_table->getSetLayout();
+			bindless_bind_set->set = bindless_table->getSet();
+			bindless_bind_set->bindless = true;
+		}
 	}
 
 	Driver::~Driver()
 	{
+		// caches below release their objects right away, submitted work must not use them anymore
+		if (device)
+			vkDeviceWaitIdle(device->getDevice());
+
+		for (auto &it : upload_contexts)
+			delete it.second;
+
+		upload_contexts.clear();
+
+		bind_set_objects.free(bindless_bind_set);
+		bindless_bind_set = nullptr;
+
+		delete bindless_table;
+		bindless_table = nullptr;
+
+		delete readback_ring;
+		readback_ring = nullptr;
+
+		delete transient_allocator;
+		transient_allocator = nullptr;
+
 		delete pipeline_cache;
 		pipeline_cache = nullptr;
 
+		delete sampler_cache;
+		sampler_cache = nullptr;
+
 		delete pipeline_layout_cache;
 		pipeline_layout_cache = nullptr;
 
 		delete descriptor_set_layout_cache;
 		descriptor_set_layout_cache = nullptr;
 
+		delete descriptor_allocator;
+		descriptor_allocator = nullptr;
+
+		delete frame_buffer_cache;
+		frame_buffer_cache = nullptr;
+
+		delete destroy_queue;
+		destroy_queue = nullptr;
+
+		delete submit_tracker;
+		submit_tracker = nullptr;
+
 		if (device)
 		{
 			vkDeviceWaitIdle(device->getDevice());
+
+			for (auto &it : command_pools)
+				vkDestroyCommandPool(device->getDevice(), it.second, nullptr);
+
+			command_pools.clear();
 			device->shutdown();
 		}
 
@@ -360,7 +917,8 @@ namespace render::backend::vulkan
 
 		VkDeviceSize buffer_size = vertex_size * num_vertices;
 
-		VertexBuffer *result = new VertexBuffer();
+		VertexBuffer *result = vertex_buffer_objects.allocate();
+		backend::VertexBuffer *handle = vertex_buffer_objects.getHandle<backend::VertexBuffer>(result);
 		result->type = type;
 		result->vertex_size = vertex_size;
 		result->num_vertices = num_vertices;
@@ -373,6 +931,18 @@ namespace render::backend::vulkan
 			result->attribute_offsets[i] = attributes[i].offset;
 		}
 
+		// transient buffers live in the frame ring, memory is assigned on map
+		if (type == BufferType::TRANSIENT)
+		{
+			if (data)
+			{
+				memcpy(map(handle), data, static_cast<size_t>(buffer_size));
+				unmap(handle);
+			}
+
+			return handle;
+		}
+
 		VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 		VkMemoryPropertyFlags memory_flags = 0;
 
@@ -388,16 +958,17 @@ namespace render::backend::vulkan
 
 		// create vertex buffer
 		Utils::createBuffer(device, buffer_size, usage_flags, memory_flags, result->buffer, result->memory);
+		device->getMemoryTracker()->add(result->memory, MemoryCategory::GEOMETRY);
 
 		if (data)
 		{
 			if (type == BufferType::STATIC)
-				Utils::fillDeviceLocalBuffer(device, result->buffer, buffer_size, data);
+				getUploadContext()->fillBuffer(result->buffer, buffer_size, data);
 			else if (type == BufferType::DYNAMIC)
 				Utils::fillHostVisibleBuffer(device, result->memory, buffer_size, data);
 		}
 
-		return result;
+		return handle;
 	}
 
 	backend::IndexBuffer *Driver::createIndexBuffer(
@@ -411,11 +982,24 @@ namespace render::backend::vulkan
 
 		VkDeviceSize buffer_size = Utils::getIndexSize(index_format) * num_indices;
 
-		IndexBuffer *result = new IndexBuffer();
+		IndexBuffer *result = index_buffer_objects.allocate();
+		backend::IndexBuffer *handle = index_buffer_objects.getHandle<backend::IndexBuffer>(result);
 		result->type = type;
 		result->index_type = Utils::getIndexType(index_format);
 		result->num_indices = num_indices;
 
+		// transient buffers live in the frame ring, memory is assigned on map
+		if (type == BufferType::TRANSIENT)
+		{
+			if (data)
+			{
+				memcpy(map(handle), data, static_cast<size_t>(buffer_size));
+				unmap(handle);
+			}
+
+			return handle;
+		}
+
 		VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 		VkMemoryPropertyFlags memory_flags = 0;
 
@@ -431,16 +1015,17 @@ namespace render::backend::vulkan
 
 		// create index buffer
 		Utils::createBuffer(device, buffer_size, usage_flags, memory_flags, result->buffer, result->memory);
+		device->getMemoryTracker()->add(result->memory, MemoryCategory::GEOMETRY);
 
 		if (data)
 		{
 			if (type == BufferType::STATIC)
-				Utils::fillDeviceLocalBuffer(device, result->buffer, buffer_size, data);
+				getUploadContext()->fillBuffer(result->buffer, buffer_size, data);
 			else if (type == BufferType::DYNAMIC)
 				Utils::fillHostVisibleBuffer(device, result->memory, buffer_size, data);
 		}
 
-		return result;
+		return handle;
 	}
 
 	backend::Texture *Driver::createTexture2D(
@@ -449,14 +1034,15 @@ namespace render::backend::vulkan
 		uint32_t num_mipmaps,
 		Format format,
 		const void *data,
-		uint32_t num_data_mipmaps
+		uint32_t num_data_mipmaps,
+		uint32_t usage_flags
 	)
 	{
 		assert(width != 0 && height != 0 && "Invalid texture size");
 		assert(num_mipmaps != 0 && "Invalid mipmap count");
 		assert((data == nullptr) || (data != nullptr && num_data_mipmaps != 0) && "Invalid data mipmaps");
 
-		Texture *result = new Texture();
+		Texture *result = texture_objects.allocate();
 		result->type = VK_IMAGE_TYPE_2D;
 		result->format = Utils::getFormat(format);
 		result->width = width;
@@ -467,10 +1053,17 @@ namespace render::backend::vulkan
 		result->samples = VK_SAMPLE_COUNT_1_BIT;
 		result->tiling = VK_IMAGE_TILING_OPTIMAL;
 		result->flags = 0;
+		result->usage = helpers::getTextureUsage(usage_flags);
 
-		helpers::createTextureData(device, result, format, data, num_data_mipmaps, 1);
+		helpers::createTextureData(device, getUploadContext(), sampler_cache, result, format, data, num_data_mipmaps, 1);
 
-		return result;
+		if (bindless_table)
+		{
+			VkImageView view = result->image_view_cache->fetch(result, 0, result->num_mipmaps, 0, result->num_layers);
+			result->bindless_index = bindless_table->allocate(view, result->sampler);
+		}
+
+		return texture_objects.getHandle<backend::Texture>(result);
 	}
 
 	backend::Texture *Driver::createTexture2DMultisample(
@@ -482,7 +1075,7 @@ namespace render::backend::vulkan
 	{
 		assert(width != 0 && height != 0 && "Invalid texture size");
 
-		Texture *result = new Texture();
+		Texture *result = texture_objects.allocate();
 		result->type = VK_IMAGE_TYPE_2D;
 		result->format = Utils::getFormat(format);
 		result->width = width;
@@ -494,9 +1087,9 @@ namespace render::backend::vulkan
 		result->tiling = VK_IMAGE_TILING_OPTIMAL;
 		result->flags = 0;
 
-		helpers::createTextureData(device, result, format, nullptr, 1, 1);
+		helpers::createTextureData(device, getUploadContext(), sampler_cache, result, format, nullptr, 1, 1);
 
-		return result;
+		return texture_objects.getHandle<backend::Texture>(result);
 	}
 
 	backend::Texture *Driver::createTexture2DArray(
@@ -507,7 +1100,8 @@ namespace render::backend::vulkan
 		Format format,
 		const void *data,
 		uint32_t num_data_mipmaps,
-		uint32_t num_data_layers
+		uint32_t num_data_layers,
+		uint32_t usage_flags
 	)
 	{
 		assert(width != 0 && height != 0 && "Invalid texture size");
@@ -516,7 +1110,7 @@ namespace render::backend::vulkan
 		assert((data == nullptr) || (data != nullptr && num_data_mipmaps != 0) && "Invalid data mipmaps");
 		assert((data == nullptr) || (data != nullptr && num_data_layers != 0) && "Invalid data layers");
 
-		Texture *result = new Texture();
+		Texture *result = texture_objects.allocate();
 		result->type = VK_IMAGE_TYPE_2D;
 		result->format = Utils::getFormat(format);
 		result->width = width;
@@ -527,10 +1121,11 @@ namespace render::backend::vulkan
 		result->samples = VK_SAMPLE_COUNT_1_BIT;
 		result->tiling = VK_IMAGE_TILING_OPTIMAL;
 		result->flags = 0;
+		result->usage = helpers::getTextureUsage(usage_flags);
 
-		helpers::createTextureData(device, result, format, data, num_data_mipmaps, num_data_layers);
+		helpers::createTextureData(device, getUploadContext(), sampler_cache, result, format, data, num_data_mipmaps, num_data_layers);
 
-		return result;
+		return texture_objects.getHandle<backend::Texture>(result);
 	}
 
 	backend::Texture *Driver::createTexture3D(
@@ -540,14 +1135,15 @@ namespace render::backend::vulkan
 		uint32_t num_mipmaps,
 		Format format,
 		const void *data,
-		uint32_t num_data_mipmaps
+		uint32_t num_data_mipmaps,
+		uint32_t usage_flags
 	)
 	{
 		assert(width != 0 && height != 0 && depth != 0 && "Invalid texture size");
 		assert(num_mipmaps != 0 && "Invalid mipmap count");
 		assert((data == nullptr) || (data != nullptr && num_data_mipmaps != 0) && "Invalid data mipmaps");
 
-		Texture *result = new Texture();
+		Texture *result = texture_objects.allocate();
 		result->type = VK_IMAGE_TYPE_3D;
 		result->format = Utils::getFormat(format);
 		result->width = width;
@@ -558,10 +1154,11 @@ namespace render::backend::vulkan
 		result->samples = VK_SAMPLE_COUNT_1_BIT;
 		result->tiling = VK_IMAGE_TILING_OPTIMAL;
 		result->flags = 0;
+		result->usage = helpers::getTextureUsage(usage_flags);
 
-		helpers::createTextureData(device, result, format, data, num_data_mipmaps, 1);
+		helpers::createTextureData(device, getUploadContext(), sampler_cache, result, format, data, num_data_mipmaps, 1);
 
-		return result;
+		return texture_objects.getHandle<backend::Texture>(result);
 	}
 
 	backend::Texture *Driver::createTextureCube(
@@ -569,14 +1166,15 @@ namespace render::backend::vulkan
 		uint32_t num_mipmaps,
 		Format format,
 		const void *data,
-		uint32_t num_data_mipmaps
+		uint32_t num_data_mipmaps,
+		uint32_t usage_flags
 	)
 	{
 		assert(size != 0 && "Invalid texture size");
 		assert(num_mipmaps != 0 && "Invalid mipmap count");
 		assert((data == nullptr) || (data != nullptr && num_data_mipmaps != 0) && "Invalid data mipmaps");
 
-		Texture *result = new Texture();
+		Texture *result = texture_objects.allocate();
 		result->type = VK_IMAGE_TYPE_2D;
 		result->format = Utils::getFormat(format);
 		result->width = size;
@@ -587,10 +1185,11 @@ namespace render::backend::vulkan
 		result->samples = VK_SAMPLE_COUNT_1_BIT;
 		result->tiling = VK_IMAGE_TILING_OPTIMAL;
 		result->flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+		result->usage = helpers::getTextureUsage(usage_flags);
 
-		helpers::createTextureData(device, result, format, data, num_data_mipmaps, 1);
+		helpers::createTextureData(device, getUploadContext(), sampler_cache, result, format, data, num_data_mipmaps, 1);
 
-		return result;
+		return texture_objects.getHandle<backend::Texture>(result);
 	}
 
 	backend::FrameBuffer *Driver::createFrameBuffer(
@@ -601,7 +1200,7 @@ namespace render::backend::vulkan
 		assert(num_attachments <= FrameBuffer::MAX_ATTACHMENTS);
 		assert(num_attachments == 0 || (num_attachments && attachments));
 
-		FrameBuffer *result = new FrameBuffer();
+		FrameBuffer *result = frame_buffer_objects.allocate();
 
 		uint32_t width = 0;
 		uint32_t height = 0;
@@ -611,11 +1210,16 @@ namespace render::backend::vulkan
 		for (uint32_t i = 0; i < num_attachments; ++i)
 		{
 			const FrameBufferAttachment &input_attachment = attachments[i];
-			const Texture *texture = static_cast<const Texture *>(input_attachment.texture);
+			const Texture *texture = texture_objects.get(input_attachment.texture);
 
+			result->attachment_textures[i] = texture;
+			result->attachment_images[i] = texture->image;
 			result->attachment_views[i] = texture->image_view_cache->fetch(texture, input_attachment.base_mip, 1, input_attachment.base_layer, input_attachment.num_layers);
 			result->attachment_formats[i] = texture->format;
 			result->attachment_samples[i] = texture->samples;
+			result->attachment_base_mips[i] = input_attachment.base_mip;
+			result->attachment_base_layers[i] = input_attachment.base_layer;
+			result->attachment_num_layers[i] = input_attachment.num_layers;
 
 			width = std::max<int>(1, texture->width / (1 << input_attachment.base_mip));
 			height = std::max<int>(1, texture->height / (1 << input_attachment.base_mip));
@@ -624,7 +1228,7 @@ namespace render::backend::vulkan
 		result->sizes.width = width;
 		result->sizes.height = height;
 
-		return result;
+		return frame_buffer_objects.getHandle<backend::FrameBuffer>(result);
 	}
 
 	backend::RenderPass *Driver::createRenderPass(
@@ -632,12 +1236,24 @@ namespace render::backend::vulkan
 		const RenderPassAttachment *attachments,
 		const RenderPassDescription &description
 	)
+	{
+		return createRenderPass(num_attachments, attachments, 1, &description);
+	}
+
+	backend::RenderPass *Driver::createRenderPass(
+		uint32_t num_attachments,
+		const RenderPassAttachment *attachments,
+		uint32_t num_subpasses,
+		const RenderPassDescription *subpasses
+	)
 	{
 		assert(num_attachments <= RenderPass::MAX_ATTACHMENTS);
 		assert(num_attachments == 0 || (num_attachments && attachments));
+		assert(num_subpasses > 0 && num_subpasses <= RenderPass::MAX_SUBPASSES);
+		assert(subpasses);
 
 		RenderPassBuilder builder;
-		RenderPass *result = new RenderPass();
+		RenderPass *result = render_pass_objects.allocate();
 
 		result->num_attachments = num_attachments;
 		for (uint32_t i = 0; i < num_attachments; ++i)
@@ -658,28 +1274,54 @@ namespace render::backend::vulkan
 			builder.addAttachment(format, samples, load_op, store_op, load_op, store_op);
 		}
 
-		builder.addSubpass(VK_PIPELINE_BIND_POINT_GRAPHICS); // TODO: add different binding points
-
-		result->num_color_attachments = description.num_color_attachments;
-		for (uint32_t i = 0; i < description.num_color_attachments; ++i)
+		result->num_subpasses = num_subpasses;
+		for (uint32_t subpass = 0; subpass < num_subpasses; ++subpass)
 		{
-			uint32_t index = description.color_attachments[i];
-			VkSampleCountFlagBits samples = result->attachment_samples[index];
+			const RenderPassDescription &description = subpasses[subpass];
 
-			builder.addColorAttachmentReference(0, index);
+			builder.addSubpass(VK_PIPELINE_BIND_POINT_GRAPHICS); // TODO: add different binding points
 
-			if (description.resolve_attachments)
-				builder.addColorResolveAttachmentReference(0, description.resolve_attachments[i]);
+			result->max_samples[subpass] = VK_SAMPLE_COUNT_1_BIT;
+			result->num_color_attachments[subpass] = description.num_color_attachments;
 
-			result->max_samples = std::max<VkSampleCountFlagBits>(result->max_samples, samples);
-		}
+			for (uint32_t i = 0; i < description.num_color_attachments; ++i)
+			{
+				uint32_t index = description.color_attachments[i];
+				VkSampleCountFlagBits samples = result->attachment_samples[index];
+
+				builder.addColorAttachmentReference(subpass, index);
+
+				if (description.resolve_attachments)
+					builder.addColorResolveAttachmentReference(subpass, description.resolve_attachments[i]);
 
-		if (description.depthstencil_attachment)
-			builder.setDepthStencilAttachmentReference(0, *description.depthstencil_attachment);
+				result->max_samples[subpass] = std::max<VkSampleCountFlagBits>(result->max_samples[subpass], samples);
+			}
+
+			if (description.depthstencil_attachment)
+				builder.setDepthStencilAttachmentReference(subpass, *description.depthstencil_attachment);
+
+			for (uint32_t i = 0; i < description.num_input_attachments; ++i)
+				builder.addInputAttachmentReference(subpass, description.input_attachments[i]);
+
+			// input attachments may be written by any earlier subpass, reads stay within the pixel
+			if (description.num_input_attachments == 0)
+				continue;
+
+			for (uint32_t src_subpass = 0; src_subpass < subpass; ++src_subpass)
+				builder.addSubpassDependency(
+					src_subpass,
+					subpass,
+					VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+					VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					VK_ACCESS_INPUT_ATTACHMENT_READ_BIT
+				);
+		}
 
 		result->render_pass = builder.build(device->getDevice());
+		result->compatibility_hash = FrameBufferCache::getCompatibilityHash(result, num_subpasses, subpasses);
 
-		return result;
+		return render_pass_objects.getHandle<backend::RenderPass>(result);
 	}
 
 	backend::RenderPass *Driver::createRenderPass(
@@ -693,7 +1335,7 @@ namespace render::backend::vulkan
 
 		const SwapChain *vk_swap_chain = static_cast<const SwapChain *>(swap_chain);
 
-		RenderPass *result = new RenderPass();
+		RenderPass *result = render_pass_objects.allocate();
 
 		result->num_attachments = 1;
 
@@ -715,37 +1357,48 @@ namespace render::backend::vulkan
 			result->attachment_clear_values[0].color.float32[3] = clear_color->as_f32[3];
 		}
 
-		result->num_color_attachments = 1;
-		result->max_samples = VK_SAMPLE_COUNT_1_BIT;
+		result->num_subpasses = 1;
+		result->num_color_attachments[0] = 1;
+		result->max_samples[0] = VK_SAMPLE_COUNT_1_BIT;
 
 		RenderPassBuilder builder;
 		result->render_pass = builder
-			.addAttachment(vk_format, vk_samples, vk_load_op, vk_store_op, vk_load_op, vk_store_op, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+			.addAttachment(vk_format, vk_samples, vk_load_op, vk_store_op, vk_load_op, vk_store_op, vk_swap_chain->present_layout)
 			.addSubpass(VK_PIPELINE_BIND_POINT_GRAPHICS)
 			.addColorAttachmentReference(0, 0)
 			.build(device->getDevice());
 
-		return result;
+		uint32_t color_attachment = 0;
+
+		RenderPassDescription description;
+		description.num_color_attachments = 1;
+		description.color_attachments = &color_attachment;
+
+		result->compatibility_hash = FrameBufferCache::getCompatibilityHash(result, 1, &description);
+
+		return render_pass_objects.getHandle<backend::RenderPass>(result);
 	}
 
 	backend::CommandBuffer *Driver::createCommandBuffer(
 		CommandBufferType type
 	)
 	{
-		CommandBuffer *result = new CommandBuffer();
+		CommandBuffer *result = command_buffer_objects.allocate();
+		backend::CommandBuffer *handle = command_buffer_objects.getHandle<backend::CommandBuffer>(result);
 		result->level = Utils::getCommandBufferLevel(type);
+		result->pool = getCommandPool();
 
 		// Allocate commandbuffer
 		VkCommandBufferAllocateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		info.commandPool = device->getCommandPool();
+		info.commandPool = result->pool;
 		info.level = result->level;
 		info.commandBufferCount = 1;
 
 		if (vkAllocateCommandBuffers(device->getDevice(), &info, &result->command_buffer) != VK_SUCCESS)
 		{
 			std::cerr << "Driver::createCommandBuffer(): can't allocate command buffer" << std::endl;
-			destroyCommandBuffer(result);
+			destroyCommandBuffer(handle);
 			return nullptr;
 		}
 
@@ -756,7 +1409,7 @@ namespace render::backend::vulkan
 		if (vkCreateSemaphore(device->getDevice(), &semaphore_info, nullptr, &result->rendering_finished_gpu) != VK_SUCCESS)
 		{
 			std::cerr << "Driver::createCommandBuffer(): can't create 'rendering finished' semaphore" << std::endl;
-			destroyCommandBuffer(result);
+			destroyCommandBuffer(handle);
 			return nullptr;
 		}
 
@@ -768,11 +1421,11 @@ namespace render::backend::vulkan
 		if (vkCreateFence(device->getDevice(), &fence_info, nullptr, &result->rendering_finished_cpu) != VK_SUCCESS)
 		{
 			std::cerr << "Driver::createCommandBuffer(): can't create 'rendering finished' fence" << std::endl;
-			destroyCommandBuffer(result);
+			destroyCommandBuffer(handle);
 			return nullptr;
 		}
 
-		return result;
+		return handle;
 	}
 
 	backend::UniformBuffer *Driver::createUniformBuffer(
@@ -781,13 +1434,28 @@ namespace render::backend::vulkan
 		const void *data
 	)
 	{
-		assert(type == BufferType::DYNAMIC && "Only dynamic buffers are implemented at the moment");
+		assert(type != BufferType::STATIC && "Only dynamic and transient buffers are implemented at the moment");
 		assert(size != 0 && "Invalid size");
 
-		UniformBuffer *result = new UniformBuffer();
+		UniformBuffer *result = uniform_buffer_objects.allocate();
+		backend::UniformBuffer *handle = uniform_buffer_objects.getHandle<backend::UniformBuffer>(result);
 		result->type = type;
 		result->size = size;
 
+		// transient buffers live in the frame ring, memory is assigned on map
+		if (type == BufferType::TRANSIENT)
+		{
+			result->buffer = transient_allocator->getBuffer();
+
+			if (data != nullptr)
+			{
+				memcpy(map(handle), data, size);
+				unmap(handle);
+			}
+
+			return handle;
+		}
+
 		Utils::createBuffer(
 			device,
 			size,
@@ -797,10 +1465,58 @@ namespace render::backend::vulkan
 			result->memory
 		);
 
+		device->getMemoryTracker()->add(result->memory, MemoryCategory::UNIFORMS);
+
 		if (data != nullptr)
 			Utils::fillHostVisibleBuffer(device, result->memory, size, data);
 
-		return result;
+		return handle;
+	}
+
+	backend::StorageBuffer *Driver::createStorageBuffer(
+		BufferType type,
+		uint32_t size,
+		const void *data
+	)
+	{
+		assert(type != BufferType::TRANSIENT && "Only static and dynamic storage buffers are implemented at the moment");
+		assert(size != 0 && "Invalid size");
+
+		StorageBuffer *result = storage_buffer_objects.allocate();
+		result->type = type;
+		result->size = size;
+
+		// storage buffers are also used as indirect arguments and compute generated geometry
+		VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+			| VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+			| VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+			| VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+			| VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+		VkMemoryPropertyFlags memory_flags = 0;
+
+		if (type == BufferType::STATIC)
+		{
+			usage_flags |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			memory_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		}
+		else if (type == BufferType::DYNAMIC)
+		{
+			memory_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		}
+
+		Utils::createBuffer(device, size, usage_flags, memory_flags, result->buffer, result->memory);
+		device->getMemoryTracker()->add(result->memory, MemoryCategory::STORAGE);
+
+		if (data)
+		{
+			if (type == BufferType::STATIC)
+				getUploadContext()->fillBuffer(result->buffer, size, data);
+			else if (type == BufferType::DYNAMIC)
+				Utils::fillHostVisibleBuffer(device, result->memory, size, data);
+		}
+
+		return storage_buffer_objects.getHandle<backend::StorageBuffer>(result);
 	}
 
 	backend::Shader *Driver::createShaderFromSource(
@@ -825,37 +1541,43 @@ namespace render::backend::vulkan
 		assert(size > 0 && "Invalid shader IL size");
 		assert(data != nullptr && "Invalid shader IL data");
 
-		Shader *result = new Shader();
+		Shader *result = shader_objects.allocate();
 		result->type = type;
 		result->module = Utils::createShaderModule(device, reinterpret_cast<const uint32_t *>(data), size);
 
-		return result;
+		return shader_objects.getHandle<backend::Shader>(result);
 	}
 
 	backend::BindSet *Driver::createBindSet()
 	{
-		BindSet *result = new BindSet();
+		BindSet *result = bind_set_objects.allocate();
 		memset(result, 0, sizeof(BindSet));
 
-		return result;
+		return bind_set_objects.getHandle<backend::BindSet>(result);
 	}
 
 	backend::PipelineState *Driver::createPipelineState()
 	{
-		PipelineState *result = new PipelineState();
+		PipelineState *result = pipeline_state_objects.allocate();
 		memset(result, 0, sizeof(PipelineState));
 
 		result->cull_mode = VK_CULL_MODE_BACK_BIT;
 		result->primitive_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		result->depth_compare_func = VK_COMPARE_OP_LESS_OR_EQUAL;
 
-		return result;
+		return pipeline_state_objects.getHandle<backend::PipelineState>(result);
 	}
 
 	backend::SwapChain *Driver::createSwapChain(void *native_window)
 	{
 		assert(native_window != nullptr && "Invalid window");
 
+		if (device->isHeadless())
+		{
+			std::cerr << "Driver::createSwapChain(): headless driver can only create offscreen swap chains" << std::endl;
+			return nullptr;
+		}
+
 		SwapChain *result = new SwapChain();
 
 		// Create platform surface
@@ -864,7 +1586,7 @@ namespace render::backend::vulkan
 		{
 			std::cerr << "Driver::createSwapChain(): can't create platform surface" << std::endl;
 			destroySwapChain(result);
-			return false;
+			return nullptr;
 		}
 
 		// Fetch present queue family
@@ -880,7 +1602,7 @@ namespace render::backend::vulkan
 		{
 			std::cerr << "Driver::createSwapChain(): can't get present queue from logical device" << std::endl;
 			destroySwapChain(result);
-			return false;
+			return nullptr;
 		}
 
 		helpers::selectOptimalSwapChainSettings(device, result);
@@ -889,19 +1611,130 @@ namespace render::backend::vulkan
 		return result;
 	}
 
+	backend::SwapChain *Driver::createOffscreenSwapChain(uint32_t width, uint32_t height, uint32_t num_images)
+	{
+		assert(width != 0 && height != 0 && "Invalid swap chain size");
+		assert(num_images != 0 && num_images < SwapChain::MAX_IMAGES && "Invalid image count");
+
+		SwapChain *result = new SwapChain();
+
+		result->offscreen = true;
+		result->readable = true;
+		result->present_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		result->present_queue_family = device->getGraphicsQueueFamily();
+		result->present_queue = device->getGraphicsQueue();
+		result->surface_format = { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+		result->sizes = { width, height };
+		result->num_images = num_images;
+
+		// acquire starts from the first image
+		result->current_image = num_images - 1;
+		result->current_frame = num_images - 1;
+
+		if (!helpers::createSwapChainObjects(this, device, result))
+		{
+			std::cerr << "Driver::createOffscreenSwapChain(): can't create swap chain objects" << std::endl;
+			destroySwapChain(result);
+			return nullptr;
+		}
+
+		return result;
+	}
+
+	backend::Sampler *Driver::createSampler(
+		const SamplerDescription &description
+	)
+	{
+		VkSampler sampler = sampler_cache->fetch(description);
+		if (sampler == VK_NULL_HANDLE)
+			return nullptr;
+
+		Sampler *result = sampler_objects.allocate();
+		result->sampler = sampler;
+
+		return sampler_objects.getHandle<backend::Sampler>(result);
+	}
+
+	backend::GeometryArena *Driver::createGeometryArena(
+		uint16_t vertex_size,
+		uint8_t num_attributes,
+		const VertexAttribute *attributes,
+		IndexFormat index_format,
+		uint32_t num_vertices,
+		uint32_t num_indices
+	)
+	{
+		return new GeometryArena(device, submit_tracker, destroy_queue, vertex_size, num_attributes, attributes, index_format, num_vertices, num_indices);
+	}
+
+	backend::QueryPool *Driver::createQueryPool(
+		QueryType type,
+		uint32_t num_queries
+	)
+	{
+		assert(num_queries != 0 && "Invalid query count");
+
+		if (type == QueryType::TIMESTAMP && !device->hasTimestamps())
+			return nullptr;
+
+		if (type == QueryType::PIPELINE_STATISTICS && !device->hasPipelineStatistics())
+			return nullptr;
+
+		QueryPool *result = query_pool_objects.allocate();
+		backend::QueryPool *handle = query_pool_objects.getHandle<backend::QueryPool>(result);
+		result->type = type;
+		result->num_queries = num_queries;
+
+		VkQueryPoolCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		info.queryCount = num_queries;
+
+		if (type == QueryType::TIMESTAMP)
+		{
+			uint32_t valid_bits = device->getTimestampValidBits();
+
+			info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			result->result_size = sizeof(uint64_t);
+			result->timestamp_mask = (valid_bits < 64) ? (1ULL << valid_bits) - 1 : ~0ULL;
+		}
+		else if (type == QueryType::PIPELINE_STATISTICS)
+		{
+			// order of flags matches PipelineStatistics members
+			info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+				| VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+			result->result_size = sizeof(PipelineStatistics);
+		}
+
+		if (vkCreateQueryPool(device->getDevice(), &info, nullptr, &result->pool) != VK_SUCCESS)
+		{
+			std::cerr << "Driver::createQueryPool(): can't create query pool" << std::endl;
+			destroyQueryPool(handle);
+			return nullptr;
+		}
+
+		return handle;
+	}
+
 	void Driver::destroyVertexBuffer(backend::VertexBuffer *vertex_buffer)
 	{
 		if (vertex_buffer == nullptr)
 			return;
 
-		VertexBuffer *vk_vertex_buffer = static_cast<VertexBuffer *>(vertex_buffer);
+		VertexBuffer *vk_vertex_buffer = vertex_buffer_objects.get(vertex_buffer);
 
-		vmaDestroyBuffer(device->getVRAMAllocator(), vk_vertex_buffer->buffer, vk_vertex_buffer->memory);
+		if (vk_vertex_buffer->type != BufferType::TRANSIENT)
+			destroy_queue->destroyBuffer(vk_vertex_buffer->buffer, vk_vertex_buffer->memory);
 
 		vk_vertex_buffer->buffer = VK_NULL_HANDLE;
 		vk_vertex_buffer->memory = VK_NULL_HANDLE;
 
-		delete vk_vertex_buffer;
+		vertex_buffer_objects.free(vk_vertex_buffer);
 		vk_vertex_buffer = nullptr;
 	}
 
@@ -910,14 +1743,15 @@ namespace render::backend::vulkan
 		if (index_buffer == nullptr)
 			return;
 
-		IndexBuffer *vk_index_buffer = static_cast<IndexBuffer *>(index_buffer);
+		IndexBuffer *vk_index_buffer = index_buffer_objects.get(index_buffer);
 
-		vmaDestroyBuffer(device->getVRAMAllocator(), vk_index_buffer->buffer, vk_index_buffer->memory);
+		if (vk_index_buffer->type != BufferType::TRANSIENT)
+			destroy_queue->destroyBuffer(vk_index_buffer->buffer, vk_index_buffer->memory);
 
 		vk_index_buffer->buffer = VK_NULL_HANDLE;
 		vk_index_buffer->memory = VK_NULL_HANDLE;
 
-		delete vk_index_buffer;
+		index_buffer_objects.free(vk_index_buffer);
 		vk_index_buffer = nullptr;
 	}
 
@@ -926,21 +1760,27 @@ namespace render::backend::vulkan
 		if (texture == nullptr)
 			return;
 
-		Texture *vk_texture = static_cast<Texture *>(texture);
+		Texture *vk_texture = texture_objects.get(texture);
+
+		if (vk_texture->bindless_index != INVALID_BINDLESS_INDEX)
+			bindless_table->free(vk_texture->bindless_index);
 
-		vmaDestroyImage(device->getVRAMAllocator(), vk_texture->image, vk_texture->memory);
+		// framebuffers must go before the views they reference
+		frame_buffer_cache->evict(vk_texture->image);
+
+		destroy_queue->destroyImage(vk_texture->image, vk_texture->memory);
 
 		vk_texture->image = VK_NULL_HANDLE;
 		vk_texture->memory = VK_NULL_HANDLE;
 		vk_texture->format = VK_FORMAT_UNDEFINED;
 
-		vkDestroySampler(device->getDevice(), vk_texture->sampler, nullptr);
+		// sampler is owned by the sampler cache
 		vk_texture->sampler = VK_NULL_HANDLE;
 
-		delete vk_texture->image_view_cache;
+		destroy_queue->destroyImageViews(vk_texture->image_view_cache);
 		vk_texture->image_view_cache = nullptr;
 
-		delete vk_texture;
+		texture_objects.free(vk_texture);
 		vk_texture = nullptr;
 	}
 
@@ -949,15 +1789,16 @@ namespace render::backend::vulkan
 		if (frame_buffer == nullptr)
 			return;
 
-		FrameBuffer *vk_frame_buffer = static_cast<FrameBuffer *>(frame_buffer);
+		FrameBuffer *vk_frame_buffer = frame_buffer_objects.get(frame_buffer);
 
+		// cached framebuffers are evicted along with the attachment textures
 		for (uint8_t i = 0; i < vk_frame_buffer->num_attachments; ++i)
+		{
+			vk_frame_buffer->attachment_images[i] = VK_NULL_HANDLE;
 			vk_frame_buffer->attachment_views[i] = VK_NULL_HANDLE;
+		}
 
-		vkDestroyFramebuffer(device->getDevice(), vk_frame_buffer->frame_buffer, nullptr);
-		vk_frame_buffer->frame_buffer = VK_NULL_HANDLE;
-
-		delete vk_frame_buffer;
+		frame_buffer_objects.free(vk_frame_buffer);
 		vk_frame_buffer = nullptr;
 	}
 
@@ -966,12 +1807,15 @@ namespace render::backend::vulkan
 		if (render_pass == nullptr)
 			return;
 
-		RenderPass *vk_render_pass = static_cast<RenderPass *>(render_pass);
+		RenderPass *vk_render_pass = render_pass_objects.get(render_pass);
 
-		vkDestroyRenderPass(device->getDevice(), vk_render_pass->render_pass, nullptr);
+		// queued pipeline compiles hold the handle by value
+		pipeline_cache->wait();
+
+		destroy_queue->destroyRenderPass(vk_render_pass->render_pass);
 		vk_render_pass->render_pass = VK_NULL_HANDLE;
 
-		delete vk_render_pass;
+		render_pass_objects.free(vk_render_pass);
 		vk_render_pass = nullptr;
 	}
 
@@ -980,10 +1824,16 @@ namespace render::backend::vulkan
 		if (command_buffer == nullptr)
 			return;
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+
+		// command pools belong to recording threads, so wait for the last submit instead of deferring
+		vkWaitForFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu, VK_TRUE, UINT64_MAX);
+
+		if (vk_command_buffer->command_buffer != VK_NULL_HANDLE)
+			vkFreeCommandBuffers(device->getDevice(), vk_command_buffer->pool, 1, &vk_command_buffer->command_buffer);
 
-		vkFreeCommandBuffers(device->getDevice(), device->getCommandPool(), 1, &vk_command_buffer->command_buffer);
 		vk_command_buffer->command_buffer = VK_NULL_HANDLE;
+		vk_command_buffer->pool = VK_NULL_HANDLE;
 
 		vkDestroySemaphore(device->getDevice(), vk_command_buffer->rendering_finished_gpu, nullptr);
 		vk_command_buffer->rendering_finished_gpu = VK_NULL_HANDLE;
@@ -991,7 +1841,7 @@ namespace render::backend::vulkan
 		vkDestroyFence(device->getDevice(), vk_command_buffer->rendering_finished_cpu, nullptr);
 		vk_command_buffer->rendering_finished_cpu = VK_NULL_HANDLE;
 
-		delete vk_command_buffer;
+		command_buffer_objects.free(vk_command_buffer);
 		vk_command_buffer = nullptr;
 	}
 
@@ -1000,28 +1850,48 @@ namespace render::backend::vulkan
 		if (uniform_buffer == nullptr)
 			return;
 
-		UniformBuffer *vk_uniform_buffer = static_cast<UniformBuffer *>(uniform_buffer);
+		UniformBuffer *vk_uniform_buffer = uniform_buffer_objects.get(uniform_buffer);
 
-		vmaDestroyBuffer(device->getVRAMAllocator(), vk_uniform_buffer->buffer, vk_uniform_buffer->memory);
+		if (vk_uniform_buffer->type != BufferType::TRANSIENT)
+			destroy_queue->destroyBuffer(vk_uniform_buffer->buffer, vk_uniform_buffer->memory);
 
 		vk_uniform_buffer->buffer = VK_NULL_HANDLE;
 		vk_uniform_buffer->memory = VK_NULL_HANDLE;
 
-		delete vk_uniform_buffer;
+		uniform_buffer_objects.free(vk_uniform_buffer);
 		vk_uniform_buffer = nullptr;
 	}
 
+	void Driver::destroyStorageBuffer(backend::StorageBuffer *storage_buffer)
+	{
+		if (storage_buffer == nullptr)
+			return;
+
+		StorageBuffer *vk_storage_buffer = storage_buffer_objects.get(storage_buffer);
+
+		destroy_queue->destroyBuffer(vk_storage_buffer->buffer, vk_storage_buffer->memory);
+
+		vk_storage_buffer->buffer = VK_NULL_HANDLE;
+		vk_storage_buffer->memory = VK_NULL_HANDLE;
+
+		storage_buffer_objects.free(vk_storage_buffer);
+		vk_storage_buffer = nullptr;
+	}
+
 	void Driver::destroyShader(backend::Shader *shader)
 	{
 		if (shader == nullptr)
 			return;
 
-		Shader *vk_shader = static_cast<Shader *>(shader);
+		Shader *vk_shader = shader_objects.get(shader);
+
+		// queued pipeline compiles hold the handle by value
+		pipeline_cache->wait();
 
-		vkDestroyShaderModule(device->getDevice(), vk_shader->module, nullptr);
+		destroy_queue->destroyShaderModule(vk_shader->module);
 		vk_shader->module = VK_NULL_HANDLE;
 
-		delete vk_shader;
+		shader_objects.free(vk_shader);
 		vk_shader = nullptr;
 	}
 
@@ -1030,7 +1900,8 @@ namespace render::backend::vulkan
 		if (bind_set == nullptr)
 			return;
 
-		BindSet *vk_bind_set = static_cast<BindSet *>(bind_set);
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		assert(!vk_bind_set->bindless && "Bindless bind set is owned by the driver");
 
 		for (uint32_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
 		{
@@ -1044,10 +1915,9 @@ namespace render::backend::vulkan
 			BindSet::Data &data = vk_bind_set->binding_data[i];
 		}
 
-		if (vk_bind_set->set != VK_NULL_HANDLE)
-			vkFreeDescriptorSets(device->getDevice(), device->getDescriptorPool(), 1, &vk_bind_set->set);
+		helpers::freeBindSetVersions(descriptor_allocator, vk_bind_set);
 
-		delete vk_bind_set;
+		bind_set_objects.free(vk_bind_set);
 		vk_bind_set = nullptr;
 	}
 
@@ -1056,9 +1926,9 @@ namespace render::backend::vulkan
 		if (pipeline_state == nullptr)
 			return;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
 
-		delete vk_pipeline_state;
+		pipeline_state_objects.free(vk_pipeline_state);
 		vk_pipeline_state = nullptr;
 	}
 
@@ -1069,6 +1939,7 @@ namespace render::backend::vulkan
 
 		SwapChain *vk_swap_chain = static_cast<SwapChain *>(swap_chain);
 
+		// presents are not tracked by submit serials, caller must wait for the device
 		helpers::destroySwapChainObjects(this, device, vk_swap_chain);
 
 		vk_swap_chain->present_queue_family = 0xFFFF;
@@ -1081,13 +1952,56 @@ namespace render::backend::vulkan
 		vk_swap_chain->current_frame = 0;
 
 		// Destroy platform surface
-		Platform::destroySurface(device, vk_swap_chain->surface);
+		if (vk_swap_chain->surface != VK_NULL_HANDLE)
+			Platform::destroySurface(device, vk_swap_chain->surface);
+
 		vk_swap_chain->surface = nullptr;
+		vk_swap_chain->offscreen = false;
+		vk_swap_chain->readable = false;
+		vk_swap_chain->present_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 		delete vk_swap_chain;
 		vk_swap_chain = nullptr;
 	}
 
+	void Driver::destroyQueryPool(backend::QueryPool *query_pool)
+	{
+		if (query_pool == nullptr)
+			return;
+
+		QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
+
+		destroy_queue->destroyQueryPool(vk_query_pool->pool);
+		vk_query_pool->pool = VK_NULL_HANDLE;
+
+		query_pool_objects.free(vk_query_pool);
+		vk_query_pool = nullptr;
+	}
+
+	void Driver::destroySampler(backend::Sampler *sampler)
+	{
+		if (sampler == nullptr)
+			return;
+
+		// sampler is owned by the sampler cache and may be shared with textures
+		Sampler *vk_sampler = sampler_objects.get(sampler);
+		vk_sampler->sampler = VK_NULL_HANDLE;
+
+		sampler_objects.free(vk_sampler);
+		vk_sampler = nullptr;
+	}
+
+	void Driver::destroyGeometryArena(backend::GeometryArena *arena)
+	{
+		if (arena == nullptr)
+			return;
+
+		GeometryArena *vk_arena = static_cast<GeometryArena *>(arena);
+
+		delete vk_arena;
+		vk_arena = nullptr;
+	}
+
 	/*
 	 */
 	Multisample Driver::getMaxSampleCount()
@@ -1109,37 +2023,40 @@ namespace render::backend::vulkan
 	void Driver::setTextureSamplerWrapMode(backend::Texture *texture, SamplerWrapMode mode)
 	{
 		assert(texture != nullptr && "Invalid texture");
-		Texture *vk_texture = static_cast<Texture *>(texture);
+		Texture *vk_texture = texture_objects.get(texture);
 
-		vkDestroySampler(device->getDevice(), vk_texture->sampler, nullptr);
-		vk_texture->sampler = VK_NULL_HANDLE;
+		// old sampler stays in the cache, frames in flight may still use it
+		vk_texture->sampler_description.wrap_u = mode;
+		vk_texture->sampler_description.wrap_v = mode;
+		vk_texture->sampler_description.wrap_w = mode;
+		vk_texture->sampler = sampler_cache->fetch(vk_texture->sampler_description);
 
-		VkSamplerAddressMode sampler_mode = Utils::getSamplerAddressMode(mode);
-		vk_texture->sampler = Utils::createSampler(device, 0, vk_texture->num_mipmaps, sampler_mode, sampler_mode, sampler_mode);
+		helpers::updateBindlessSampler(bindless_table, vk_texture);
 	}
 
 	void Driver::setTextureSamplerDepthCompare(backend::Texture *texture, bool enabled, DepthCompareFunc func)
 	{
 		assert(texture != nullptr && "Invalid texture");
-		Texture *vk_texture = static_cast<Texture *>(texture);
+		Texture *vk_texture = texture_objects.get(texture);
 
-		vkDestroySampler(device->getDevice(), vk_texture->sampler, nullptr);
-		vk_texture->sampler = VK_NULL_HANDLE;
+		vk_texture->sampler_description.depth_compare = enabled;
+		vk_texture->sampler_description.depth_compare_func = func;
+		vk_texture->sampler = sampler_cache->fetch(vk_texture->sampler_description);
 
-		VkSamplerAddressMode sampler_mode = Utils::getSamplerAddressMode(SamplerWrapMode::REPEAT);
-		VkCompareOp compare_func = Utils::getDepthCompareFunc(func);
-		vk_texture->sampler = Utils::createSampler(device, 0, vk_texture->num_mipmaps, sampler_mode, sampler_mode, sampler_mode, enabled, compare_func);
+		helpers::updateBindlessSampler(bindless_table, vk_texture);
 	}
 
 	void Driver::generateTexture2DMipmaps(backend::Texture *texture)
 	{
 		assert(texture != nullptr && "Invalid texture");
 
-		Texture *vk_texture = static_cast<Texture *>(texture);
+		Texture *vk_texture = texture_objects.get(texture);
+		UploadContext *upload_context = getUploadContext();
+
+		upload_context->beginBatch();
 
 		// prepare for transfer
-		Utils::transitionImageLayout(
-			device,
+		upload_context->transitionImageLayout(
 			vk_texture->image,
 			vk_texture->format,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -1149,20 +2066,17 @@ namespace render::backend::vulkan
 		);
 
 		// generate 2D mipmaps with linear filter
-		Utils::generateImage2DMipmaps(
-			device,
+		upload_context->generateImage2DMipmaps(
 			vk_texture->image,
 			vk_texture->format,
 			vk_texture->width,
 			vk_texture->height,
 			vk_texture->num_mipmaps,
-			vk_texture->format,
 			VK_FILTER_LINEAR
 		);
 
 		// prepare for shader access
-		Utils::transitionImageLayout(
-			device,
+		upload_context->transitionImageLayout(
 			vk_texture->image,
 			vk_texture->format,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -1170,951 +2084,2799 @@ namespace render::backend::vulkan
 			0,
 			vk_texture->num_mipmaps
 		);
+
+		upload_context->endBatch();
 	}
 
 	/*
 	 */
-	void *Driver::map(backend::VertexBuffer *vertex_buffer)
+	bool Driver::isBindlessSupported()
 	{
-		assert(vertex_buffer != nullptr && "Invalid buffer");
-
-		VertexBuffer *vk_vertex_buffer = static_cast<VertexBuffer *>(vertex_buffer);
-		assert(vk_vertex_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+		return bindless_table != nullptr;
+	}
 
-		void *result = nullptr;
-		if (vmaMapMemory(device->getVRAMAllocator(), vk_vertex_buffer->memory, &result) != VK_SUCCESS)
-		{
-			// TODO: log error
-		}
+	uint32_t Driver::getBindlessIndex(const backend::Texture *texture)
+	{
+		assert(texture != nullptr && "Invalid texture");
+		const Texture *vk_texture = texture_objects.get(texture);
 
-		return result;
+		return vk_texture->bindless_index;
 	}
 
-	void Driver::unmap(backend::VertexBuffer *vertex_buffer)
+	backend::BindSet *Driver::getBindlessBindSet()
 	{
-		assert(vertex_buffer != nullptr && "Invalid buffer");
+		return bind_set_objects.getHandle<backend::BindSet>(bindless_bind_set);
+	}
 
-		VertexBuffer *vk_vertex_buffer = static_cast<VertexBuffer *>(vertex_buffer);
-		assert(vk_vertex_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+	/*
+	 */
+	backend::GeometryAllocation *Driver::allocateGeometry(
+		backend::GeometryArena *arena,
+		uint32_t num_vertices,
+		const void *vertices,
+		uint32_t num_indices,
+		const void *indices
+	)
+	{
+		assert(arena != nullptr && "Invalid geometry arena");
 
-		vmaUnmapMemory(device->getVRAMAllocator(), vk_vertex_buffer->memory);
+		GeometryArena *vk_arena = static_cast<GeometryArena *>(arena);
+		return vk_arena->allocate(getUploadContext(), num_vertices, vertices, num_indices, indices);
 	}
 
-	void *Driver::map(backend::IndexBuffer *index_buffer)
+	void Driver::freeGeometry(backend::GeometryArena *arena, backend::GeometryAllocation *allocation)
 	{
-		assert(index_buffer != nullptr && "Invalid uniform buffer");
+		assert(arena != nullptr && "Invalid geometry arena");
 
-		IndexBuffer *vk_index_buffer = static_cast<IndexBuffer *>(index_buffer);
-		assert(vk_index_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+		GeometryArena *vk_arena = static_cast<GeometryArena *>(arena);
+		vk_arena->free(static_cast<GeometryAllocation *>(allocation));
+	}
 
-		void *result = nullptr;
-		if (vmaMapMemory(device->getVRAMAllocator(), vk_index_buffer->memory, &result) != VK_SUCCESS)
-		{
-			// TODO: log error
-		}
+	GeometryRange Driver::getGeometryRange(const backend::GeometryArena *arena, const backend::GeometryAllocation *allocation)
+	{
+		assert(arena != nullptr && "Invalid geometry arena");
 
-		return result;
+		const GeometryArena *vk_arena = static_cast<const GeometryArena *>(arena);
+		return vk_arena->getRange(static_cast<const GeometryAllocation *>(allocation));
 	}
 
-	void Driver::unmap(backend::IndexBuffer *index_buffer)
+	void Driver::compactGeometryArena(backend::GeometryArena *arena)
 	{
-		assert(index_buffer != nullptr && "Invalid buffer");
+		assert(arena != nullptr && "Invalid geometry arena");
 
-		IndexBuffer *vk_index_buffer = static_cast<IndexBuffer *>(index_buffer);
-		assert(vk_index_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+		GeometryArena *vk_arena = static_cast<GeometryArena *>(arena);
+		vk_arena->compact(getUploadContext());
+	}
 
-		vmaUnmapMemory(device->getVRAMAllocator(), vk_index_buffer->memory);
+	/*
+	 */
+	uint32_t Driver::getNumDescriptorPools()
+	{
+		return descriptor_allocator->getNumPools();
 	}
 
-	void *Driver::map(backend::UniformBuffer *uniform_buffer)
+	DescriptorPoolStats Driver::getDescriptorPoolStats(uint32_t index)
 	{
-		assert(uniform_buffer != nullptr && "Invalid uniform buffer");
+		return descriptor_allocator->getPoolStats(index);
+	}
 
-		UniformBuffer *vk_uniform_buffer = static_cast<UniformBuffer *>(uniform_buffer);
-		assert(vk_uniform_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+	void Driver::getMemoryStats(MemoryStats *stats)
+	{
+		assert(stats != nullptr && "Invalid stats");
 
-		void *result = nullptr;
-		if (vmaMapMemory(device->getVRAMAllocator(), vk_uniform_buffer->memory, &result) != VK_SUCCESS)
+		VmaAllocator allocator = device->getVRAMAllocator();
+
+		const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+		vmaGetMemoryProperties(allocator, &memory_properties);
+
+		// without VK_EXT_memory_budget usage is what the allocator owns and budget is a fixed part of the heap
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+		vmaGetBudget(allocator, budgets);
+
+		stats->num_heaps = std::min<uint32_t>(memory_properties->memoryHeapCount, MemoryStats::MAX_HEAPS);
+		for (uint32_t i = 0; i < stats->num_heaps; ++i)
 		{
-			// TODO: log error
+			const VkMemoryHeap &heap = memory_properties->memoryHeaps[i];
+			MemoryHeapStats &heap_stats = stats->heaps[i];
+
+			heap_stats.size = heap.size;
+			heap_stats.budget = budgets[i].budget;
+			heap_stats.usage = budgets[i].usage;
+			heap_stats.allocated_bytes = budgets[i].blockBytes;
+			heap_stats.used_bytes = budgets[i].allocationBytes;
+			heap_stats.device_local = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
 		}
 
-		return result;
+		device->getMemoryTracker()->getStats(stats->categories);
+		stats->exact_budget = device->hasMemoryBudget();
 	}
 
-	void Driver::unmap(backend::UniformBuffer *uniform_buffer)
+	bool Driver::defragmentMemory(backend::CommandBuffer *command_buffer, uint64_t max_bytes, uint32_t max_allocations, DefragmentationStats *stats)
 	{
-		assert(uniform_buffer != nullptr && "Invalid buffer");
+		struct MovableBuffer
+		{
+			VkBuffer *buffer {nullptr};
+			VkDeviceSize size {0};
+			VkBufferUsageFlags usage {0};
+		};
 
-		UniformBuffer *vk_uniform_buffer = static_cast<UniformBuffer *>(uniform_buffer);
-		assert(vk_uniform_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+		if (stats)
+			*stats = {};
 
-		vmaUnmapMemory(device->getVRAMAllocator(), vk_uniform_buffer->memory);
-	}
+		if (command_buffer == nullptr)
+			return false;
 
-	/*
-	 */
-	void Driver::flush(backend::BindSet *bind_set)
-	{
-		if (bind_set == nullptr)
-			return;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		assert(vk_command_buffer->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && "Defragmentation must be recorded into a primary command buffer");
+		assert(vk_command_buffer->render_pass == VK_NULL_HANDLE && "Defragmentation is not allowed inside render passes");
 
-		BindSet *vk_bind_set = static_cast<BindSet *>(bind_set);
+		VmaAllocator allocator = device->getVRAMAllocator();
 
-		VkWriteDescriptorSet writes[BindSet::MAX_BINDINGS];
-		VkDescriptorImageInfo image_infos[BindSet::MAX_BINDINGS];
-		VkDescriptorBufferInfo buffer_infos[BindSet::MAX_BINDINGS];
+		// previous moves are still in flight, their blocks are released by the destroy queue
+		if (defragmentation_serial != 0)
+		{
+			if (!submit_tracker->isComplete(defragmentation_serial))
+				return true;
 
-		uint32_t write_size = 0;
-		uint32_t image_size = 0;
-		uint32_t buffer_size = 0;
-
-		VkDescriptorSetLayout new_layout = descriptor_set_layout_cache->fetch(vk_bind_set);
-		helpers::updateBindSetLayout(device, vk_bind_set, new_layout);
+			destroy_queue->retire();
+			defragmentation_serial = 0;
 
-		for (uint8_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
-		{
-			if (!vk_bind_set->binding_used[i])
-				continue;
+			if (stats)
+			{
+				stats->bytes_freed = defragmentation_stats.bytesFreed;
+				stats->memory_blocks_freed = defragmentation_stats.deviceMemoryBlocksFreed;
+			}
+		}
 
-			if (!vk_bind_set->binding_dirty[i])
-				continue;
+		// only static buffers are never mapped and never referenced by descriptors,
+		// arenas compact themselves and images would need new views & descriptors
+		std::vector<MovableBuffer> buffers;
+		std::vector<VmaAllocation> allocations;
 
-			VkDescriptorType descriptor_type = vk_bind_set->bindings[i].descriptorType;
-			const BindSet::Data &data = vk_bind_set->binding_data[i];
+		vertex_buffer_objects.forEach(
+			[&](VertexBuffer *vertex_buffer)
+			{
+				if (vertex_buffer->type != BufferType::STATIC || vertex_buffer->memory == VK_NULL_HANDLE)
+					return;
 
-			VkWriteDescriptorSet write_set = {};
-			write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			write_set.dstSet = vk_bind_set->set;
-			write_set.dstBinding = i;
-			write_set.dstArrayElement = 0;
+				VkDeviceSize size = vertex_buffer->vertex_size * vertex_buffer->num_vertices;
+				buffers.push_back({ &vertex_buffer->buffer, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT });
+				allocations.push_back(vertex_buffer->memory);
+			}
+		);
 
-			switch (descriptor_type)
+		index_buffer_objects.forEach(
+			[&](IndexBuffer *index_buffer)
 			{
-				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-				{
-					VkDescriptorImageInfo info = {};
-					info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-					info.imageView = data.texture.view;
-					info.sampler = data.texture.sampler;
-
-					image_infos[image_size++] = info;
-					write_set.pImageInfo = &image_infos[image_size - 1];
-				}
-				break;
-				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-				{
-					VkDescriptorBufferInfo info = {};
-					info.buffer = data.ubo.buffer;
-					info.offset = data.ubo.offset;
-					info.range = data.ubo.size;
+				if (index_buffer->type != BufferType::STATIC || index_buffer->memory == VK_NULL_HANDLE)
+					return;
 
-					buffer_infos[buffer_size++] = info;
-					write_set.pBufferInfo = &buffer_infos[buffer_size - 1];
-				}
-				break;
-				default:
-				{
-					assert(false && "Unsupported descriptor type");
-				}
-				break;
+				VkDeviceSize index_size = (index_buffer->index_type == VK_INDEX_TYPE_UINT16) ? 2 : 4;
+				VkDeviceSize size = index_size * index_buffer->num_indices;
+				buffers.push_back({ &index_buffer->buffer, size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT });
+				allocations.push_back(index_buffer->memory);
 			}
+		);
 
-			write_set.descriptorType = descriptor_type;
-			write_set.descriptorCount = 1;
+		if (allocations.empty())
+			return false;
 
-			writes[write_size++] = write_set;
+		std::vector<VkBool32> changed(allocations.size(), VK_FALSE);
 
-			vk_bind_set->binding_dirty[i] = false;
-		}
+		helpers::flushBarriers(vk_command_buffer);
 
-		if (write_size > 0)
-			vkUpdateDescriptorSets(device->getDevice(), write_size, writes, 0, nullptr);
-	}
+		// moves overwrite memory earlier submits may still read or upload into
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
-	void Driver::flush(backend::PipelineState *pipeline_state)
-	{
-		if (pipeline_state == nullptr)
-			return;
+		vkCmdPipelineBarrier(
+			vk_command_buffer->command_buffer,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		// host visible blocks would be moved by memmove right away, under the feet of in flight frames
+		VmaDefragmentationInfo2 info = {};
+		info.allocationCount = static_cast<uint32_t>(allocations.size());
+		info.pAllocations = allocations.data();
+		info.pAllocationsChanged = changed.data();
+		info.maxCpuBytesToMove = 0;
+		info.maxCpuAllocationsToMove = 0;
+		info.maxGpuBytesToMove = max_bytes;
+		info.maxGpuAllocationsToMove = max_allocations;
+		info.commandBuffer = vk_command_buffer->command_buffer;
+
+		// VMA keeps the stats pointer until the context ends
+		defragmentation_stats = {};
+		VmaDefragmentationContext context = VK_NULL_HANDLE;
+
+		VkResult result = vmaDefragmentationBegin(allocator, &info, &defragmentation_stats, &context);
+		if (result < VK_SUCCESS)
+		{
+			std::cerr << "Driver::defragmentMemory(): can't defragment memory" << std::endl;
+			return false;
+		}
 
-		for (uint32_t i = 0; i < vk_pipeline_state->num_bind_sets; ++i)
-			flush(vk_pipeline_state->bind_sets[i]);
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
 
-		if (vk_pipeline_state->pipeline_layout == VK_NULL_HANDLE)
+		vkCmdPipelineBarrier(
+			vk_command_buffer->command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+
+		// moves are recorded for the next submit, old blocks are released after it completes
+		if (context != VK_NULL_HANDLE)
 		{
-			vk_pipeline_state->pipeline_layout = pipeline_layout_cache->fetch(vk_pipeline_state);
-			vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+			destroy_queue->endDefragmentation(context);
+			defragmentation_serial = submit_tracker->getCurrentSerial();
 		}
 
-		if (vk_pipeline_state->pipeline == VK_NULL_HANDLE)
-			vk_pipeline_state->pipeline = pipeline_cache->fetch(vk_pipeline_state->pipeline_layout, vk_pipeline_state);
-	}
+		// old buffers still point to the previous place, bind new ones to the moved memory
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			if (!changed[i])
+				continue;
 
-	/*
-	 */
-	bool Driver::acquire(backend::SwapChain *swap_chain, uint32_t *new_image)
-	{
-		SwapChain *vk_swap_chain = static_cast<SwapChain *>(swap_chain);
+			const MovableBuffer &movable = buffers[i];
 
-		vk_swap_chain->current_frame++;
-		vk_swap_chain->current_frame %= vk_swap_chain->num_images;
+			// previous frames may still read through the old buffer
+			destroy_queue->destroyBuffer(*movable.buffer, VK_NULL_HANDLE);
 
-		VkSemaphore sync = vk_swap_chain->image_available_gpu[vk_swap_chain->current_frame];
+			VkBufferCreateInfo buffer_info = {};
+			buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_info.size = movable.size;
+			buffer_info.usage = movable.usage;
+			buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		VkResult result = vkAcquireNextImageKHR(
-			device->getDevice(),
-			vk_swap_chain->swap_chain,
-			std::numeric_limits<uint64_t>::max(),
-			sync,
-			VK_NULL_HANDLE,
-			&vk_swap_chain->current_image
-		);
+			VkResult buffer_result = vkCreateBuffer(device->getDevice(), &buffer_info, nullptr, movable.buffer);
+			assert((buffer_result == VK_SUCCESS) && "Can't create buffer");
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
-			return false;
+			buffer_result = vmaBindBufferMemory(allocator, allocations[i], *movable.buffer);
+			assert((buffer_result == VK_SUCCESS) && "Can't bind buffer memory");
+		}
 
-		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		if (stats)
 		{
-			// TODO: log fatal
-			// runtime_error("Can't acquire swap chain image");
-			return false;
+			stats->bytes_moved = defragmentation_stats.bytesMoved;
+			stats->allocations_moved = defragmentation_stats.allocationsMoved;
 		}
 
-		if (new_image)
-			*new_image = vk_swap_chain->current_image;
+		return defragmentation_stats.allocationsMoved > 0;
+	}
 
-		return true;
+	TransientAllocation Driver::allocateTransient(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		return transient_allocator->allocate(size, alignment);
 	}
 
-	bool Driver::present(backend::SwapChain *swap_chain, uint32_t num_wait_command_buffers, backend::CommandBuffer * const *wait_command_buffers)
+	UploadContext *Driver::getUploadContext()
 	{
-		SwapChain *vk_swap_chain = static_cast<SwapChain *>(swap_chain);
+		std::lock_guard<std::mutex> lock(upload_contexts_mutex);
 
-		std::vector<VkSemaphore> wait_semaphores(num_wait_command_buffers);
+		UploadContext *&result = upload_contexts[std::this_thread::get_id()];
+		if (result == nullptr)
+			result = new UploadContext(device);
 
-		if (num_wait_command_buffers != 0 && wait_command_buffers != nullptr)
-		{
-			for (uint32_t i = 0; i < num_wait_command_buffers; ++i)
-			{
-				const CommandBuffer *vk_wait_command_buffer = static_cast<const CommandBuffer *>(wait_command_buffers[i]);
-				wait_semaphores[i] = vk_wait_command_buffer->rendering_finished_gpu;
-			}
-		}
+		return result;
+	}
 
-		VkPresentInfoKHR info = {};
-		info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		info.swapchainCount = 1;
-		info.pSwapchains = &vk_swap_chain->swap_chain;
-		info.pImageIndices = &vk_swap_chain->current_image;
+	VkCommandPool Driver::getCommandPool()
+	{
+		std::lock_guard<std::mutex> lock(command_pools_mutex);
 
-		if (wait_semaphores.size())
-		{
-			info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
-			info.pWaitSemaphores = wait_semaphores.data();
-		}
+		VkCommandPool &result = command_pools[std::this_thread::get_id()];
+		if (result != VK_NULL_HANDLE)
+			return result;
 
-		VkResult result = vkQueuePresentKHR(vk_swap_chain->present_queue, &info);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
-			return false;
+		VkCommandPoolCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		info.queueFamilyIndex = device->getGraphicsQueueFamily();
+		info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-		if (result != VK_SUCCESS)
-		{
-			// TODO: log fatal
-			// runtime_error("Can't present swap chain image");
-			return false;
-		}
+		if (vkCreateCommandPool(device->getDevice(), &info, nullptr, &result) != VK_SUCCESS)
+			std::cerr << "Driver::getCommandPool(): can't create command pool" << std::endl;
 
-		return true;
+		return result;
 	}
 
-	void Driver::wait()
+	void Driver::beginUploadBatch()
 	{
-		assert(device != nullptr && "Invalid device");
+		getUploadContext()->beginBatch();
+	}
 
-		vkDeviceWaitIdle(device->getDevice());
+	bool Driver::endUploadBatch()
+	{
+		return getUploadContext()->endBatch();
 	}
 
-	bool Driver::wait(
-		uint32_t num_wait_command_buffers,
-		backend::CommandBuffer * const *wait_command_buffers
-	)
+	uint64_t Driver::endUploadBatchAsync()
 	{
-		if (num_wait_command_buffers == 0)
-			return true;
+		return getUploadContext()->endBatchAsync();
+	}
 
-		std::vector<VkFence> wait_fences(num_wait_command_buffers);
+	bool Driver::isUploadComplete(uint64_t ticket)
+	{
+		std::lock_guard<std::mutex> lock(upload_contexts_mutex);
+
+		for (auto &it : upload_contexts)
+			if (!it.second->isComplete(ticket))
+				return false;
+
+		return true;
+	}
+
+	void Driver::releaseThreadResources()
+	{
+		std::thread::id thread_id = std::this_thread::get_id();
+		UploadContext *upload_context = nullptr;
 
-		for (uint32_t i = 0; i < num_wait_command_buffers; ++i)
 		{
-			const CommandBuffer *vk_wait_command_buffer = static_cast<const CommandBuffer *>(wait_command_buffers[i]);
-			wait_fences[i] = vk_wait_command_buffer->rendering_finished_cpu;
+			std::lock_guard<std::mutex> lock(upload_contexts_mutex);
+
+			auto it = upload_contexts.find(thread_id);
+			if (it != upload_contexts.end())
+			{
+				upload_context = it->second;
+				upload_contexts.erase(it);
+			}
 		}
 
-		VkResult result = vkWaitForFences(device->getDevice(), num_wait_command_buffers, wait_fences.data(), VK_TRUE, UINT64_MAX);
+		// submits the open batch and waits for in flight ones, their tickets read as complete afterwards
+		delete upload_context;
 
-		return result == VK_SUCCESS;
+		std::lock_guard<std::mutex> lock(command_pools_mutex);
+
+		auto it = command_pools.find(thread_id);
+		if (it == command_pools.end())
+			return;
+
+		VkCommandPool command_pool = it->second;
+		bool in_use = false;
+
+		command_buffer_objects.forEach(
+			[command_pool, &in_use](CommandBuffer *command_buffer)
+			{
+				in_use = in_use || (command_buffer->pool == command_pool);
+			}
+		);
+
+		// the pool is released with the driver then
+		if (in_use)
+		{
+			std::cerr << "Driver::releaseThreadResources(): command buffers created by the thread are still alive" << std::endl;
+			return;
+		}
+
+		command_pools.erase(it);
+		vkDestroyCommandPool(device->getDevice(), command_pool, nullptr);
 	}
 
 	/*
 	 */
-	void Driver::bindUniformBuffer(
-		backend::BindSet *bind_set,
-		uint32_t binding,
-		const backend::UniformBuffer *uniform_buffer
+	uint64_t Driver::readTexture(
+		backend::CommandBuffer *command_buffer,
+		const backend::Texture *texture,
+		uint32_t mip,
+		uint32_t layer
 	)
 	{
-		assert(binding < BindSet::MAX_BINDINGS);
+		if (command_buffer == nullptr || texture == nullptr)
+			return 0;
 
-		if (bind_set == nullptr)
-			return;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const Texture *vk_texture = texture_objects.get(texture);
 
-		BindSet *vk_bind_set = static_cast<BindSet *>(bind_set);
-		const UniformBuffer *vk_uniform_buffer = static_cast<const UniformBuffer *>(uniform_buffer);
-		
-		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
-		BindSet::Data &data = vk_bind_set->binding_data[binding];
+		assert(vk_command_buffer->current_render_pass == nullptr && "Readbacks are not allowed inside render passes");
+		assert(mip < vk_texture->num_mipmaps && "Invalid mip");
+		assert(layer < vk_texture->num_layers && "Invalid layer");
+		assert(vk_texture->samples == VK_SAMPLE_COUNT_1_BIT && "Multisampled textures must be resolved before readback");
 
-		bool buffer_changed = (data.ubo.buffer != vk_uniform_buffer->buffer) || (data.ubo.size != vk_uniform_buffer->size);
-		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+		uint32_t texel_size = helpers::getReadbackTexelSize(vk_texture->format);
+		if (texel_size == 0)
+		{
+			std::cerr << "Driver::readTexture(): texture format is not supported" << std::endl;
+			return 0;
+		}
 
-		vk_bind_set->binding_used[binding] = (vk_uniform_buffer != nullptr);
-		vk_bind_set->binding_dirty[binding] = type_changed || buffer_changed;
+		VkExtent3D extent;
+		extent.width = std::max<uint32_t>(vk_texture->width >> mip, 1);
+		extent.height = std::max<uint32_t>(vk_texture->height >> mip, 1);
+		extent.depth = std::max<uint32_t>(vk_texture->depth >> mip, 1);
 
-		if (vk_uniform_buffer == nullptr)
-			return;
+		VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * extent.depth * texel_size;
 
-		data.ubo.buffer = vk_uniform_buffer->buffer;
-		data.ubo.size = vk_uniform_buffer->size;
-		data.ubo.offset = 0;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
 
-		info.binding = binding;
-		info.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		info.descriptorCount = 1;
-		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
-		info.pImmutableSamplers = nullptr;
+		// buffer offset must be a multiple of both 4 and the texel size
+		uint64_t ticket = readback_ring->allocate(size, texel_size * 4, buffer, offset);
+		if (ticket == 0)
+			return 0;
+
+		TextureSubresourceState previous = vk_texture->states[layer * vk_texture->num_mipmaps + mip];
+
+		transitionTexture(command_buffer, texture, TextureState::TRANSFER_SRC, mip, 1, layer, 1);
+		helpers::flushBarriers(vk_command_buffer);
+
+		helpers::copyImageToReadback(vk_command_buffer, vk_texture->image, helpers::getReadbackAspect(vk_texture->format), mip, layer, extent, buffer, offset);
+		helpers::makeReadbackHostVisible(vk_command_buffer);
+
+		// readback is invisible to the caller, the subresource goes back to its previous state with the next flush
+		// previous users may rely on implicit render pass dependencies, so the restore waits for everything
+		if (previous.layout == VK_IMAGE_LAYOUT_UNDEFINED || previous.layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+			return ticket;
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = previous.layout;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = vk_texture->image;
+		barrier.subresourceRange.aspectMask = Utils::getImageAspectFlags(vk_texture->format);
+		barrier.subresourceRange.baseMipLevel = mip;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = layer;
+		barrier.subresourceRange.layerCount = 1;
+
+		vk_command_buffer->pending_barriers.push_back(barrier);
+		vk_command_buffer->pending_src_stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		vk_command_buffer->pending_dst_stages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		helpers::setTextureState(vk_texture, mip, 1, layer, 1, previous.layout, previous.access, previous.stages);
+
+		return ticket;
 	}
 
-	void Driver::bindTexture(
-		backend::BindSet *bind_set,
-		uint32_t binding,
-		const backend::Texture *texture
+	uint64_t Driver::readBuffer(
+		backend::CommandBuffer *command_buffer,
+		const backend::StorageBuffer *storage_buffer,
+		uint32_t offset,
+		uint32_t size
 	)
 	{
-		assert(binding < BindSet::MAX_BINDINGS);
+		if (command_buffer == nullptr || storage_buffer == nullptr)
+			return 0;
 
-		if (bind_set == nullptr)
-			return;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const StorageBuffer *vk_storage_buffer = storage_buffer_objects.get(storage_buffer);
 
-		BindSet *vk_bind_set = static_cast<BindSet *>(bind_set);
-		const Texture *vk_texture = static_cast<const Texture *>(texture);
+		assert(vk_command_buffer->current_render_pass == nullptr && "Readbacks are not allowed inside render passes");
+		assert(offset < vk_storage_buffer->size && "Invalid offset");
 
-		uint32_t num_mipmaps = (vk_texture) ? vk_texture->num_mipmaps : 0;
-		uint32_t num_layers = (vk_texture) ? vk_texture->num_layers : 0;
+		if (size == 0)
+			size = vk_storage_buffer->size - offset;
+
+		assert(offset + size <= vk_storage_buffer->size && "Invalid size");
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize buffer_offset = 0;
+
+		uint64_t ticket = readback_ring->allocate(size, 16, buffer, buffer_offset);
+		if (ticket == 0)
+			return 0;
+
+		helpers::flushBarriers(vk_command_buffer);
+
+		// wait for shader and transfer writes recorded before
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		VkPipelineStageFlags src_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		vkCmdPipelineBarrier(vk_command_buffer->command_buffer, src_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-		bindTexture(bind_set, binding, texture, 0, num_mipmaps, 0, num_layers);
+		VkBufferCopy region = {};
+		region.srcOffset = offset;
+		region.dstOffset = buffer_offset;
+		region.size = size;
+
+		vkCmdCopyBuffer(vk_command_buffer->command_buffer, vk_storage_buffer->buffer, buffer, 1, &region);
+		helpers::makeReadbackHostVisible(vk_command_buffer);
+
+		return ticket;
 	}
 
-	void Driver::bindTexture(
-		backend::BindSet *bind_set,
-		uint32_t binding,
-		const backend::Texture *texture,
-		uint32_t base_mip,
-		uint32_t num_mipmaps,
-		uint32_t base_layer,
-		uint32_t num_layers
+	uint64_t Driver::readSwapChain(
+		backend::CommandBuffer *command_buffer,
+		const backend::SwapChain *swap_chain
 	)
 	{
-		assert(binding < BindSet::MAX_BINDINGS);
+		if (command_buffer == nullptr || swap_chain == nullptr)
+			return 0;
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const SwapChain *vk_swap_chain = static_cast<const SwapChain *>(swap_chain);
+
+		assert(vk_command_buffer->current_render_pass == nullptr && "Readbacks are not allowed inside render passes");
+
+		if (!vk_swap_chain->readable)
+		{
+			std::cerr << "Driver::readSwapChain(): surface doesn't support transfer source usage" << std::endl;
+			return 0;
+		}
+
+		VkFormat format = vk_swap_chain->surface_format.format;
+
+		uint32_t texel_size = helpers::getReadbackTexelSize(format);
+		if (texel_size == 0)
+		{
+			std::cerr << "Driver::readSwapChain(): surface format is not supported" << std::endl;
+			return 0;
+		}
+
+		VkExtent3D extent = { vk_swap_chain->sizes.width, vk_swap_chain->sizes.height, 1 };
+		VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * texel_size;
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+
+		uint64_t ticket = readback_ring->allocate(size, texel_size * 4, buffer, offset);
+		if (ticket == 0)
+			return 0;
+
+		helpers::flushBarriers(vk_command_buffer);
+
+		VkImage image = vk_swap_chain->images[vk_swap_chain->current_image];
+
+		// rendering left the image in present layout, offscreen images are already in transfer source layout
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = vk_swap_chain->present_layout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		vkCmdPipelineBarrier(vk_command_buffer->command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		helpers::copyImageToReadback(vk_command_buffer, image, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, extent, buffer, offset);
+		helpers::makeReadbackHostVisible(vk_command_buffer);
+
+		if (vk_swap_chain->present_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+			return ticket;
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = vk_swap_chain->present_layout;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = 0;
+
+		vkCmdPipelineBarrier(vk_command_buffer->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		return ticket;
+	}
+
+	bool Driver::isReadbackComplete(uint64_t ticket)
+	{
+		return readback_ring->isComplete(ticket);
+	}
+
+	bool Driver::waitReadback(uint64_t ticket)
+	{
+		return readback_ring->wait(ticket);
+	}
+
+	const void *Driver::getReadbackData(uint64_t ticket, size_t *size)
+	{
+		VkDeviceSize data_size = 0;
+		const void *result = readback_ring->getData(ticket, data_size);
+
+		if (size)
+			*size = static_cast<size_t>(data_size);
+
+		return result;
+	}
+
+	void Driver::releaseReadback(uint64_t ticket)
+	{
+		readback_ring->release(ticket);
+	}
+
+	void Driver::setPipelineCachePath(const char *path)
+	{
+		pipeline_cache->setCachePath(path);
+	}
+
+	void Driver::setAsyncPipelineCompilation(bool enabled)
+	{
+		pipeline_cache->setAsync(enabled);
+	}
+
+	uint32_t Driver::getNumPendingPipelines()
+	{
+		return pipeline_cache->getNumPendingPipelines();
+	}
+
+	/*
+	 */
+	void *Driver::map(backend::VertexBuffer *vertex_buffer)
+	{
+		assert(vertex_buffer != nullptr && "Invalid buffer");
+
+		VertexBuffer *vk_vertex_buffer = vertex_buffer_objects.get(vertex_buffer);
+		assert(vk_vertex_buffer->type != BufferType::STATIC && "Mapped buffer must have BufferType::DYNAMIC or BufferType::TRANSIENT type");
+
+		if (vk_vertex_buffer->type == BufferType::TRANSIENT)
+		{
+			VkDeviceSize size = vk_vertex_buffer->vertex_size * vk_vertex_buffer->num_vertices;
+			TransientAllocation allocation = transient_allocator->allocate(size, 16);
+
+			vk_vertex_buffer->buffer = allocation.buffer;
+			vk_vertex_buffer->offset = allocation.offset;
+
+			return allocation.data;
+		}
+
+		void *result = nullptr;
+		if (vmaMapMemory(device->getVRAMAllocator(), vk_vertex_buffer->memory, &result) != VK_SUCCESS)
+		{
+			// TODO: log error
+		}
+
+		return result;
+	}
+
+	void Driver::unmap(backend::VertexBuffer *vertex_buffer)
+	{
+		assert(vertex_buffer != nullptr && "Invalid buffer");
+
+		VertexBuffer *vk_vertex_buffer = vertex_buffer_objects.get(vertex_buffer);
+		assert(vk_vertex_buffer->type != BufferType::STATIC && "Mapped buffer must have BufferType::DYNAMIC or BufferType::TRANSIENT type");
+
+		// transient memory is persistently mapped and coherent
+		if (vk_vertex_buffer->type == BufferType::TRANSIENT)
+			return;
+
+		vmaUnmapMemory(device->getVRAMAllocator(), vk_vertex_buffer->memory);
+	}
+
+	void *Driver::map(backend::IndexBuffer *index_buffer)
+	{
+		assert(index_buffer != nullptr && "Invalid uniform buffer");
+
+		IndexBuffer *vk_index_buffer = index_buffer_objects.get(index_buffer);
+		assert(vk_index_buffer->type != BufferType::STATIC && "Mapped buffer must have BufferType::DYNAMIC or BufferType::TRANSIENT type");
+
+		if (vk_index_buffer->type == BufferType::TRANSIENT)
+		{
+			VkDeviceSize index_size = (vk_index_buffer->index_type == VK_INDEX_TYPE_UINT32) ? 4 : 2;
+			TransientAllocation allocation = transient_allocator->allocate(index_size * vk_index_buffer->num_indices, 16);
+
+			vk_index_buffer->buffer = allocation.buffer;
+			vk_index_buffer->offset = allocation.offset;
+
+			return allocation.data;
+		}
+
+		void *result = nullptr;
+		if (vmaMapMemory(device->getVRAMAllocator(), vk_index_buffer->memory, &result) != VK_SUCCESS)
+		{
+			// TODO: log error
+		}
+
+		return result;
+	}
+
+	void Driver::unmap(backend::IndexBuffer *index_buffer)
+	{
+		assert(index_buffer != nullptr && "Invalid buffer");
+
+		IndexBuffer *vk_index_buffer = index_buffer_objects.get(index_buffer);
+		assert(vk_index_buffer->type != BufferType::STATIC && "Mapped buffer must have BufferType::DYNAMIC or BufferType::TRANSIENT type");
+
+		// transient memory is persistently mapped and coherent
+		if (vk_index_buffer->type == BufferType::TRANSIENT)
+			return;
+
+		vmaUnmapMemory(device->getVRAMAllocator(), vk_index_buffer->memory);
+	}
+
+	void *Driver::map(backend::UniformBuffer *uniform_buffer)
+	{
+		assert(uniform_buffer != nullptr && "Invalid uniform buffer");
+
+		UniformBuffer *vk_uniform_buffer = uniform_buffer_objects.get(uniform_buffer);
+		assert(vk_uniform_buffer->type != BufferType::STATIC && "Mapped buffer must have BufferType::DYNAMIC or BufferType::TRANSIENT type");
+
+		if (vk_uniform_buffer->type == BufferType::TRANSIENT)
+		{
+			TransientAllocation allocation = transient_allocator->allocate(vk_uniform_buffer->size, transient_allocator->getUniformAlignment());
+			vk_uniform_buffer->offset = allocation.offset;
+
+			return allocation.data;
+		}
+
+		void *result = nullptr;
+		if (vmaMapMemory(device->getVRAMAllocator(), vk_uniform_buffer->memory, &result) != VK_SUCCESS)
+		{
+			// TODO: log error
+		}
+
+		return result;
+	}
+
+	void Driver::unmap(backend::UniformBuffer *uniform_buffer)
+	{
+		assert(uniform_buffer != nullptr && "Invalid buffer");
+
+		UniformBuffer *vk_uniform_buffer = uniform_buffer_objects.get(uniform_buffer);
+		assert(vk_uniform_buffer->type != BufferType::STATIC && "Mapped buffer must have BufferType::DYNAMIC or BufferType::TRANSIENT type");
+
+		// transient memory is persistently mapped and coherent
+		if (vk_uniform_buffer->type == BufferType::TRANSIENT)
+			return;
+
+		vmaUnmapMemory(device->getVRAMAllocator(), vk_uniform_buffer->memory);
+	}
+
+	void *Driver::map(backend::StorageBuffer *storage_buffer)
+	{
+		assert(storage_buffer != nullptr && "Invalid storage buffer");
+
+		StorageBuffer *vk_storage_buffer = storage_buffer_objects.get(storage_buffer);
+		assert(vk_storage_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+
+		void *result = nullptr;
+		if (vmaMapMemory(device->getVRAMAllocator(), vk_storage_buffer->memory, &result) != VK_SUCCESS)
+			std::cerr << "Driver::map(): can't map storage buffer" << std::endl;
+
+		return result;
+	}
+
+	void Driver::unmap(backend::StorageBuffer *storage_buffer)
+	{
+		assert(storage_buffer != nullptr && "Invalid storage buffer");
+
+		StorageBuffer *vk_storage_buffer = storage_buffer_objects.get(storage_buffer);
+		assert(vk_storage_buffer->type == BufferType::DYNAMIC && "Mapped buffer must have BufferType::DYNAMIC type");
+
+		vmaUnmapMemory(device->getVRAMAllocator(), vk_storage_buffer->memory);
+	}
+
+	/*
+	 */
+	void Driver::flush(backend::BindSet *bind_set)
+	{
+		if (bind_set == nullptr)
+			return;
+
+		flushBindSet(bind_set_objects.get(bind_set));
+	}
+
+	void Driver::flush(backend::PipelineState *pipeline_state)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		flushPipelineState(pipeline_state_objects.get(pipeline_state));
+	}
+
+	void Driver::flushBindSet(BindSet *vk_bind_set)
+	{
+		// bindless table is written on texture creation
+		if (vk_bind_set->bindless)
+			return;
+
+		VkWriteDescriptorSet writes[BindSet::MAX_BINDINGS];
+		VkCopyDescriptorSet copies[BindSet::MAX_BINDINGS];
+		VkDescriptorImageInfo image_infos[BindSet::MAX_BINDINGS];
+		VkDescriptorBufferInfo buffer_infos[BindSet::MAX_BINDINGS];
+
+		uint32_t write_size = 0;
+		uint32_t copy_size = 0;
+		uint32_t image_size = 0;
+		uint32_t buffer_size = 0;
+
+		VkDescriptorSetLayout new_layout = descriptor_set_layout_cache->fetch(vk_bind_set);
+		helpers::updateBindSetLayout(descriptor_allocator, vk_bind_set, new_layout);
+
+		// single frame set is gone after its frame, rewrite everything into a persistent version
+		bool transient_expired = (vk_bind_set->current_version == BindSet::TRANSIENT_VERSION);
+		transient_expired = transient_expired && (vk_bind_set->transient_serial != submit_tracker->getCurrentSerial());
+
+		if (transient_expired)
+		{
+			for (uint8_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
+				vk_bind_set->binding_dirty[i] = vk_bind_set->binding_used[i];
+		}
+
+		bool dirty = false;
+		for (uint8_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
+			dirty = dirty || (vk_bind_set->binding_used[i] && vk_bind_set->binding_dirty[i]);
+
+		if (!dirty)
+			return;
+
+		VkDescriptorSet old_set = helpers::switchBindSetVersion(descriptor_allocator, submit_tracker, vk_bind_set);
+
+		for (uint8_t i = 0; i < BindSet::MAX_BINDINGS; ++i)
+		{
+			if (!vk_bind_set->binding_used[i])
+				continue;
+
+			// new version only gets clean bindings from the previous one
+			if (!vk_bind_set->binding_dirty[i] && old_set != VK_NULL_HANDLE)
+			{
+				VkCopyDescriptorSet copy_set = {};
+				copy_set.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+				copy_set.srcSet = old_set;
+				copy_set.srcBinding = i;
+				copy_set.dstSet = vk_bind_set->set;
+				copy_set.dstBinding = i;
+				copy_set.descriptorCount = 1;
+
+				copies[copy_size++] = copy_set;
+			}
+
+			if (!vk_bind_set->binding_dirty[i])
+				continue;
+
+			VkDescriptorType descriptor_type = vk_bind_set->bindings[i].descriptorType;
+			const BindSet::Data &data = vk_bind_set->binding_data[i];
+
+			VkWriteDescriptorSet write_set = {};
+			write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write_set.dstSet = vk_bind_set->set;
+			write_set.dstBinding = i;
+			write_set.dstArrayElement = 0;
+
+			switch (descriptor_type)
+			{
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+				{
+					VkDescriptorImageInfo info = {};
+					info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					info.imageView = data.texture.view;
+					info.sampler = data.texture.sampler;
+
+					image_infos[image_size++] = info;
+					write_set.pImageInfo = &image_infos[image_size - 1];
+				}
+				break;
+				case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+				{
+					VkDescriptorImageInfo info = {};
+					info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+					info.imageView = data.texture.view;
+					info.sampler = VK_NULL_HANDLE;
+
+					image_infos[image_size++] = info;
+					write_set.pImageInfo = &image_infos[image_size - 1];
+				}
+				break;
+				case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+				{
+					VkDescriptorImageInfo info = {};
+					info.imageLayout = data.texture.layout;
+					info.imageView = data.texture.view;
+					info.sampler = VK_NULL_HANDLE;
+
+					image_infos[image_size++] = info;
+					write_set.pImageInfo = &image_infos[image_size - 1];
+				}
+				break;
+				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+				{
+					VkDescriptorBufferInfo info = {};
+					info.buffer = data.ubo.buffer;
+					info.offset = data.ubo.offset;
+					info.range = data.ubo.size;
+
+					buffer_infos[buffer_size++] = info;
+					write_set.pBufferInfo = &buffer_infos[buffer_size - 1];
+				}
+				break;
+				case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+				{
+					VkDescriptorBufferInfo info = {};
+					info.buffer = data.ssbo.buffer;
+					info.offset = 0;
+					info.range = data.ssbo.size;
+
+					buffer_infos[buffer_size++] = info;
+					write_set.pBufferInfo = &buffer_infos[buffer_size - 1];
+				}
+				break;
+				default:
+				{
+					assert(false && "Unsupported descriptor type");
+				}
+				break;
+			}
+
+			write_set.descriptorType = descriptor_type;
+			write_set.descriptorCount = 1;
+
+			writes[write_size++] = write_set;
+
+			vk_bind_set->binding_dirty[i] = false;
+		}
+
+		vkUpdateDescriptorSets(device->getDevice(), write_size, writes, copy_size, copies);
+	}
+
+	void Driver::flushPipelineState(PipelineState *vk_pipeline_state)
+	{
+		for (uint32_t i = 0; i < vk_pipeline_state->num_bind_sets; ++i)
+			if (vk_pipeline_state->bind_sets[i])
+				flushBindSet(vk_pipeline_state->bind_sets[i]);
+
+		if (vk_pipeline_state->pipeline_layout == VK_NULL_HANDLE)
+		{
+			vk_pipeline_state->pipeline_layout = pipeline_layout_cache->fetch(vk_pipeline_state);
+			vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+		}
+
+		if (vk_pipeline_state->pipeline != VK_NULL_HANDLE)
+			return;
+
+		VkShaderModule compute_shader = vk_pipeline_state->shaders[static_cast<int>(ShaderType::COMPUTE)];
+		if (compute_shader != VK_NULL_HANDLE)
+		{
+			vk_pipeline_state->pipeline = pipeline_cache->fetchCompute(vk_pipeline_state->pipeline_layout, compute_shader);
+			return;
+		}
+
+		bool blocking = (vk_pipeline_state->compile_policy == PipelineCompilePolicy::BLOCK);
+		vk_pipeline_state->pipeline = pipeline_cache->fetch(vk_pipeline_state->pipeline_layout, vk_pipeline_state, blocking);
+	}
+
+	/*
+	 */
+	bool Driver::acquire(backend::SwapChain *swap_chain, uint32_t *new_image)
+	{
+		SwapChain *vk_swap_chain = static_cast<SwapChain *>(swap_chain);
+
+		vk_swap_chain->current_frame++;
+		vk_swap_chain->current_frame %= vk_swap_chain->num_images;
+
+		// offscreen images are handed out in order, submits that use them are already ordered on the queue
+		if (vk_swap_chain->offscreen)
+		{
+			vk_swap_chain->current_image = vk_swap_chain->current_frame;
+
+			if (new_image)
+				*new_image = vk_swap_chain->current_image;
+
+			return true;
+		}
+
+		VkSemaphore sync = vk_swap_chain->image_available_gpu[vk_swap_chain->current_frame];
+
+		VkResult result = vkAcquireNextImageKHR(
+			device->getDevice(),
+			vk_swap_chain->swap_chain,
+			std::numeric_limits<uint64_t>::max(),
+			sync,
+			VK_NULL_HANDLE,
+			&vk_swap_chain->current_image
+		);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			return false;
+
+		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			// TODO: log fatal
+			// runtime_error("Can't acquire swap chain image");
+			return false;
+		}
+
+		if (new_image)
+			*new_image = vk_swap_chain->current_image;
+
+		return true;
+	}
+
+	bool Driver::present(backend::SwapChain *swap_chain, uint32_t num_wait_command_buffers, backend::CommandBuffer * const *wait_command_buffers)
+	{
+		SwapChain *vk_swap_chain = static_cast<SwapChain *>(swap_chain);
+
+		std::vector<VkSemaphore> wait_semaphores(num_wait_command_buffers);
+
+		if (num_wait_command_buffers != 0 && wait_command_buffers != nullptr)
+		{
+			for (uint32_t i = 0; i < num_wait_command_buffers; ++i)
+			{
+				const CommandBuffer *vk_wait_command_buffer = command_buffer_objects.get(wait_command_buffers[i]);
+				wait_semaphores[i] = vk_wait_command_buffer->rendering_finished_gpu;
+			}
+		}
+
+		// there is nothing to present offscreen, but semaphores must still be waited on before they are signaled again
+		if (vk_swap_chain->offscreen)
+		{
+			if (wait_semaphores.empty())
+				return true;
+
+			std::vector<VkPipelineStageFlags> wait_stages(wait_semaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+			VkSubmitInfo submit_info = {};
+			submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+			submit_info.pWaitSemaphores = wait_semaphores.data();
+			submit_info.pWaitDstStageMask = wait_stages.data();
+
+			std::lock_guard<std::mutex> lock(device->getQueueMutex());
+			return vkQueueSubmit(vk_swap_chain->present_queue, 1, &submit_info, VK_NULL_HANDLE) == VK_SUCCESS;
+		}
+
+		VkPresentInfoKHR info = {};
+		info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		info.swapchainCount = 1;
+		info.pSwapchains = &vk_swap_chain->swap_chain;
+		info.pImageIndices = &vk_swap_chain->current_image;
+
+		if (wait_semaphores.size())
+		{
+			info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+			info.pWaitSemaphores = wait_semaphores.data();
+		}
+
+		std::lock_guard<std::mutex> lock(device->getQueueMutex());
+
+		VkResult result = vkQueuePresentKHR(vk_swap_chain->present_queue, &info);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+			return false;
+
+		if (result != VK_SUCCESS)
+		{
+			// TODO: log fatal
+			// runtime_error("Can't present swap chain image");
+			return false;
+		}
+
+		return true;
+	}
+
+	void Driver::wait()
+	{
+		assert(device != nullptr && "Invalid device");
+
+		std::lock_guard<std::mutex> lock(device->getQueueMutex());
+		vkDeviceWaitIdle(device->getDevice());
+
+		destroy_queue->retire();
+	}
+
+	bool Driver::wait(
+		uint32_t num_wait_command_buffers,
+		backend::CommandBuffer * const *wait_command_buffers
+	)
+	{
+		if (num_wait_command_buffers == 0)
+			return true;
+
+		std::vector<VkFence> wait_fences(num_wait_command_buffers);
+
+		for (uint32_t i = 0; i < num_wait_command_buffers; ++i)
+		{
+			const CommandBuffer *vk_wait_command_buffer = command_buffer_objects.get(wait_command_buffers[i]);
+			wait_fences[i] = vk_wait_command_buffer->rendering_finished_cpu;
+		}
+
+		VkResult result = vkWaitForFences(device->getDevice(), num_wait_command_buffers, wait_fences.data(), VK_TRUE, UINT64_MAX);
+
+		return result == VK_SUCCESS;
+	}
+
+	/*
+	 */
+	void Driver::bindUniformBuffer(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::UniformBuffer *uniform_buffer
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		const UniformBuffer *vk_uniform_buffer = uniform_buffer_objects.get(uniform_buffer);
+
+		assert(!vk_bind_set->bindless && "Bindless bind set can't be modified");
+
+		// transient buffers move inside the frame ring on every map, so their offset is supplied at draw time
+		if (vk_uniform_buffer && vk_uniform_buffer->type == BufferType::TRANSIENT)
+		{
+			bindDynamicUniformBuffer(bind_set, binding, uniform_buffer, vk_uniform_buffer->size);
+			return;
+		}
+
+		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
+		BindSet::Data &data = vk_bind_set->binding_data[binding];
+
+		bool buffer_changed = (data.ubo.buffer != vk_uniform_buffer->buffer) || (data.ubo.size != vk_uniform_buffer->size);
+		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+
+		vk_bind_set->binding_used[binding] = (vk_uniform_buffer != nullptr);
+		vk_bind_set->binding_dirty[binding] = type_changed || buffer_changed;
+
+		if (vk_uniform_buffer == nullptr)
+			return;
+
+		data.ubo.uniform_buffer = vk_uniform_buffer;
+		data.ubo.buffer = vk_uniform_buffer->buffer;
+		data.ubo.size = vk_uniform_buffer->size;
+		data.ubo.offset = 0;
+
+		info.binding = binding;
+		info.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		info.descriptorCount = 1;
+		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
+		info.pImmutableSamplers = nullptr;
+	}
+
+	void Driver::bindDynamicUniformBuffer(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::UniformBuffer *uniform_buffer,
+		uint32_t range
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		const UniformBuffer *vk_uniform_buffer = uniform_buffer_objects.get(uniform_buffer);
+
+		assert(!vk_bind_set->bindless && "Bindless bind set can't be modified");
+
+		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
+		BindSet::Data &data = vk_bind_set->binding_data[binding];
+
+		vk_bind_set->binding_used[binding] = (vk_uniform_buffer != nullptr);
+
+		if (vk_uniform_buffer == nullptr)
+			return;
+
+		assert(range != 0 && range <= vk_uniform_buffer->size && "Invalid dynamic uniform buffer range");
+
+		bool buffer_changed = (data.ubo.buffer != vk_uniform_buffer->buffer) || (data.ubo.size != range);
+		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+
+		vk_bind_set->binding_dirty[binding] = vk_bind_set->binding_dirty[binding] || type_changed || buffer_changed;
+
+		data.ubo.uniform_buffer = vk_uniform_buffer;
+		data.ubo.buffer = vk_uniform_buffer->buffer;
+		data.ubo.size = range;
+		data.ubo.offset = 0;
+
+		info.binding = binding;
+		info.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		info.descriptorCount = 1;
+		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
+		info.pImmutableSamplers = nullptr;
+	}
+
+	void Driver::bindTexture(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::Texture *texture,
+		const backend::Sampler *sampler
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		const Texture *vk_texture = texture_objects.get(texture);
+
+		uint32_t num_mipmaps = (vk_texture) ? vk_texture->num_mipmaps : 0;
+		uint32_t num_layers = (vk_texture) ? vk_texture->num_layers : 0;
+
+		bindTexture(bind_set, binding, texture, 0, num_mipmaps, 0, num_layers, sampler);
+	}
+
+	void Driver::bindTexture(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::Texture *texture,
+		uint32_t base_mip,
+		uint32_t num_mipmaps,
+		uint32_t base_layer,
+		uint32_t num_layers,
+		const backend::Sampler *sampler
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		const Texture *vk_texture = texture_objects.get(texture);
+		const Sampler *vk_sampler = sampler_objects.get(sampler);
+
+		assert(!vk_bind_set->bindless && "Bindless bind set can't be modified");
+
+		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
+		BindSet::Data &data = vk_bind_set->binding_data[binding];
+
+		VkImageView view = VK_NULL_HANDLE;
+		VkSampler texture_sampler = VK_NULL_HANDLE;
+
+		if (vk_texture)
+		{
+			view = vk_texture->image_view_cache->fetch(vk_texture, base_mip, num_mipmaps, base_layer, num_layers);
+			texture_sampler = (vk_sampler) ? vk_sampler->sampler : vk_texture->sampler;
+		}
+
+		bool texture_changed = (data.texture.view != view) || (data.texture.sampler != texture_sampler);
+		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+		vk_bind_set->binding_used[binding] = (vk_texture != nullptr);
+		vk_bind_set->binding_dirty[binding] = type_changed || texture_changed;
+
+		data.texture.view = view;
+		data.texture.sampler = texture_sampler;
+
+		info.binding = binding;
+		info.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		info.descriptorCount = 1;
+		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
+		info.pImmutableSamplers = nullptr;
+	}
+
+	void Driver::bindStorageBuffer(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::StorageBuffer *storage_buffer
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		const StorageBuffer *vk_storage_buffer = storage_buffer_objects.get(storage_buffer);
+
+		assert(!vk_bind_set->bindless && "Bindless bind set can't be modified");
+
+		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
+		BindSet::Data &data = vk_bind_set->binding_data[binding];
+
+		VkBuffer buffer = (vk_storage_buffer) ? vk_storage_buffer->buffer : VK_NULL_HANDLE;
+		uint32_t size = (vk_storage_buffer) ? vk_storage_buffer->size : 0;
+
+		bool buffer_changed = (data.ssbo.buffer != buffer) || (data.ssbo.size != size);
+		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+		vk_bind_set->binding_used[binding] = (vk_storage_buffer != nullptr);
+		vk_bind_set->binding_dirty[binding] = type_changed || buffer_changed;
+
+		if (vk_storage_buffer == nullptr)
+			return;
+
+		data.ssbo.buffer = buffer;
+		data.ssbo.size = size;
+
+		info.binding = binding;
+		info.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		info.descriptorCount = 1;
+		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
+		info.pImmutableSamplers = nullptr;
+	}
+
+	void Driver::bindStorageImage(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::Texture *texture,
+		uint32_t mip
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		const Texture *vk_texture = texture_objects.get(texture);
+
+		assert(!vk_bind_set->bindless && "Bindless bind set can't be modified");
+
+		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
+		BindSet::Data &data = vk_bind_set->binding_data[binding];
+
+		VkImageView view = VK_NULL_HANDLE;
+
+		if (vk_texture)
+		{
+			assert(mip < vk_texture->num_mipmaps && "Invalid mip level");
+			assert((vk_texture->usage & VK_IMAGE_USAGE_STORAGE_BIT) && "Texture must be created with TEXTURE_USAGE_STORAGE");
+			view = vk_texture->image_view_cache->fetch(vk_texture, mip, 1, 0, vk_texture->num_layers);
+		}
+
+		bool texture_changed = (data.texture.view != view) || (data.texture.sampler != VK_NULL_HANDLE);
+		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+		vk_bind_set->binding_used[binding] = (vk_texture != nullptr);
+		vk_bind_set->binding_dirty[binding] = type_changed || texture_changed;
+
+		data.texture.view = view;
+		data.texture.sampler = VK_NULL_HANDLE;
+
+		info.binding = binding;
+		info.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		info.descriptorCount = 1;
+		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
+		info.pImmutableSamplers = nullptr;
+	}
+
+	void Driver::bindInputAttachment(
+		backend::BindSet *bind_set,
+		uint32_t binding,
+		const backend::Texture *texture
+	)
+	{
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (bind_set == nullptr)
+			return;
+
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+		const Texture *vk_texture = texture_objects.get(texture);
+
+		assert(!vk_bind_set->bindless && "Bindless bind set can't be modified");
+
+		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
+		BindSet::Data &data = vk_bind_set->binding_data[binding];
+
+		VkImageView view = VK_NULL_HANDLE;
+		VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		if (vk_texture)
+		{
+			assert((vk_texture->usage & VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT) && "Texture must be created with TEXTURE_USAGE_INPUT_ATTACHMENT");
+			view = vk_texture->image_view_cache->fetch(vk_texture);
+
+			// must match the layout of the input attachment reference
+			if (Utils::getImageAspectFlags(vk_texture->format) & VK_IMAGE_ASPECT_DEPTH_BIT)
+				layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		}
+
+		bool texture_changed = (data.texture.view != view) || (data.texture.sampler != VK_NULL_HANDLE) || (data.texture.layout != layout);
+		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+
+		vk_bind_set->binding_used[binding] = (vk_texture != nullptr);
+		vk_bind_set->binding_dirty[binding] = type_changed || texture_changed;
+
+		data.texture.view = view;
+		data.texture.sampler = VK_NULL_HANDLE;
+		data.texture.layout = layout;
+
+		info.binding = binding;
+		info.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		info.descriptorCount = 1;
+		info.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT; // input attachments are only visible to fragment shaders
+		info.pImmutableSamplers = nullptr;
+	}
+
+	/*
+	 */
+	void Driver::clearPushConstants(backend::PipelineState *pipeline_state)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->push_constants_size = 0;
+		memset(vk_pipeline_state->push_constants, 0, PipelineState::MAX_PUSH_CONSTANT_SIZE);
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::setPushConstants(backend::PipelineState *pipeline_state, uint8_t size, const void *data)
+	{
+		assert(size <= PipelineState::MAX_PUSH_CONSTANT_SIZE);
+
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->push_constants_size = size;
+		memcpy(vk_pipeline_state->push_constants, data, size);
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::clearBindSets(backend::PipelineState *pipeline_state)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		for (uint32_t i = 0; i < PipelineState::MAX_BIND_SETS; ++i)
+			vk_pipeline_state->bind_sets[i] = nullptr;
+
+		vk_pipeline_state->num_bind_sets = 0;
+		memset(vk_pipeline_state->dynamic_offsets, 0, sizeof(vk_pipeline_state->dynamic_offsets));
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::setBindSet(backend::PipelineState *pipeline_state, uint8_t binding, backend::BindSet *bind_set)
+	{
+		assert(binding < PipelineState::MAX_BIND_SETS);
+
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		BindSet *vk_bind_set = bind_set_objects.get(bind_set);
+
+		vk_pipeline_state->bind_sets[binding] = vk_bind_set;
+		vk_pipeline_state->num_bind_sets = std::max<uint32_t>(vk_pipeline_state->num_bind_sets, binding + 1);
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::setDynamicOffset(backend::PipelineState *pipeline_state, uint8_t set, uint32_t binding, uint32_t offset)
+	{
+		assert(set < PipelineState::MAX_BIND_SETS);
+		assert(binding < BindSet::MAX_BINDINGS);
+
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		// offsets are applied at draw time, pipeline and descriptors stay untouched
+		vk_pipeline_state->dynamic_offsets[set][binding] = offset;
+	}
+
+	void Driver::clearShaders(backend::PipelineState *pipeline_state)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		for (uint32_t i = 0; i < PipelineState::MAX_SHADERS; ++i)
+			vk_pipeline_state->shaders[i] = VK_NULL_HANDLE;
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::setShader(backend::PipelineState *pipeline_state, ShaderType type, const backend::Shader *shader)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		const Shader *vk_shader = shader_objects.get(shader);
+
+		vk_pipeline_state->shaders[static_cast<int>(type)] = (vk_shader) ? vk_shader->module : VK_NULL_HANDLE;
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::clearVertexStreams(backend::PipelineState *pipeline_state)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		for (uint32_t i = 0; i < PipelineState::MAX_VERTEX_STREAMS; ++i)
+		{
+			vk_pipeline_state->vertex_streams[i] = nullptr;
+			vk_pipeline_state->vertex_stream_offsets[i] = 0;
+		}
+
+		vk_pipeline_state->num_vertex_streams = 0;
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	void Driver::setVertexStream(backend::PipelineState *pipeline_state, uint8_t binding, backend::VertexBuffer *vertex_buffer, uint32_t offset)
+	{
+		assert(binding < PipelineState::MAX_VERTEX_STREAMS);
+
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		VertexBuffer *vk_vertex_buffer = vertex_buffer_objects.get(vertex_buffer);
+
+		vk_pipeline_state->vertex_streams[binding] = vk_vertex_buffer;
+		vk_pipeline_state->vertex_stream_offsets[binding] = offset;
+		vk_pipeline_state->num_vertex_streams = std::max<uint32_t>(vk_pipeline_state->num_vertex_streams, binding + 1);
+
+		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
+		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+	}
+
+	/*
+	 */
+	void Driver::setViewport(backend::PipelineState *pipeline_state, int32_t x, int32_t y, uint32_t width, uint32_t height)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->viewport.x = static_cast<float>(x);
+		vk_pipeline_state->viewport.y = static_cast<float>(y);
+		vk_pipeline_state->viewport.width = static_cast<float>(width);
+		vk_pipeline_state->viewport.height = static_cast<float>(height);
+		vk_pipeline_state->viewport.minDepth = 0.0f;
+		vk_pipeline_state->viewport.maxDepth = 1.0f;
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setScissor(backend::PipelineState *pipeline_state, int32_t x, int32_t y, uint32_t width, uint32_t height)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->scissor.offset = { x, y };
+		vk_pipeline_state->scissor.extent = { width, height };
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setPrimitiveType(backend::PipelineState *pipeline_state, RenderPrimitiveType type)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->primitive_topology = Utils::getPrimitiveTopology(type);
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setCullMode(backend::PipelineState *pipeline_state, CullMode mode)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->cull_mode = Utils::getCullMode(mode);
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setDepthTest(backend::PipelineState *pipeline_state, bool enabled)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->depth_test = enabled;
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setDepthWrite(backend::PipelineState *pipeline_state, bool enabled)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->depth_write = enabled;
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setDepthCompareFunc(backend::PipelineState *pipeline_state, DepthCompareFunc func)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->depth_compare_func = Utils::getDepthCompareFunc(func);
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setBlending(backend::PipelineState *pipeline_state, bool enabled)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->blending = enabled;
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setBlendFactors(backend::PipelineState *pipeline_state, BlendFactor src_factor, BlendFactor dst_factor)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->blend_src_factor = Utils::getBlendFactor(src_factor);
+		vk_pipeline_state->blend_dst_factor = Utils::getBlendFactor(dst_factor);
+
+		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+	}
+
+	void Driver::setCompilePolicy(backend::PipelineState *pipeline_state, PipelineCompilePolicy policy)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+
+		vk_pipeline_state->compile_policy = policy;
+	}
+
+	void Driver::setFallbackPipelineState(backend::PipelineState *pipeline_state, backend::PipelineState *fallback)
+	{
+		if (pipeline_state == nullptr)
+			return;
+
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		PipelineState *vk_fallback = pipeline_state_objects.get(fallback);
+
+		// binds follow the chain until a compiled state is found, reject links that would make it loop
+		std::vector<const PipelineState *> visited;
+		for (const PipelineState *it = vk_fallback; it != nullptr; it = it->fallback)
+		{
+			if (it == vk_pipeline_state || std::find(visited.begin(), visited.end(), it) != visited.end())
+			{
+				std::cerr << "Driver::setFallbackPipelineState(): fallback chain can't loop back" << std::endl;
+				return;
+			}
+
+			visited.push_back(it);
+		}
+
+		vk_pipeline_state->fallback = vk_fallback;
+	}
+
+	/*
+	 */
+	bool Driver::resetCommandBuffer(backend::CommandBuffer *command_buffer)
+	{
+		if (command_buffer == nullptr)
+			return false;
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		if (vkResetCommandBuffer(vk_command_buffer->command_buffer, 0) != VK_SUCCESS)
+			return false;
+
+		helpers::invalidateBoundState(vk_command_buffer);
+		return true;
+	}
+
+	bool Driver::beginCommandBuffer(backend::CommandBuffer *command_buffer)
+	{
+		if (command_buffer == nullptr)
+			return false;
+
+		VkCommandBufferBeginInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		assert(vk_command_buffer->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && "Secondary command buffers must inherit a render pass");
+
+		if (vkBeginCommandBuffer(vk_command_buffer->command_buffer, &info) != VK_SUCCESS)
+			return false;
+
+		vk_command_buffer->render_pass = VK_NULL_HANDLE;
+		vk_command_buffer->current_render_pass = nullptr;
+		vk_command_buffer->current_frame_buffer = nullptr;
+		vk_command_buffer->subpass = 0;
+		vk_command_buffer->secondary_contents = false;
+
+		vk_command_buffer->pending_barriers.clear();
+		vk_command_buffer->pending_src_stages = 0;
+		vk_command_buffer->pending_dst_stages = 0;
+
+		helpers::invalidateBoundState(vk_command_buffer);
+		return true;
+	}
+
+	bool Driver::beginCommandBuffer(
+		backend::CommandBuffer *command_buffer,
+		const backend::RenderPass *render_pass,
+		const backend::FrameBuffer *frame_buffer
+	)
+	{
+		if (command_buffer == nullptr)
+			return false;
+
+		assert(render_pass);
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const RenderPass *vk_render_pass = render_pass_objects.get(render_pass);
+		const FrameBuffer *vk_frame_buffer = frame_buffer_objects.get(frame_buffer);
+
+		assert(vk_command_buffer->level == VK_COMMAND_BUFFER_LEVEL_SECONDARY && "Only secondary command buffers can inherit a render pass");
+
+		VkCommandBufferInheritanceInfo inheritance_info = {};
+		inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance_info.renderPass = vk_render_pass->render_pass;
+		inheritance_info.subpass = 0;
+		inheritance_info.framebuffer = (vk_frame_buffer) ? frame_buffer_cache->fetch(vk_render_pass, vk_frame_buffer) : VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		info.pInheritanceInfo = &inheritance_info;
+
+		if (vkBeginCommandBuffer(vk_command_buffer->command_buffer, &info) != VK_SUCCESS)
+			return false;
+
+		vk_command_buffer->render_pass = vk_render_pass->render_pass;
+		vk_command_buffer->current_render_pass = vk_render_pass;
+		vk_command_buffer->subpass = 0;
+		vk_command_buffer->max_samples = vk_render_pass->max_samples[0];
+		vk_command_buffer->num_color_attachments = vk_render_pass->num_color_attachments[0];
+		vk_command_buffer->secondary_contents = false;
+
+		vk_command_buffer->pending_barriers.clear();
+		vk_command_buffer->pending_src_stages = 0;
+		vk_command_buffer->pending_dst_stages = 0;
+
+		helpers::invalidateBoundState(vk_command_buffer);
+		return true;
+	}
+
+	bool Driver::endCommandBuffer(backend::CommandBuffer *command_buffer)
+	{
+		if (command_buffer == nullptr)
+			return false;
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		helpers::flushBarriers(vk_command_buffer);
+
+		if (vkEndCommandBuffer(vk_command_buffer->command_buffer) != VK_SUCCESS)
+			return false;
+
+		return true;
+	}
+
+	bool Driver::submit(backend::CommandBuffer *command_buffer)
+	{
+		if (command_buffer == nullptr)
+			return false;
+		
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+
+		VkSubmitInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.commandBufferCount = 1;
+		info.pCommandBuffers = &vk_command_buffer->command_buffer;
+
+		std::lock_guard<std::mutex> lock(device->getQueueMutex());
+
+		vkResetFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu);
+		if (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, vk_command_buffer->rendering_finished_cpu) != VK_SUCCESS)
+			return false;
+
+		transient_allocator->endFrame();
+		descriptor_allocator->endFrame();
+		submit_tracker->submit();
+		destroy_queue->retire();
+
+		return true;
+	}
+
+	bool Driver::submitSyncked(backend::CommandBuffer *command_buffer, const backend::SwapChain *wait_swap_chain)
+	{
+		if (command_buffer == nullptr)
+			return false;
+		
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+
+		VkSubmitInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.commandBufferCount = 1;
+		info.pCommandBuffers = &vk_command_buffer->command_buffer;
+		info.signalSemaphoreCount = 1;
+		info.pSignalSemaphores = &vk_command_buffer->rendering_finished_gpu;
+
+		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		const SwapChain *vk_wait_swap_chain = static_cast<const SwapChain *>(wait_swap_chain);
+
+		// offscreen acquire signals nothing
+		if (vk_wait_swap_chain != nullptr && !vk_wait_swap_chain->offscreen)
+		{
+			uint32_t current_frame = vk_wait_swap_chain->current_frame;
+
+			info.waitSemaphoreCount = 1;
+			info.pWaitSemaphores = &vk_wait_swap_chain->image_available_gpu[current_frame];
+			info.pWaitDstStageMask = &wait_stage;
+		}
+
+		std::lock_guard<std::mutex> lock(device->getQueueMutex());
+
+		vkResetFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu);
+		if (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, vk_command_buffer->rendering_finished_cpu) != VK_SUCCESS)
+			return false;
+
+		transient_allocator->endFrame();
+		descriptor_allocator->endFrame();
+		submit_tracker->submit();
+		destroy_queue->retire();
+
+		return true;
+	}
+
+	bool Driver::submitSyncked(backend::CommandBuffer *command_buffer, uint32_t num_wait_command_buffers, backend::CommandBuffer * const *wait_command_buffers)
+	{
+		if (command_buffer == nullptr)
+			return false;
+		
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+
+		VkSubmitInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.commandBufferCount = 1;
+		info.pCommandBuffers = &vk_command_buffer->command_buffer;
+		info.signalSemaphoreCount = 1;
+		info.pSignalSemaphores = &vk_command_buffer->rendering_finished_gpu;
+
+		std::vector<VkSemaphore> wait_semaphores;
+		std::vector<VkPipelineStageFlags> wait_stages;
+
+		if (num_wait_command_buffers != 0 && wait_command_buffers != nullptr)
+		{
+			wait_semaphores.resize(num_wait_command_buffers);
+			wait_stages.resize(num_wait_command_buffers);
+
+			for (uint32_t i = 0; i < num_wait_command_buffers; ++i)
+			{
+				const CommandBuffer *vk_wait_command_buffer = command_buffer_objects.get(wait_command_buffers[i]);
+				wait_semaphores[i] = vk_wait_command_buffer->rendering_finished_gpu;
+				wait_stages[i] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			}
+
+			info.waitSemaphoreCount = num_wait_command_buffers;
+			info.pWaitSemaphores = wait_semaphores.data();
+			info.pWaitDstStageMask = wait_stages.data();
+		}
+
+		std::lock_guard<std::mutex> lock(device->getQueueMutex());
+
+		vkResetFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu);
+		if (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, vk_command_buffer->rendering_finished_cpu) != VK_SUCCESS)
+			return false;
+
+		transient_allocator->endFrame();
+		descriptor_allocator->endFrame();
+		submit_tracker->submit();
+		destroy_queue->retire();
+
+		return true;
+	}
+
+	void Driver::beginRenderPass(backend::CommandBuffer *command_buffer, const backend::RenderPass *render_pass, const backend::FrameBuffer *frame_buffer, RenderPassContents contents)
+	{
+		assert(command_buffer);
+		assert(render_pass);
+		assert(frame_buffer);
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const RenderPass *vk_render_pass = render_pass_objects.get(render_pass);
+		const FrameBuffer *vk_frame_buffer = frame_buffer_objects.get(frame_buffer);
+
+		VkFramebuffer vk_framebuffer = frame_buffer_cache->fetch(vk_render_pass, vk_frame_buffer);
+		if (vk_framebuffer == VK_NULL_HANDLE)
+			return;
+
+		helpers::flushBarriers(vk_command_buffer);
+
+		VkViewport viewport = {};
+		viewport.width = static_cast<float>(vk_frame_buffer->sizes.width);
+		viewport.height = static_cast<float>(vk_frame_buffer->sizes.height);
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D render_area = {};
+		render_area.extent = vk_frame_buffer->sizes;
+		render_area.offset = {0, 0};
+
+		vk_command_buffer->render_pass = vk_render_pass->render_pass;
+		vk_command_buffer->current_render_pass = vk_render_pass;
+		vk_command_buffer->current_frame_buffer = vk_frame_buffer;
+		vk_command_buffer->subpass = 0;
+		vk_command_buffer->max_samples = vk_render_pass->max_samples[0];
+		vk_command_buffer->num_color_attachments = vk_render_pass->num_color_attachments[0];
+		vk_command_buffer->secondary_contents = (contents == RenderPassContents::SECONDARY_COMMAND_BUFFERS);
+
+		VkRenderPassBeginInfo render_pass_info = {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_info.renderPass = vk_render_pass->render_pass;
+		render_pass_info.framebuffer = vk_framebuffer;
+		render_pass_info.renderArea = render_area;
+		render_pass_info.clearValueCount = vk_frame_buffer->num_attachments;
+		render_pass_info.pClearValues = vk_render_pass->attachment_clear_values;
+
+		vkCmdBeginRenderPass(vk_command_buffer->command_buffer, &render_pass_info, Utils::getSubpassContents(contents));
+		helpers::invalidateBoundState(vk_command_buffer);
+	}
+
+	void Driver::beginRenderPass(backend::CommandBuffer *command_buffer, const backend::RenderPass *render_pass, const backend::SwapChain *swap_chain, RenderPassContents contents)
+	{
+		assert(command_buffer);
+		assert(render_pass);
+		assert(swap_chain);
+
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const RenderPass *vk_render_pass = render_pass_objects.get(render_pass);
+		const SwapChain *vk_swap_chain = static_cast<const SwapChain *>(swap_chain);
+		VkFramebuffer frame_buffer = vk_swap_chain->frame_buffers[vk_swap_chain->current_image];
+
+		helpers::flushBarriers(vk_command_buffer);
+
+		VkViewport viewport = {};
+		viewport.width = static_cast<float>(vk_swap_chain->sizes.width);
+		viewport.height = static_cast<float>(vk_swap_chain->sizes.height);
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D render_area = {};
+		render_area.extent = vk_swap_chain->sizes;
+		render_area.offset = {0, 0};
+
+		vk_command_buffer->render_pass = vk_render_pass->render_pass;
+		vk_command_buffer->current_render_pass = vk_render_pass;
+		vk_command_buffer->current_frame_buffer = nullptr;
+		vk_command_buffer->subpass = 0;
+		vk_command_buffer->max_samples = vk_render_pass->max_samples[0];
+		vk_command_buffer->num_color_attachments = vk_render_pass->num_color_attachments[0];
+		vk_command_buffer->secondary_contents = (contents == RenderPassContents::SECONDARY_COMMAND_BUFFERS);
+
+		VkRenderPassBeginInfo render_pass_info = {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_info.renderPass = vk_render_pass->render_pass;
+		render_pass_info.framebuffer = frame_buffer;
+		render_pass_info.renderArea = render_area;
+		render_pass_info.clearValueCount = vk_render_pass->num_attachments;
+		render_pass_info.pClearValues = vk_render_pass->attachment_clear_values;
+
+		vkCmdBeginRenderPass(vk_command_buffer->command_buffer, &render_pass_info, Utils::getSubpassContents(contents));
+		helpers::invalidateBoundState(vk_command_buffer);
+	}
 
-		if (bind_set == nullptr)
+	void Driver::nextSubpass(backend::CommandBuffer *command_buffer, RenderPassContents contents)
+	{
+		if (command_buffer == nullptr)
 			return;
 
-		BindSet *vk_bind_set = static_cast<BindSet *>(bind_set);
-		const Texture *vk_texture = static_cast<const Texture *>(texture);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const RenderPass *vk_render_pass = vk_command_buffer->current_render_pass;
 
-		VkDescriptorSetLayoutBinding &info = vk_bind_set->bindings[binding];
-		BindSet::Data &data = vk_bind_set->binding_data[binding];
+		assert(vk_render_pass && "Subpasses can only be advanced inside render passes");
+		assert(vk_command_buffer->subpass + 1 < vk_render_pass->num_subpasses && "Render pass has no more subpasses");
 
-		VkImageView view = VK_NULL_HANDLE;
-		VkSampler sampler = VK_NULL_HANDLE;
+		vk_command_buffer->subpass++;
+		vk_command_buffer->max_samples = vk_render_pass->max_samples[vk_command_buffer->subpass];
+		vk_command_buffer->num_color_attachments = vk_render_pass->num_color_attachments[vk_command_buffer->subpass];
+		vk_command_buffer->secondary_contents = (contents == RenderPassContents::SECONDARY_COMMAND_BUFFERS);
 
-		if (vk_texture)
-		{
-			view = vk_texture->image_view_cache->fetch(vk_texture, base_mip, num_mipmaps, base_layer, num_layers);
-			sampler = vk_texture->sampler;
-		}
+		vkCmdNextSubpass(vk_command_buffer->command_buffer, Utils::getSubpassContents(contents));
 
-		bool texture_changed = (data.texture.view != view) || (data.texture.sampler != sampler);
-		bool type_changed = (info.descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		// pipelines are bound per subpass
+		vk_command_buffer->bound_pipeline = VK_NULL_HANDLE;
+	}
 
-		vk_bind_set->binding_used[binding] = (vk_texture != nullptr);
-		vk_bind_set->binding_dirty[binding] = type_changed || texture_changed;
+	void Driver::endRenderPass(backend::CommandBuffer *command_buffer)
+	{
+		if (command_buffer == nullptr)
+			return;
 
-		data.texture.view = view;
-		data.texture.sampler = sampler;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		vkCmdEndRenderPass(vk_command_buffer->command_buffer);
 
-		info.binding = binding;
-		info.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		info.descriptorCount = 1;
-		info.stageFlags = VK_SHADER_STAGE_ALL; // TODO: allow for different shader stages
-		info.pImmutableSamplers = nullptr;
+		if (vk_command_buffer->current_frame_buffer)
+			helpers::updateAttachmentStates(vk_command_buffer->current_frame_buffer);
+
+		vk_command_buffer->render_pass = VK_NULL_HANDLE;
+		vk_command_buffer->current_render_pass = nullptr;
+		vk_command_buffer->subpass = 0;
+		vk_command_buffer->current_frame_buffer = nullptr;
+		vk_command_buffer->secondary_contents = false;
+		helpers::invalidateBoundState(vk_command_buffer);
 	}
 
-	/*
-	 */
-	void Driver::clearPushConstants(backend::PipelineState *pipeline_state)
+	void Driver::executeCommands(
+		backend::CommandBuffer *command_buffer,
+		uint32_t num_command_buffers,
+		backend::CommandBuffer * const *command_buffers
+	)
 	{
-		if (pipeline_state == nullptr)
+		if (command_buffer == nullptr || num_command_buffers == 0)
 			return;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		assert(vk_command_buffer->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && "Secondary command buffers can only be executed by primary ones");
+		assert((vk_command_buffer->render_pass == VK_NULL_HANDLE || vk_command_buffer->secondary_contents) && "Render pass must be started with RenderPassContents::SECONDARY_COMMAND_BUFFERS");
 
-		vk_pipeline_state->push_constants_size = 0;
-		memset(vk_pipeline_state->push_constants, 0, PipelineState::MAX_PUSH_CONSTANT_SIZE);
+		std::vector<VkCommandBuffer> vk_command_buffers(num_command_buffers);
+		for (uint32_t i = 0; i < num_command_buffers; ++i)
+		{
+			const CommandBuffer *secondary = command_buffer_objects.get(command_buffers[i]);
+			assert(secondary && secondary->level == VK_COMMAND_BUFFER_LEVEL_SECONDARY && "Only secondary command buffers can be executed");
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+			vk_command_buffers[i] = secondary->command_buffer;
+		}
+
+		vkCmdExecuteCommands(vk_command_buffer->command_buffer, num_command_buffers, vk_command_buffers.data());
+		helpers::invalidateBoundState(vk_command_buffer);
 	}
 
-	void Driver::setPushConstants(backend::PipelineState *pipeline_state, uint8_t size, const void *data)
+	void Driver::drawIndexedPrimitiveInstanced(
+		backend::CommandBuffer *command_buffer,
+		backend::PipelineState *pipeline_state,
+		const backend::IndexBuffer *index_buffer,
+		uint32_t num_indices,
+		uint32_t base_index,
+		int32_t base_vertex,
+		uint32_t num_instances,
+		uint32_t base_instance
+	)
 	{
-		assert(size <= PipelineState::MAX_PUSH_CONSTANT_SIZE);
+		ZoneScoped;
 
-		if (pipeline_state == nullptr)
+		if (command_buffer == nullptr)
 			return;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		const IndexBuffer *vk_index_buffer = index_buffer_objects.get(index_buffer);
 
-		vk_pipeline_state->push_constants_size = size;
-		memcpy(vk_pipeline_state->push_constants, data, size);
+		if (!bindGraphicsState(vk_command_buffer, vk_pipeline_state, vk_index_buffer))
+			return;
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+		vkCmdDrawIndexed(vk_command_buffer->command_buffer, num_indices, num_instances, base_index, base_vertex, base_instance);
 	}
 
-	void Driver::clearBindSets(backend::PipelineState *pipeline_state)
+	void Driver::drawIndexedIndirect(
+		backend::CommandBuffer *command_buffer,
+		backend::PipelineState *pipeline_state,
+		const backend::IndexBuffer *index_buffer,
+		const backend::StorageBuffer *arguments,
+		uint32_t offset,
+		uint32_t num_draws,
+		uint32_t stride
+	)
 	{
-		if (pipeline_state == nullptr)
+		ZoneScoped;
+
+		if (command_buffer == nullptr || num_draws == 0)
 			return;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		assert(arguments != nullptr && "Invalid indirect arguments");
+		assert(stride >= sizeof(VkDrawIndexedIndirectCommand) && (stride % 4) == 0 && "Invalid indirect arguments stride");
 
-		for (uint32_t i = 0; i < PipelineState::MAX_BIND_SETS; ++i)
-			vk_pipeline_state->bind_sets[i] = nullptr;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		const IndexBuffer *vk_index_buffer = index_buffer_objects.get(index_buffer);
+		const StorageBuffer *vk_arguments = storage_buffer_objects.get(arguments);
 
-		vk_pipeline_state->num_bind_sets = 0;
+		assert(offset + stride * (num_draws - 1) + sizeof(VkDrawIndexedIndirectCommand) <= vk_arguments->size && "Indirect arguments are out of buffer bounds");
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+		if (!bindGraphicsState(vk_command_buffer, vk_pipeline_state, vk_index_buffer))
+			return;
+
+		if (device->hasMultiDrawIndirect())
+		{
+			vkCmdDrawIndexedIndirect(vk_command_buffer->command_buffer, vk_arguments->buffer, offset, num_draws, stride);
+			return;
+		}
+
+		for (uint32_t i = 0; i < num_draws; ++i)
+			vkCmdDrawIndexedIndirect(vk_command_buffer->command_buffer, vk_arguments->buffer, offset + i * stride, 1, stride);
 	}
 
-	void Driver::setBindSet(backend::PipelineState *pipeline_state, uint8_t binding, backend::BindSet *bind_set)
+	void Driver::drawIndexedIndirectCount(
+		backend::CommandBuffer *command_buffer,
+		backend::PipelineState *pipeline_state,
+		const backend::IndexBuffer *index_buffer,
+		const backend::StorageBuffer *arguments,
+		uint32_t offset,
+		const backend::StorageBuffer *count_buffer,
+		uint32_t count_offset,
+		uint32_t max_draws,
+		uint32_t stride
+	)
 	{
-		assert(binding < PipelineState::MAX_BIND_SETS);
+		ZoneScoped;
 
-		if (pipeline_state == nullptr)
+		if (!device->hasDrawIndirectCount())
+		{
+			drawIndexedIndirect(command_buffer, pipeline_state, index_buffer, arguments, offset, max_draws, stride);
 			return;
+		}
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
-		BindSet *vk_bind_set = static_cast<BindSet *>(bind_set);
+		if (command_buffer == nullptr || max_draws == 0)
+			return;
 
-		vk_pipeline_state->bind_sets[binding] = vk_bind_set;
-		vk_pipeline_state->num_bind_sets = std::max<uint32_t>(vk_pipeline_state->num_bind_sets, binding + 1);
+		assert(arguments != nullptr && "Invalid indirect arguments");
+		assert(count_buffer != nullptr && "Invalid indirect draw count");
+		assert(stride >= sizeof(VkDrawIndexedIndirectCommand) && (stride % 4) == 0 && "Invalid indirect arguments stride");
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		const IndexBuffer *vk_index_buffer = index_buffer_objects.get(index_buffer);
+		const StorageBuffer *vk_arguments = storage_buffer_objects.get(arguments);
+		const StorageBuffer *vk_count_buffer = storage_buffer_objects.get(count_buffer);
+
+		assert(offset + stride * (max_draws - 1) + sizeof(VkDrawIndexedIndirectCommand) <= vk_arguments->size && "Indirect arguments are out of buffer bounds");
+		assert(count_offset + sizeof(uint32_t) <= vk_count_buffer->size && "Indirect draw count is out of buffer bounds");
+
+		if (!bindGraphicsState(vk_command_buffer, vk_pipeline_state, vk_index_buffer))
+			return;
+
+		vkCmdDrawIndexedIndirectCountKHR(
+			vk_command_buffer->command_buffer,
+			vk_arguments->buffer, offset,
+			vk_count_buffer->buffer, count_offset,
+			max_draws, stride
+		);
 	}
 
-	void Driver::clearShaders(backend::PipelineState *pipeline_state)
+	/*
+	 */
+	bool Driver::bindGraphicsState(CommandBuffer *vk_command_buffer, PipelineState *vk_pipeline_state, const IndexBuffer *vk_index_buffer)
 	{
-		if (pipeline_state == nullptr)
-			return;
+		assert(vk_command_buffer->render_pass != VK_NULL_HANDLE);
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		vk_pipeline_state->render_pass = vk_command_buffer->render_pass;
+		vk_pipeline_state->subpass = vk_command_buffer->subpass;
+		vk_pipeline_state->num_color_attachments = vk_command_buffer->num_color_attachments;
+		vk_pipeline_state->max_samples = vk_command_buffer->max_samples;
 
-		for (uint32_t i = 0; i < PipelineState::MAX_SHADERS; ++i)
-			vk_pipeline_state->shaders[i] = VK_NULL_HANDLE;
+		assert(!vk_command_buffer->secondary_contents && "Render pass expects secondary command buffers, draws must be recorded there");
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
-	}
+		{
+			std::lock_guard<std::mutex> lock(flush_mutex);
+			flushPipelineState(vk_pipeline_state);
 
-	void Driver::setShader(backend::PipelineState *pipeline_state, ShaderType type, const backend::Shader *shader)
-	{
-		if (pipeline_state == nullptr)
-			return;
+			for (uint8_t i = 0; i < vk_pipeline_state->num_bind_sets; ++i)
+				helpers::markBindSetUsed(vk_pipeline_state->bind_sets[i], submit_tracker->getCurrentSerial());
+		}
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
-		const Shader *vk_shader = static_cast<const Shader *>(shader);
+		// pipeline is not compiled yet, skip the draw or use the fallback state instead
+		if (vk_pipeline_state->pipeline == VK_NULL_HANDLE)
+		{
+			PipelineState *fallback = vk_pipeline_state->fallback;
+			if (vk_pipeline_state->compile_policy == PipelineCompilePolicy::FALLBACK && fallback)
+				return bindGraphicsState(vk_command_buffer, fallback, vk_index_buffer);
 
-		vk_pipeline_state->shaders[static_cast<int>(type)] = (vk_shader) ? vk_shader->module : VK_NULL_HANDLE;
+			return false;
+		}
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
-	}
+		ZoneNamedN(actual_draw_call, "Actual draw call", true);
 
-	void Driver::clearVertexStreams(backend::PipelineState *pipeline_state)
-	{
-		if (pipeline_state == nullptr)
-			return;
+		VkPipeline pipeline = vk_pipeline_state->pipeline;
+		VkPipelineLayout pipeline_layout = vk_pipeline_state->pipeline_layout;
+		const VkViewport &viewport = vk_pipeline_state->viewport;
+		const VkRect2D &scissor = vk_pipeline_state->scissor;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		if (!vk_command_buffer->viewport_bound || memcmp(&vk_command_buffer->bound_viewport, &viewport, sizeof(VkViewport)) != 0)
+		{
+			vkCmdSetViewport(vk_command_buffer->command_buffer, 0, 1, &viewport);
+			vk_command_buffer->bound_viewport = viewport;
+			vk_command_buffer->viewport_bound = true;
+		}
 
-		for (uint32_t i = 0; i < PipelineState::MAX_VERTEX_STREAMS; ++i)
-			vk_pipeline_state->vertex_streams[i] = nullptr;
+		if (!vk_command_buffer->scissor_bound || memcmp(&vk_command_buffer->bound_scissor, &scissor, sizeof(VkRect2D)) != 0)
+		{
+			vkCmdSetScissor(vk_command_buffer->command_buffer, 0, 1, &scissor);
+			vk_command_buffer->bound_scissor = scissor;
+			vk_command_buffer->scissor_bound = true;
+		}
 
-		vk_pipeline_state->num_vertex_streams = 0;
+		if (vk_command_buffer->bound_pipeline != pipeline)
+		{
+			vkCmdBindPipeline(vk_command_buffer->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			vk_command_buffer->bound_pipeline = pipeline;
+		}
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
-	}
+		// different layouts may disturb push constants and descriptor sets, so rebind them all
+		if (vk_command_buffer->bound_pipeline_layout != pipeline_layout)
+		{
+			vk_command_buffer->bound_pipeline_layout = pipeline_layout;
+			vk_command_buffer->bound_push_constants_size = 0;
+			vk_command_buffer->num_bound_sets = 0;
+		}
 
-	void Driver::setVertexStream(backend::PipelineState *pipeline_state, uint8_t binding, backend::VertexBuffer *vertex_buffer)
-	{
-		assert(binding < PipelineState::MAX_VERTEX_STREAMS);
+		uint8_t push_constants_size = vk_pipeline_state->push_constants_size;
+		if (push_constants_size > 0)
+		{
+			bool push_constants_changed = (vk_command_buffer->bound_push_constants_size != push_constants_size);
+			if (!push_constants_changed)
+				push_constants_changed = (memcmp(vk_command_buffer->bound_push_constants, vk_pipeline_state->push_constants, push_constants_size) != 0);
 
-		if (pipeline_state == nullptr)
-			return;
+			if (push_constants_changed)
+			{
+				vkCmdPushConstants(vk_command_buffer->command_buffer, pipeline_layout, VK_SHADER_STAGE_ALL, 0, push_constants_size, vk_pipeline_state->push_constants);
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
-		VertexBuffer *vk_vertex_buffer = static_cast<VertexBuffer *>(vertex_buffer);
+				memcpy(vk_command_buffer->bound_push_constants, vk_pipeline_state->push_constants, push_constants_size);
+				vk_command_buffer->bound_push_constants_size = push_constants_size;
+			}
+		}
 
-		vk_pipeline_state->vertex_streams[binding] = vk_vertex_buffer;
-		vk_pipeline_state->num_vertex_streams = std::max<uint32_t>(vk_pipeline_state->num_vertex_streams, binding + 1);
+		uint8_t num_bind_sets = vk_pipeline_state->num_bind_sets;
+		if (num_bind_sets > 0)
+		{
+			VkDescriptorSet sets[PipelineState::MAX_BIND_SETS];
+			uint32_t dynamic_offsets[PipelineState::MAX_BIND_SETS][BindSet::MAX_DYNAMIC_BINDINGS];
+			uint8_t num_dynamic_offsets[PipelineState::MAX_BIND_SETS];
+			uint8_t first_set = num_bind_sets;
 
-		// TODO: better invalidation (there might be case where we only need to invalidate pipeline but keep pipeline layout)
-		vk_pipeline_state->pipeline_layout = VK_NULL_HANDLE;
-	}
+			for (uint8_t i = 0; i < num_bind_sets; ++i)
+			{
+				BindSet *bind_set = vk_pipeline_state->bind_sets[i];
 
-	/*
-	 */
-	void Driver::setViewport(backend::PipelineState *pipeline_state, int32_t x, int32_t y, uint32_t width, uint32_t height)
-	{
-		if (pipeline_state == nullptr)
-			return;
+				sets[i] = bind_set->set;
+				num_dynamic_offsets[i] = helpers::getDynamicOffsets(bind_set, vk_pipeline_state->dynamic_offsets[i], dynamic_offsets[i]);
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+				if (first_set != num_bind_sets)
+					continue;
 
-		vk_pipeline_state->viewport.x = static_cast<float>(x);
-		vk_pipeline_state->viewport.y = static_cast<float>(y);
-		vk_pipeline_state->viewport.width = static_cast<float>(width);
-		vk_pipeline_state->viewport.height = static_cast<float>(height);
-		vk_pipeline_state->viewport.minDepth = 0.0f;
-		vk_pipeline_state->viewport.maxDepth = 1.0f;
+				if (i >= vk_command_buffer->num_bound_sets || vk_command_buffer->bound_sets[i] != sets[i])
+					first_set = i;
+				else if (vk_command_buffer->num_bound_dynamic_offsets[i] != num_dynamic_offsets[i])
+					first_set = i;
+				else if (memcmp(vk_command_buffer->bound_dynamic_offsets[i], dynamic_offsets[i], sizeof(uint32_t) * num_dynamic_offsets[i]) != 0)
+					first_set = i;
+			}
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
-	}
+			if (first_set < num_bind_sets)
+			{
+				uint32_t offsets[PipelineState::MAX_BIND_SETS * BindSet::MAX_DYNAMIC_BINDINGS];
+				uint32_t num_offsets = 0;
 
-	void Driver::setScissor(backend::PipelineState *pipeline_state, int32_t x, int32_t y, uint32_t width, uint32_t height)
-	{
-		if (pipeline_state == nullptr)
-			return;
+				for (uint8_t i = first_set; i < num_bind_sets; ++i)
+				{
+					memcpy(offsets + num_offsets, dynamic_offsets[i], sizeof(uint32_t) * num_dynamic_offsets[i]);
+					num_offsets += num_dynamic_offsets[i];
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+					memcpy(vk_command_buffer->bound_dynamic_offsets[i], dynamic_offsets[i], sizeof(uint32_t) * num_dynamic_offsets[i]);
+					vk_command_buffer->num_bound_dynamic_offsets[i] = num_dynamic_offsets[i];
+				}
 
-		vk_pipeline_state->scissor.offset = { x, y };
-		vk_pipeline_state->scissor.extent = { width, height };
+				uint32_t num_sets = num_bind_sets - first_set;
+				vkCmdBindDescriptorSets(vk_command_buffer->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, first_set, num_sets, sets + first_set, num_offsets, offsets);
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
-	}
+				memcpy(vk_command_buffer->bound_sets + first_set, sets + first_set, sizeof(VkDescriptorSet) * num_sets);
+				vk_command_buffer->num_bound_sets = std::max(vk_command_buffer->num_bound_sets, num_bind_sets);
+			}
+		}
 
-	void Driver::setPrimitiveType(backend::PipelineState *pipeline_state, RenderPrimitiveType type)
-	{
-		if (pipeline_state == nullptr)
-			return;
+		uint8_t num_vertex_streams = vk_pipeline_state->num_vertex_streams;
+		if (num_vertex_streams > 0)
+		{
+			VkBuffer vertex_buffers[PipelineState::MAX_VERTEX_STREAMS];
+			VkDeviceSize offsets[PipelineState::MAX_VERTEX_STREAMS];
+			uint8_t first_stream = num_vertex_streams;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+			for (uint8_t i = 0; i < num_vertex_streams; ++i)
+			{
+				vertex_buffers[i] = vk_pipeline_state->vertex_streams[i]->buffer;
+				offsets[i] = vk_pipeline_state->vertex_streams[i]->offset + vk_pipeline_state->vertex_stream_offsets[i];
 
-		vk_pipeline_state->primitive_topology = Utils::getPrimitiveTopology(type);
+				if (first_stream != num_vertex_streams)
+					continue;
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
-	}
+				if (i >= vk_command_buffer->num_bound_vertex_buffers || vk_command_buffer->bound_vertex_buffers[i] != vertex_buffers[i] || vk_command_buffer->bound_vertex_offsets[i] != offsets[i])
+					first_stream = i;
+			}
 
-	void Driver::setCullMode(backend::PipelineState *pipeline_state, CullMode mode)
-	{
-		if (pipeline_state == nullptr)
-			return;
+			if (first_stream < num_vertex_streams)
+			{
+				uint32_t num_streams = num_vertex_streams - first_stream;
+				vkCmdBindVertexBuffers(vk_command_buffer->command_buffer, first_stream, num_streams, vertex_buffers + first_stream, offsets + first_stream);
+
+				memcpy(vk_command_buffer->bound_vertex_buffers + first_stream, vertex_buffers + first_stream, sizeof(VkBuffer) * num_streams);
+				memcpy(vk_command_buffer->bound_vertex_offsets + first_stream, offsets + first_stream, sizeof(VkDeviceSize) * num_streams);
+				vk_command_buffer->num_bound_vertex_buffers = std::max(vk_command_buffer->num_bound_vertex_buffers, num_vertex_streams);
+			}
+		}
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		if (vk_index_buffer && (vk_command_buffer->bound_index_buffer != vk_index_buffer->buffer || vk_command_buffer->bound_index_offset != vk_index_buffer->offset || vk_command_buffer->bound_index_type != vk_index_buffer->index_type))
+		{
+			vkCmdBindIndexBuffer(vk_command_buffer->command_buffer, vk_index_buffer->buffer, vk_index_buffer->offset, vk_index_buffer->index_type);
 
-		vk_pipeline_state->cull_mode = Utils::getCullMode(mode);
+			vk_command_buffer->bound_index_buffer = vk_index_buffer->buffer;
+			vk_command_buffer->bound_index_offset = vk_index_buffer->offset;
+			vk_command_buffer->bound_index_type = vk_index_buffer->index_type;
+		}
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+		return true;
 	}
 
-	void Driver::setDepthTest(backend::PipelineState *pipeline_state, bool enabled)
+	bool Driver::bindComputeState(CommandBuffer *command_buffer, PipelineState *pipeline_state)
 	{
-		if (pipeline_state == nullptr)
-			return;
+		assert(command_buffer->render_pass == VK_NULL_HANDLE && "Dispatches are not allowed inside render passes");
+		assert(pipeline_state->shaders[static_cast<int>(ShaderType::COMPUTE)] != VK_NULL_HANDLE && "Compute shader is not set");
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		{
+			std::lock_guard<std::mutex> lock(flush_mutex);
+			flushPipelineState(pipeline_state);
 
-		vk_pipeline_state->depth_test = enabled;
+			for (uint8_t i = 0; i < pipeline_state->num_bind_sets; ++i)
+				helpers::markBindSetUsed(pipeline_state->bind_sets[i], submit_tracker->getCurrentSerial());
+		}
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
-	}
+		if (pipeline_state->pipeline == VK_NULL_HANDLE)
+			return false;
 
-	void Driver::setDepthWrite(backend::PipelineState *pipeline_state, bool enabled)
-	{
-		if (pipeline_state == nullptr)
-			return;
+		VkCommandBuffer vk_command_buffer = command_buffer->command_buffer;
+		VkPipelineLayout pipeline_layout = pipeline_state->pipeline_layout;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_state->pipeline);
 
-		vk_pipeline_state->depth_write = enabled;
+		uint8_t push_constants_size = pipeline_state->push_constants_size;
+		if (push_constants_size > 0)
+			vkCmdPushConstants(vk_command_buffer, pipeline_layout, VK_SHADER_STAGE_ALL, 0, push_constants_size, pipeline_state->push_constants);
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
-	}
+		uint8_t num_bind_sets = pipeline_state->num_bind_sets;
+		if (num_bind_sets > 0)
+		{
+			VkDescriptorSet sets[PipelineState::MAX_BIND_SETS];
+			uint32_t offsets[PipelineState::MAX_BIND_SETS * BindSet::MAX_DYNAMIC_BINDINGS];
+			uint32_t num_offsets = 0;
 
-	void Driver::setDepthCompareFunc(backend::PipelineState *pipeline_state, DepthCompareFunc func)
-	{
-		if (pipeline_state == nullptr)
-			return;
+			for (uint8_t i = 0; i < num_bind_sets; ++i)
+			{
+				BindSet *bind_set = pipeline_state->bind_sets[i];
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+				sets[i] = bind_set->set;
+				num_offsets += helpers::getDynamicOffsets(bind_set, pipeline_state->dynamic_offsets[i], offsets + num_offsets);
+			}
 
-		vk_pipeline_state->depth_compare_func = Utils::getDepthCompareFunc(func);
+			vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, num_bind_sets, sets, num_offsets, offsets);
+		}
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+		// push constants are shared between bind points, don't trust the cached graphics state anymore
+		helpers::invalidateBoundState(command_buffer);
+		return true;
 	}
 
-	void Driver::setBlending(backend::PipelineState *pipeline_state, bool enabled)
+	void Driver::dispatch(
+		backend::CommandBuffer *command_buffer,
+		backend::PipelineState *pipeline_state,
+		uint32_t num_groups_x,
+		uint32_t num_groups_y,
+		uint32_t num_groups_z
+	)
 	{
-		if (pipeline_state == nullptr)
+		ZoneScoped;
+
+		if (command_buffer == nullptr || pipeline_state == nullptr)
 			return;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
 
-		vk_pipeline_state->blending = enabled;
+		helpers::flushBarriers(vk_command_buffer);
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
+		if (!bindComputeState(vk_command_buffer, vk_pipeline_state))
+			return;
+
+		vkCmdDispatch(vk_command_buffer->command_buffer, num_groups_x, num_groups_y, num_groups_z);
 	}
 
-	void Driver::setBlendFactors(backend::PipelineState *pipeline_state, BlendFactor src_factor, BlendFactor dst_factor)
+	void Driver::dispatchIndirect(
+		backend::CommandBuffer *command_buffer,
+		backend::PipelineState *pipeline_state,
+		const backend::StorageBuffer *arguments,
+		uint32_t offset
+	)
 	{
-		if (pipeline_state == nullptr)
+		ZoneScoped;
+
+		if (command_buffer == nullptr || pipeline_state == nullptr)
 			return;
 
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
+		assert(arguments != nullptr && "Invalid indirect arguments");
 
-		vk_pipeline_state->blend_src_factor = Utils::getBlendFactor(src_factor);
-		vk_pipeline_state->blend_dst_factor = Utils::getBlendFactor(dst_factor);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		PipelineState *vk_pipeline_state = pipeline_state_objects.get(pipeline_state);
+		const StorageBuffer *vk_arguments = storage_buffer_objects.get(arguments);
 
-		vk_pipeline_state->pipeline = VK_NULL_HANDLE;
-	}
+		assert(offset + sizeof(VkDispatchIndirectCommand) <= vk_arguments->size && "Indirect arguments are out of buffer bounds");
 
-	/*
-	 */
-	bool Driver::resetCommandBuffer(backend::CommandBuffer *command_buffer)
-	{
-		if (command_buffer == nullptr)
-			return false;
+		helpers::flushBarriers(vk_command_buffer);
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		if (vkResetCommandBuffer(vk_command_buffer->command_buffer, 0) != VK_SUCCESS)
-			return false;
+		if (!bindComputeState(vk_command_buffer, vk_pipeline_state))
+			return;
 
-		return true;
+		vkCmdDispatchIndirect(vk_command_buffer->command_buffer, vk_arguments->buffer, offset);
 	}
 
-	bool Driver::beginCommandBuffer(backend::CommandBuffer *command_buffer)
+	void Driver::memoryBarrier(
+		backend::CommandBuffer *command_buffer,
+		BarrierType type
+	)
 	{
 		if (command_buffer == nullptr)
-			return false;
-
-		VkCommandBufferBeginInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+			return;
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		if (vkBeginCommandBuffer(vk_command_buffer->command_buffer, &info) != VK_SUCCESS)
-			return false;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		assert(vk_command_buffer->render_pass == VK_NULL_HANDLE && "Barriers are not allowed inside render passes");
 
-		return true;
-	}
+		VkPipelineStageFlags src_stages = 0;
+		VkPipelineStageFlags dst_stages = 0;
 
-	bool Driver::endCommandBuffer(backend::CommandBuffer *command_buffer)
-	{
-		if (command_buffer == nullptr)
-			return false;
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		if (vkEndCommandBuffer(vk_command_buffer->command_buffer) != VK_SUCCESS)
-			return false;
+		helpers::getBarrierMasks(type, src_stages, dst_stages, barrier.srcAccessMask, barrier.dstAccessMask);
+		helpers::flushBarriers(vk_command_buffer);
 
-		return true;
+		vkCmdPipelineBarrier(vk_command_buffer->command_buffer, src_stages, dst_stages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 	}
 
-	bool Driver::submit(backend::CommandBuffer *command_buffer)
+	void Driver::textureBarrier(
+		backend::CommandBuffer *command_buffer,
+		const backend::Texture *texture,
+		BarrierType type
+	)
 	{
-		if (command_buffer == nullptr)
-			return false;
-		
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-
-		VkSubmitInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		info.commandBufferCount = 1;
-		info.pCommandBuffers = &vk_command_buffer->command_buffer;
-
-		vkResetFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu);
-		if (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, vk_command_buffer->rendering_finished_cpu) != VK_SUCCESS)
-			return false;
+		if (command_buffer == nullptr || texture == nullptr)
+			return;
 
-		return true;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const Texture *vk_texture = texture_objects.get(texture);
+
+		assert(vk_command_buffer->render_pass == VK_NULL_HANDLE && "Barriers are not allowed inside render passes");
+
+		// textures rest in shader read layout, storage access happens in general layout
+		VkImageLayout old_layout = VK_IMAGE_LAYOUT_GENERAL;
+		VkImageLayout new_layout = VK_IMAGE_LAYOUT_GENERAL;
+
+		if (type == BarrierType::COMPUTE_TO_GRAPHICS)
+			new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		else if (type == BarrierType::GRAPHICS_TO_COMPUTE)
+			old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkPipelineStageFlags src_stages = 0;
+		VkPipelineStageFlags dst_stages = 0;
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = old_layout;
+		barrier.newLayout = new_layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = vk_texture->image;
+		barrier.subresourceRange.aspectMask = Utils::getImageAspectFlags(vk_texture->format);
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = vk_texture->num_mipmaps;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = vk_texture->num_layers;
+
+		helpers::getBarrierMasks(type, src_stages, dst_stages, barrier.srcAccessMask, barrier.dstAccessMask);
+		helpers::flushBarriers(vk_command_buffer);
+
+		vkCmdPipelineBarrier(vk_command_buffer->command_buffer, src_stages, dst_stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		helpers::setTextureState(
+			vk_texture,
+			0, vk_texture->num_mipmaps,
+			0, vk_texture->num_layers,
+			new_layout,
+			barrier.dstAccessMask,
+			dst_stages
+		);
 	}
 
-	bool Driver::submitSyncked(backend::CommandBuffer *command_buffer, const backend::SwapChain *wait_swap_chain)
+	void Driver::transitionTexture(
+		backend::CommandBuffer *command_buffer,
+		const backend::Texture *texture,
+		TextureState state,
+		uint32_t base_mip,
+		uint32_t num_mips,
+		uint32_t base_layer,
+		uint32_t num_layers
+	)
 	{
-		if (command_buffer == nullptr)
-			return false;
-		
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
+		if (command_buffer == nullptr || texture == nullptr)
+			return;
 
-		VkSubmitInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		info.commandBufferCount = 1;
-		info.pCommandBuffers = &vk_command_buffer->command_buffer;
-		info.signalSemaphoreCount = 1;
-		info.pSignalSemaphores = &vk_command_buffer->rendering_finished_gpu;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		const Texture *vk_texture = texture_objects.get(texture);
 
-		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		assert(vk_command_buffer->current_render_pass == nullptr && "Transitions are not allowed inside render passes");
 
-		if (wait_swap_chain != nullptr)
-		{
-			const SwapChain *vk_wait_swap_chain = static_cast<const SwapChain *>(wait_swap_chain);
-			uint32_t current_frame = vk_wait_swap_chain->current_frame;
+		if (num_mips == 0)
+			num_mips = vk_texture->num_mipmaps - base_mip;
 
-			info.waitSemaphoreCount = 1;
-			info.pWaitSemaphores = &vk_wait_swap_chain->image_available_gpu[current_frame];
-			info.pWaitDstStageMask = &wait_stage;
-		}
+		if (num_layers == 0)
+			num_layers = vk_texture->num_layers - base_layer;
 
-		vkResetFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu);
-		if (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, vk_command_buffer->rendering_finished_cpu) != VK_SUCCESS)
-			return false;
+		assert(base_mip + num_mips <= vk_texture->num_mipmaps && "Invalid mip range");
+		assert(base_layer + num_layers <= vk_texture->num_layers && "Invalid layer range");
 
-		return true;
-	}
+		VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkAccessFlags new_access = 0;
+		VkPipelineStageFlags new_stages = 0;
 
-	bool Driver::submitSyncked(backend::CommandBuffer *command_buffer, uint32_t num_wait_command_buffers, backend::CommandBuffer * const *wait_command_buffers)
-	{
-		if (command_buffer == nullptr)
-			return false;
-		
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
+		helpers::getTextureStateMasks(state, new_layout, new_access, new_stages);
 
-		VkSubmitInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		info.commandBufferCount = 1;
-		info.pCommandBuffers = &vk_command_buffer->command_buffer;
-		info.signalSemaphoreCount = 1;
-		info.pSignalSemaphores = &vk_command_buffer->rendering_finished_gpu;
+		// barriers of a single vkCmdPipelineBarrier are unordered, the same image can't be there twice
+		for (const VkImageMemoryBarrier &barrier : vk_command_buffer->pending_barriers)
+		{
+			if (barrier.image != vk_texture->image)
+				continue;
 
-		std::vector<VkSemaphore> wait_semaphores;
-		std::vector<VkPipelineStageFlags> wait_stages;
+			helpers::flushBarriers(vk_command_buffer);
+			break;
+		}
 
-		if (num_wait_command_buffers != 0 && wait_command_buffers != nullptr)
+		VkImageAspectFlags aspect = Utils::getImageAspectFlags(vk_texture->format);
+
+		for (uint32_t layer = base_layer; layer < base_layer + num_layers; ++layer)
 		{
-			wait_semaphores.resize(num_wait_command_buffers);
-			wait_stages.resize(num_wait_command_buffers);
+			// adjacent mips coming from the same state share one barrier
+			bool merge = false;
 
-			for (uint32_t i = 0; i < num_wait_command_buffers; ++i)
+			for (uint32_t mip = base_mip; mip < base_mip + num_mips; ++mip)
 			{
-				const CommandBuffer *vk_wait_command_buffer = static_cast<const CommandBuffer *>(wait_command_buffers[i]);
-				wait_semaphores[i] = vk_wait_command_buffer->rendering_finished_gpu;
-				wait_stages[i] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-			}
+				TextureSubresourceState &current = vk_texture->states[layer * vk_texture->num_mipmaps + mip];
 
-			info.waitSemaphoreCount = num_wait_command_buffers;
-			info.pWaitSemaphores = wait_semaphores.data();
-			info.pWaitDstStageMask = wait_stages.data();
-		}
+				// nothing to wait for, the next transition waits for earlier accesses instead
+				if (state == TextureState::UNDEFINED)
+				{
+					current.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+					merge = false;
+					continue;
+				}
 
-		vkResetFences(device->getDevice(), 1, &vk_command_buffer->rendering_finished_cpu);
-		if (vkQueueSubmit(device->getGraphicsQueue(), 1, &info, vk_command_buffer->rendering_finished_cpu) != VK_SUCCESS)
-			return false;
+				// readers already covered by the last barrier don't need another one
+				bool read_only = (helpers::getWriteAccess(current.access | new_access) == 0);
+				bool same_layout_read = (current.layout == new_layout && read_only);
+				if (same_layout_read && (new_stages & ~current.stages) == 0 && (new_access & ~current.access) == 0)
+				{
+					merge = false;
+					continue;
+				}
 
-		return true;
-	}
+				VkAccessFlags src_access = helpers::getWriteAccess(current.access);
 
-	void Driver::beginRenderPass(backend::CommandBuffer *command_buffer, const backend::RenderPass *render_pass, const backend::FrameBuffer *frame_buffer)
-	{
-		assert(command_buffer);
-		assert(render_pass);
-		assert(frame_buffer);
+				if (merge)
+				{
+					VkImageMemoryBarrier &last = vk_command_buffer->pending_barriers.back();
+					merge = (last.oldLayout == current.layout) && (last.srcAccessMask == src_access);
+				}
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		const RenderPass *vk_render_pass = static_cast<const RenderPass *>(render_pass);
-		const FrameBuffer *vk_frame_buffer = static_cast<const FrameBuffer *>(frame_buffer);
+				if (merge)
+				{
+					vk_command_buffer->pending_barriers.back().subresourceRange.levelCount++;
+				}
+				else
+				{
+					VkImageMemoryBarrier barrier = {};
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.oldLayout = current.layout;
+					barrier.newLayout = new_layout;
+					barrier.srcAccessMask = src_access;
+					barrier.dstAccessMask = new_access;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = vk_texture->image;
+					barrier.subresourceRange.aspectMask = aspect;
+					barrier.subresourceRange.baseMipLevel = mip;
+					barrier.subresourceRange.levelCount = 1;
+					barrier.subresourceRange.baseArrayLayer = layer;
+					barrier.subresourceRange.layerCount = 1;
+
+					vk_command_buffer->pending_barriers.push_back(barrier);
+					merge = true;
+				}
 
-		// lazily create framebuffer
-		if (vk_frame_buffer->frame_buffer == VK_NULL_HANDLE)
-		{
-			VkFramebufferCreateInfo framebuffer_info = {};
-			framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebuffer_info.renderPass = vk_render_pass->render_pass;
-			framebuffer_info.attachmentCount = vk_frame_buffer->num_attachments;
-			framebuffer_info.pAttachments = vk_frame_buffer->attachment_views;
-			framebuffer_info.width = vk_frame_buffer->sizes.width;
-			framebuffer_info.height = vk_frame_buffer->sizes.height;
-			framebuffer_info.layers = 1;
+				vk_command_buffer->pending_src_stages |= (current.stages) ? current.stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+				vk_command_buffer->pending_dst_stages |= new_stages;
 
-			if (vkCreateFramebuffer(device->getDevice(), &framebuffer_info, nullptr, &vk_frame_buffer->frame_buffer) != VK_SUCCESS)
-			{
-				vk_frame_buffer->frame_buffer = VK_NULL_HANDLE;
-				// TODO: log error
-				return;
+				// the next writer waits for all readers since the last write
+				current.layout = new_layout;
+				current.access = (same_layout_read) ? current.access | new_access : new_access;
+				current.stages = (same_layout_read) ? current.stages | new_stages : new_stages;
 			}
 		}
+	}
 
-		VkViewport viewport = {};
-		viewport.width = static_cast<float>(vk_frame_buffer->sizes.width);
-		viewport.height = static_cast<float>(vk_frame_buffer->sizes.height);
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D render_area = {};
-		render_area.extent = vk_frame_buffer->sizes;
-		render_area.offset = {0, 0};
-
-		vk_command_buffer->render_pass = vk_render_pass->render_pass;
-		vk_command_buffer->max_samples = vk_render_pass->max_samples;
-		vk_command_buffer->num_color_attachments = vk_render_pass->num_color_attachments;
+	void Driver::flushBarriers(backend::CommandBuffer *command_buffer)
+	{
+		if (command_buffer == nullptr)
+			return;
 
-		VkRenderPassBeginInfo render_pass_info = {};
-		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_info.renderPass = vk_render_pass->render_pass;
-		render_pass_info.framebuffer = vk_frame_buffer->frame_buffer;
-		render_pass_info.renderArea = render_area;
-		render_pass_info.clearValueCount = vk_frame_buffer->num_attachments;
-		render_pass_info.pClearValues = vk_render_pass->attachment_clear_values;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		assert(vk_command_buffer->current_render_pass == nullptr && "Barriers are not allowed inside render passes");
 
-		vkCmdBeginRenderPass(vk_command_buffer->command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+		helpers::flushBarriers(vk_command_buffer);
 	}
 
-	void Driver::beginRenderPass(backend::CommandBuffer *command_buffer, const backend::RenderPass *render_pass, const backend::SwapChain *swap_chain)
+	/*
+	 */
+	void Driver::resetQueries(
+		backend::CommandBuffer *command_buffer,
+		backend::QueryPool *query_pool,
+		uint32_t first_query,
+		uint32_t num_queries
+	)
 	{
-		assert(command_buffer);
-		assert(render_pass);
-		assert(swap_chain);
+		if (command_buffer == nullptr || query_pool == nullptr)
+			return;
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		const RenderPass *vk_render_pass = static_cast<const RenderPass *>(render_pass);
-		const SwapChain *vk_swap_chain = static_cast<const SwapChain *>(swap_chain);
-		VkFramebuffer frame_buffer = vk_swap_chain->frame_buffers[vk_swap_chain->current_image];
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
 
-		VkViewport viewport = {};
-		viewport.width = static_cast<float>(vk_swap_chain->sizes.width);
-		viewport.height = static_cast<float>(vk_swap_chain->sizes.height);
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		assert(vk_command_buffer->render_pass == VK_NULL_HANDLE && "Queries can't be reset inside render passes");
+		assert(first_query + num_queries <= vk_query_pool->num_queries && "Queries are out of pool bounds");
 
-		VkRect2D render_area = {};
-		render_area.extent = vk_swap_chain->sizes;
-		render_area.offset = {0, 0};
+		vkCmdResetQueryPool(vk_command_buffer->command_buffer, vk_query_pool->pool, first_query, num_queries);
+	}
 
-		vk_command_buffer->render_pass = vk_render_pass->render_pass;
-		vk_command_buffer->max_samples = vk_render_pass->max_samples;
-		vk_command_buffer->num_color_attachments = vk_render_pass->num_color_attachments;
+	void Driver::beginTimestamp(
+		backend::CommandBuffer *command_buffer,
+		backend::QueryPool *query_pool,
+		uint32_t query
+	)
+	{
+		if (command_buffer == nullptr || query_pool == nullptr)
+			return;
 
-		VkRenderPassBeginInfo render_pass_info = {};
-		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_info.renderPass = vk_render_pass->render_pass;
-		render_pass_info.framebuffer = frame_buffer;
-		render_pass_info.renderArea = render_area;
-		render_pass_info.clearValueCount = vk_render_pass->num_attachments;
-		render_pass_info.pClearValues = vk_render_pass->attachment_clear_values;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
 
-		vkCmdBeginRenderPass(vk_command_buffer->command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+		assert(vk_query_pool->type == QueryType::TIMESTAMP && "Query pool must have QueryType::TIMESTAMP type");
+		assert(query < vk_query_pool->num_queries && "Query is out of pool bounds");
+
+		vkCmdWriteTimestamp(vk_command_buffer->command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_query_pool->pool, query);
 	}
 
-	void Driver::endRenderPass(backend::CommandBuffer *command_buffer)
+	void Driver::endTimestamp(
+		backend::CommandBuffer *command_buffer,
+		backend::QueryPool *query_pool,
+		uint32_t query
+	)
 	{
-		if (command_buffer == nullptr)
+		if (command_buffer == nullptr || query_pool == nullptr)
 			return;
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		vkCmdEndRenderPass(vk_command_buffer->command_buffer);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
 
-		vk_command_buffer->render_pass = VK_NULL_HANDLE;
+		assert(vk_query_pool->type == QueryType::TIMESTAMP && "Query pool must have QueryType::TIMESTAMP type");
+		assert(query < vk_query_pool->num_queries && "Query is out of pool bounds");
+
+		vkCmdWriteTimestamp(vk_command_buffer->command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_query_pool->pool, query);
 	}
 
-	void Driver::drawIndexedPrimitiveInstanced(
+	void Driver::beginQuery(
 		backend::CommandBuffer *command_buffer,
-		backend::PipelineState *pipeline_state,
-		const backend::IndexBuffer *index_buffer,
-		uint32_t num_indices,
-		uint32_t base_index,
-		int32_t base_vertex,
-		uint32_t num_instances,
-		uint32_t base_instance
+		backend::QueryPool *query_pool,
+		uint32_t query
 	)
 	{
-		ZoneScoped;
-
-		if (command_buffer == nullptr)
+		if (command_buffer == nullptr || query_pool == nullptr)
 			return;
 
-		CommandBuffer *vk_command_buffer = static_cast<CommandBuffer *>(command_buffer);
-		PipelineState *vk_pipeline_state = static_cast<PipelineState *>(pipeline_state);
-		const IndexBuffer *vk_index_buffer = static_cast<const IndexBuffer *>(index_buffer);
-
-		assert(vk_command_buffer->render_pass != VK_NULL_HANDLE);
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
 
-		vk_pipeline_state->render_pass = vk_command_buffer->render_pass;
-		vk_pipeline_state->num_color_attachments = vk_command_buffer->num_color_attachments;
-		vk_pipeline_state->max_samples = vk_command_buffer->max_samples;
+		assert(vk_query_pool->type != QueryType::TIMESTAMP && "Timestamps are written with beginTimestamp / endTimestamp");
+		assert(query < vk_query_pool->num_queries && "Query is out of pool bounds");
 
-		flush(pipeline_state);
+		vkCmdBeginQuery(vk_command_buffer->command_buffer, vk_query_pool->pool, query, 0);
+	}
 
-		ZoneNamedN(actual_draw_call, "Actual draw call", true);
+	void Driver::endQuery(
+		backend::CommandBuffer *command_buffer,
+		backend::QueryPool *query_pool,
+		uint32_t query
+	)
+	{
+		if (command_buffer == nullptr || query_pool == nullptr)
+			return;
 
-		VkPipeline pipeline = vk_pipeline_state->pipeline;
-		VkPipelineLayout pipeline_layout = vk_pipeline_state->pipeline_layout;
-		VkViewport viewport = vk_pipeline_state->viewport;
-		VkRect2D scissor = vk_pipeline_state->scissor;
+		CommandBuffer *vk_command_buffer = command_buffer_objects.get(command_buffer);
+		QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
 
-		vkCmdSetViewport(vk_command_buffer->command_buffer, 0, 1, &viewport);
-		vkCmdSetScissor(vk_command_buffer->command_buffer, 0, 1, &scissor);
+		assert(vk_query_pool->type != QueryType::TIMESTAMP && "Timestamps are written with beginTimestamp / endTimestamp");
+		assert(query < vk_query_pool->num_queries && "Query is out of pool bounds");
 
-		vkCmdBindPipeline(vk_command_buffer->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdEndQuery(vk_command_buffer->command_buffer, vk_query_pool->pool, query);
+	}
 
-		if (vk_pipeline_state->push_constants_size > 0)
-			vkCmdPushConstants(vk_command_buffer->command_buffer, pipeline_layout, VK_SHADER_STAGE_ALL, 0, vk_pipeline_state->push_constants_size, vk_pipeline_state->push_constants);
+	bool Driver::getQueryResults(
+		const backend::QueryPool *query_pool,
+		uint32_t first_query,
+		uint32_t num_queries,
+		void *results
+	)
+	{
+		if (query_pool == nullptr || num_queries == 0)
+			return false;
 
-		if (vk_pipeline_state->num_bind_sets > 0)
-		{
-			VkDescriptorSet sets[PipelineState::MAX_BIND_SETS];
-			for (uint32_t i = 0; i < vk_pipeline_state->num_bind_sets; ++i)
-				sets[i] = vk_pipeline_state->bind_sets[i]->set;
+		const QueryPool *vk_query_pool = query_pool_objects.get(query_pool);
+		assert(first_query + num_queries <= vk_query_pool->num_queries && "Queries are out of pool bounds");
+		assert(results != nullptr && "Invalid results");
 
-			vkCmdBindDescriptorSets(vk_command_buffer->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, vk_pipeline_state->num_bind_sets, sets, 0, nullptr);
-		}
+		VkDeviceSize stride = vk_query_pool->result_size;
+		size_t size = static_cast<size_t>(stride * num_queries);
 
-		if (vk_pipeline_state->num_vertex_streams > 0)
-		{
-			VkBuffer vertex_buffers[PipelineState::MAX_VERTEX_STREAMS];
-			VkDeviceSize offsets[PipelineState::MAX_VERTEX_STREAMS];
+		// no wait flag, unavailable results are reported instead of stalling
+		VkResult result = vkGetQueryPoolResults(
+			device->getDevice(),
+			vk_query_pool->pool,
+			first_query, num_queries,
+			size, results, stride,
+			VK_QUERY_RESULT_64_BIT
+		);
 
-			for (uint32_t i = 0; i < vk_pipeline_state->num_vertex_streams; ++i)
-			{
-				vertex_buffers[i] = vk_pipeline_state->vertex_streams[i]->buffer;
-				offsets[i] = 0;
-			}
+		if (result != VK_SUCCESS)
+			return false;
 
-			vkCmdBindVertexBuffers(vk_command_buffer->command_buffer, 0, vk_pipeline_state->num_vertex_streams, vertex_buffers, offsets);
+		if (vk_query_pool->type == QueryType::TIMESTAMP)
+		{
+			uint64_t *timestamps = reinterpret_cast<uint64_t *>(results);
+			for (uint32_t i = 0; i < num_queries; ++i)
+				timestamps[i] &= vk_query_pool->timestamp_mask;
 		}
 
-		if (vk_index_buffer)
-			vkCmdBindIndexBuffer(vk_command_buffer->command_buffer, vk_index_buffer->buffer, 0, vk_index_buffer->index_type);
+		return true;
+	}
 
-		vkCmdDrawIndexed(vk_command_buffer->command_buffer, num_indices, num_instances, base_index, base_vertex, base_instance);
+	float Driver::getTimestampPeriod()
+	{
+		return device->getTimestampPeriod();
 	}
 }
@@ -1,20 +1,36 @@
 #pragma once
 
 #include <render/backend/Driver.h>
+#include "render/backend/vulkan/ObjectPool.h"
 
 #include <volk.h>
 #include <vk_mem_alloc.h>
 
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 namespace render::backend::vulkan
 {
+	class BindlessTable;
 	class Device;
 	class Context;
+	class DescriptorAllocator;
 	class DescriptorSetCache;
 	class DescriptorSetLayoutCache;
+	class DestroyQueue;
+	class FrameBufferCache;
 	class ImageViewCache;
 	class PipelineLayoutCache;
 	class PipelineCache;
+	class ReadbackRing;
 	class RenderPassCache;
+	class SamplerCache;
+	class SubmitTracker;
+	class TransientAllocator;
+	class UploadContext;
+	struct TransientAllocation;
 
 	struct VertexBuffer : public render::backend::VertexBuffer
 	{
@@ -25,6 +41,7 @@ namespace render::backend::vulkan
 
 		BufferType type {BufferType::STATIC};
 		VkBuffer buffer {VK_NULL_HANDLE};
+		VkDeviceSize offset {0};
 		VmaAllocation memory {VK_NULL_HANDLE};
 		uint16_t vertex_size {0};
 		uint32_t num_vertices {0};
@@ -37,11 +54,19 @@ namespace render::backend::vulkan
 	{
 		BufferType type {BufferType::STATIC};
 		VkBuffer buffer {VK_NULL_HANDLE};
+		VkDeviceSize offset {0};
 		VmaAllocation memory {VK_NULL_HANDLE};
 		VkIndexType index_type {VK_INDEX_TYPE_UINT16};
 		uint32_t num_indices {0};
 	};
 
+	struct TextureSubresourceState
+	{
+		VkImageLayout layout {VK_IMAGE_LAYOUT_UNDEFINED};
+		VkAccessFlags access {0}; // all accesses since the last barrier
+		VkPipelineStageFlags stages {0};
+	};
+
 	struct Texture : public render::backend::Texture
 	{
 		VkImage image {VK_NULL_HANDLE};
@@ -57,7 +82,13 @@ namespace render::backend::vulkan
 		VkImageTiling tiling {VK_IMAGE_TILING_OPTIMAL};
 		VkSampleCountFlagBits samples {VK_SAMPLE_COUNT_1_BIT};
 		VkImageCreateFlags flags {0};
+		VkImageUsageFlags usage {0};
 		ImageViewCache *image_view_cache {nullptr};
+		SamplerDescription sampler_description;
+		uint32_t bindless_index {INVALID_BINDLESS_INDEX};
+
+		// last recorded state, indexed by layer * num_mipmaps + mip
+		mutable std::vector<TextureSubresourceState> states;
 	};
 
 	struct FrameBuffer : public render::backend::FrameBuffer
@@ -67,13 +98,20 @@ namespace render::backend::vulkan
 			MAX_ATTACHMENTS = 16,
 		};
 
-		mutable VkFramebuffer frame_buffer {VK_NULL_HANDLE};
 		VkExtent2D sizes {0, 0};
 
+		// framebuffers are owned by the framebuffer cache
 		uint32_t num_attachments {0};
+		const Texture *attachment_textures[MAX_ATTACHMENTS];
+		VkImage attachment_images[MAX_ATTACHMENTS];
 		VkImageView attachment_views[MAX_ATTACHMENTS];
 		VkFormat attachment_formats[MAX_ATTACHMENTS];
 		VkSampleCountFlagBits attachment_samples[MAX_ATTACHMENTS];
+
+		// subresources, their states are updated when the render pass ends
+		uint32_t attachment_base_mips[MAX_ATTACHMENTS];
+		uint32_t attachment_base_layers[MAX_ATTACHMENTS];
+		uint32_t attachment_num_layers[MAX_ATTACHMENTS];
 	};
 
 	struct RenderPass : public render::backend::RenderPass
@@ -81,9 +119,11 @@ namespace render::backend::vulkan
 		enum
 		{
 			MAX_ATTACHMENTS = 16,
+			MAX_SUBPASSES = 4,
 		};
 
 		VkRenderPass render_pass {VK_NULL_HANDLE};
+		uint64_t compatibility_hash {0};
 
 		uint32_t num_attachments {0};
 		VkFormat attachment_formats[MAX_ATTACHMENTS];
@@ -92,33 +132,87 @@ namespace render::backend::vulkan
 		VkAttachmentStoreOp attachment_store_ops[MAX_ATTACHMENTS];
 		VkClearValue attachment_clear_values[MAX_ATTACHMENTS];
 
-		VkSampleCountFlagBits max_samples {VK_SAMPLE_COUNT_1_BIT};
-		uint32_t num_color_attachments {0};
+		// per subpass
+		uint32_t num_subpasses {1};
+		VkSampleCountFlagBits max_samples[MAX_SUBPASSES];
+		uint32_t num_color_attachments[MAX_SUBPASSES];
 	};
 
 	static_assert(sizeof(VkClearValue) == sizeof(RenderPassClearValue));
 
 	struct CommandBuffer : public render::backend::CommandBuffer
 	{
+		enum
+		{
+			MAX_BIND_SETS = 16,
+			MAX_DYNAMIC_OFFSETS = 8,
+			MAX_VERTEX_STREAMS = 16,
+			MAX_PUSH_CONSTANT_SIZE = 128,
+		};
+
 		VkCommandBuffer command_buffer {VK_NULL_HANDLE};
+		VkCommandPool pool {VK_NULL_HANDLE};
 		VkCommandBufferLevel level {VK_COMMAND_BUFFER_LEVEL_PRIMARY};
 		VkSemaphore rendering_finished_gpu {VK_NULL_HANDLE};
 		VkFence rendering_finished_cpu {VK_NULL_HANDLE};
 
 		VkRenderPass render_pass {VK_NULL_HANDLE};
+		const RenderPass *current_render_pass {nullptr};
+		const FrameBuffer *current_frame_buffer {nullptr};
+		uint32_t subpass {0};
 		VkSampleCountFlagBits max_samples {VK_SAMPLE_COUNT_1_BIT};
 		uint32_t num_color_attachments {0};
+		bool secondary_contents {false};
+
+		// texture transitions, flushed as a single barrier
+		std::vector<VkImageMemoryBarrier> pending_barriers;
+		VkPipelineStageFlags pending_src_stages {0};
+		VkPipelineStageFlags pending_dst_stages {0};
+
+		// bound state, used to skip redundant commands while recording
+		bool viewport_bound {false};
+		bool scissor_bound {false};
+		VkViewport bound_viewport;
+		VkRect2D bound_scissor;
+
+		VkPipeline bound_pipeline {VK_NULL_HANDLE};
+		VkPipelineLayout bound_pipeline_layout {VK_NULL_HANDLE};
+
+		uint8_t bound_push_constants[MAX_PUSH_CONSTANT_SIZE];
+		uint8_t bound_push_constants_size {0};
+
+		VkDescriptorSet bound_sets[MAX_BIND_SETS];
+		uint32_t bound_dynamic_offsets[MAX_BIND_SETS][MAX_DYNAMIC_OFFSETS];
+		uint8_t num_bound_dynamic_offsets[MAX_BIND_SETS];
+		uint8_t num_bound_sets {0};
+
+		VkBuffer bound_vertex_buffers[MAX_VERTEX_STREAMS];
+		VkDeviceSize bound_vertex_offsets[MAX_VERTEX_STREAMS];
+		uint8_t num_bound_vertex_buffers {0};
+
+		VkBuffer bound_index_buffer {VK_NULL_HANDLE};
+		VkDeviceSize bound_index_offset {0};
+		VkIndexType bound_index_type {VK_INDEX_TYPE_UINT16};
 	};
 
 	struct UniformBuffer : public render::backend::UniformBuffer
 	{
 		BufferType type {BufferType::STATIC};
 		VkBuffer buffer {VK_NULL_HANDLE};
+		VkDeviceSize offset {0};
 		VmaAllocation memory {VK_NULL_HANDLE};
 		uint32_t size {0};
 		// TODO: static / dynamic fields
 	};
 
+	struct StorageBuffer : public render::backend::StorageBuffer
+	{
+		BufferType type {BufferType::STATIC};
+		VkBuffer buffer {VK_NULL_HANDLE};
+		VmaAllocation memory {VK_NULL_HANDLE};
+		uint32_t size {0};
+	};
+
 	struct Shader : public render::backend::Shader
 	{
 		ShaderType type {ShaderType::FRAGMENT};
@@ -130,6 +224,17 @@ namespace render::backend::vulkan
 		enum
 		{
 			MAX_BINDINGS = 32,
+			MAX_DYNAMIC_BINDINGS = 8,
+			MAX_VERSIONS = 4,
+			TRANSIENT_VERSION = MAX_VERSIONS,
+		};
+
+		// descriptor sets still used by GPU are never updated, flush switches to another version instead
+		struct Version
+		{
+			VkDescriptorSet set {VK_NULL_HANDLE};
+			VkDescriptorPool pool {VK_NULL_HANDLE};
+			uint64_t serial {0};
 		};
 
 		union Data
@@ -138,18 +243,33 @@ namespace render::backend::vulkan
 			{
 				VkImageView view;
 				VkSampler sampler;
+				VkImageLayout layout; // only used by input attachments
 			} texture;
 			struct UBO
 			{
+				const UniformBuffer *uniform_buffer;
 				VkBuffer buffer;
 				uint32_t offset;
 				uint32_t size;
 			} ubo;
+			struct SSBO
+			{
+				VkBuffer buffer;
+				uint32_t size;
+			} ssbo;
 		};
 
 		VkDescriptorSetLayout set_layout {VK_NULL_HANDLE};
 		VkDescriptorSet set {VK_NULL_HANDLE};
 
+		// owned by the driver, set and layout come from the bindless table
+		bool bindless {false};
+
+		Version versions[MAX_VERSIONS];
+		uint8_t num_versions {0};
+		uint8_t current_version {0};
+		uint64_t transient_serial {0};
+
 		VkDescriptorSetLayoutBinding bindings[MAX_BINDINGS];
 		Data binding_data[MAX_BINDINGS];
 		bool binding_used[MAX_BINDINGS];
@@ -188,15 +308,24 @@ namespace render::backend::vulkan
 		BindSet *bind_sets[MAX_BIND_SETS]; // TODO: made this safer
 		uint8_t num_bind_sets {0};
 
+		// added to the buffer offset of UNIFORM_BUFFER_DYNAMIC bindings, indexed by set and binding
+		uint32_t dynamic_offsets[MAX_BIND_SETS][BindSet::MAX_BINDINGS];
+
 		VertexBuffer *vertex_streams[MAX_VERTEX_STREAMS]; // TODO: made this safer
+		VkDeviceSize vertex_stream_offsets[MAX_VERTEX_STREAMS] {}; // added to the vertex buffer offset
 		uint8_t num_vertex_streams {0};
 
 		VkShaderModule shaders[MAX_SHADERS];
 
 		VkRenderPass render_pass {VK_NULL_HANDLE};
+		uint32_t subpass {0};
 		VkSampleCountFlagBits max_samples {VK_SAMPLE_COUNT_1_BIT};
 		uint8_t num_color_attachments {0};
 
+		// compilation
+		PipelineCompilePolicy compile_policy {PipelineCompilePolicy::BLOCK};
+		PipelineState *fallback {nullptr};
+
 		// internal mutable state
 		VkPipeline pipeline {VK_NULL_HANDLE};
 		VkPipelineLayout pipeline_layout {VK_NULL_HANDLE};
@@ -205,6 +334,11 @@ namespace render::backend::vulkan
 		// IDEA: get rid of pipeline layout cache, recreate layout if needed and be happy
 	};
 
+	static_assert(static_cast<uint32_t>(PipelineState::MAX_BIND_SETS) == static_cast<uint32_t>(CommandBuffer::MAX_BIND_SETS));
+	static_assert(static_cast<uint32_t>(BindSet::MAX_DYNAMIC_BINDINGS) == static_cast<uint32_t>(CommandBuffer::MAX_DYNAMIC_OFFSETS));
+	static_assert(static_cast<uint32_t>(PipelineState::MAX_VERTEX_STREAMS) == static_cast<uint32_t>(CommandBuffer::MAX_VERTEX_STREAMS));
+	static_assert(static_cast<uint32_t>(PipelineState::MAX_PUSH_CONSTANT_SIZE) == static_cast<uint32_t>(CommandBuffer::MAX_PUSH_CONSTANT_SIZE));
+
 	struct SwapChain : public render::backend::SwapChain
 	{
 		enum
@@ -227,6 +361,12 @@ namespace render::backend::vulkan
 		uint32_t current_image {0};
 		uint32_t current_frame {0};
 
+		// offscreen images are driver owned and left in transfer source layout for readback
+		bool offscreen {false};
+		bool readable {false}; // surfaces may not support transfer source usage
+		VkImageLayout present_layout {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+		VmaAllocation image_memory[MAX_IMAGES] {};
+
 		VkRenderPass dummy_render_pass {VK_NULL_HANDLE};
 
 		VkFramebuffer frame_buffers[MAX_IMAGES];
@@ -235,10 +375,24 @@ namespace render::backend::vulkan
 		VkImageView image_views[MAX_IMAGES];
 	};
 
+	struct Sampler : public render::backend::Sampler
+	{
+		VkSampler sampler {VK_NULL_HANDLE};
+	};
+
+	struct QueryPool : public render::backend::QueryPool
+	{
+		VkQueryPool pool {VK_NULL_HANDLE};
+		QueryType type {QueryType::TIMESTAMP};
+		uint32_t num_queries {0};
+		uint32_t result_size {0};
+		uint64_t timestamp_mask {0};
+	};
+
 	class Driver : public backend::Driver
 	{
 	public:
-		Driver(const char *application_name, const char *engine_name);
+		Driver(const char *application_name, const char *engine_name, bool headless = false);
 		virtual ~Driver();
 
 		inline const Device *getDevice() const { return device; }
@@ -266,7 +420,8 @@ namespace render::backend::vulkan
 			uint32_t num_mipmaps,
 			Format format,
 			const void *data = nullptr,
-			uint32_t num_data_mipmaps = 1
+			uint32_t num_data_mipmaps = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) final;
 
 		backend::Texture *createTexture2DMultisample(
@@ -284,7 +439,8 @@ namespace render::backend::vulkan
 			Format format,
 			const void *data = nullptr,
 			uint32_t num_data_mipmaps = 1,
-			uint32_t num_data_layers = 1
+			uint32_t num_data_layers = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) final;
 
 		backend::Texture *createTexture3D(
@@ -294,7 +450,8 @@ namespace render::backend::vulkan
 			uint32_t num_mipmaps,
 			Format format,
 			const void *data = nullptr,
-			uint32_t num_data_mipmaps = 1
+			uint32_t num_data_mipmaps = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) final;
 
 		backend::Texture *createTextureCube(
@@ -302,7 +459,8 @@ namespace render::backend::vulkan
 			uint32_t num_mipmaps,
 			Format format,
 			const void *data = nullptr,
-			uint32_t num_data_mipmaps = 1
+			uint32_t num_data_mipmaps = 1,
+			uint32_t usage_flags = TEXTURE_USAGE_NONE
 		) final;
 
 		backend::FrameBuffer *createFrameBuffer(
@@ -316,6 +474,13 @@ namespace render::backend::vulkan
 			const RenderPassDescription &description
 		) final;
 
+		backend::RenderPass *createRenderPass(
+			uint32_t num_attachments,
+			const RenderPassAttachment *attachments,
+			uint32_t num_subpasses,
+			const RenderPassDescription *subpasses
+		) final;
+
 		backend::RenderPass *createRenderPass(
 			const backend::SwapChain *swap_chain,
 			RenderPassLoadOp load_op,
@@ -333,6 +498,12 @@ namespace render::backend::vulkan
 			const void *data = nullptr
 		) final;
 
+		backend::StorageBuffer *createStorageBuffer(
+			BufferType type,
+			uint32_t size,
+			const void *data = nullptr
+		) final;
+
 		backend::Shader *createShaderFromSource(
 			ShaderType type,
 			uint32_t size,
@@ -357,6 +528,30 @@ namespace render::backend::vulkan
 			void *native_window
 		) final;
 
+		backend::SwapChain *createOffscreenSwapChain(
+			uint32_t width,
+			uint32_t height,
+			uint32_t num_images
+		) final;
+
+		backend::Sampler *createSampler(
+			const SamplerDescription &description
+		) final;
+
+		backend::QueryPool *createQueryPool(
+			QueryType type,
+			uint32_t num_queries
+		) final;
+
+		backend::GeometryArena *createGeometryArena(
+			uint16_t vertex_size,
+			uint8_t num_attributes,
+			const VertexAttribute *attributes,
+			IndexFormat index_format,
+			uint32_t num_vertices,
+			uint32_t num_indices
+		) final;
+
 		void destroyVertexBuffer(backend::VertexBuffer *vertex_buffer) final;
 		void destroyIndexBuffer(backend::IndexBuffer *index_buffer) final;
 		void destroyTexture(backend::Texture *texture) final;
@@ -364,10 +559,14 @@ namespace render::backend::vulkan
 		void destroyRenderPass(backend::RenderPass *render_pass) final;
 		void destroyCommandBuffer(backend::CommandBuffer *command_buffer) final;
 		void destroyUniformBuffer(backend::UniformBuffer *uniform_buffer) final;
+		void destroyStorageBuffer(backend::StorageBuffer *storage_buffer) final;
 		void destroyShader(backend::Shader *shader) final;
 		void destroyBindSet(backend::BindSet *bind_set) final;
 		void destroyPipelineState(backend::PipelineState *pipeline_state) final;
 		void destroySwapChain(backend::SwapChain *swap_chain) final;
+		void destroyQueryPool(backend::QueryPool *query_pool) final;
+		void destroySampler(backend::Sampler *sampler) final;
+		void destroyGeometryArena(backend::GeometryArena *arena) final;
 
 	public:
 		bool isFlipped() final { return false; }
@@ -379,6 +578,75 @@ namespace render::backend::vulkan
 		void setTextureSamplerDepthCompare(backend::Texture *texture, bool enabled, DepthCompareFunc func) final;
 		void generateTexture2DMipmaps(backend::Texture *texture) final;
 
+		void setPipelineCachePath(const char *path) final;
+		void setAsyncPipelineCompilation(bool enabled) final;
+		uint32_t getNumPendingPipelines() final;
+
+	public:
+		// uploads
+		void beginUploadBatch() final;
+		bool endUploadBatch() final;
+		uint64_t endUploadBatchAsync() final;
+		bool isUploadComplete(uint64_t ticket) final;
+		void releaseThreadResources() final;
+
+	public:
+		// readbacks
+		uint64_t readTexture(
+			backend::CommandBuffer *command_buffer,
+			const backend::Texture *texture,
+			uint32_t mip = 0,
+			uint32_t layer = 0
+		) final;
+
+		uint64_t readBuffer(
+			backend::CommandBuffer *command_buffer,
+			const backend::StorageBuffer *storage_buffer,
+			uint32_t offset = 0,
+			uint32_t size = 0
+		) final;
+
+		uint64_t readSwapChain(
+			backend::CommandBuffer *command_buffer,
+			const backend::SwapChain *swap_chain
+		) final;
+
+		bool isReadbackComplete(uint64_t ticket) final;
+		bool waitReadback(uint64_t ticket) final;
+		const void *getReadbackData(uint64_t ticket, size_t *size = nullptr) final;
+		void releaseReadback(uint64_t ticket) final;
+
+	public:
+		// bindless
+		bool isBindlessSupported() final;
+		uint32_t getBindlessIndex(const backend::Texture *texture) final;
+		backend::BindSet *getBindlessBindSet() final;
+
+	public:
+		// geometry arena
+		backend::GeometryAllocation *allocateGeometry(
+			backend::GeometryArena *arena,
+			uint32_t num_vertices,
+			const void *vertices,
+			uint32_t num_indices,
+			const void *indices
+		) final;
+
+		void freeGeometry(backend::GeometryArena *arena, backend::GeometryAllocation *allocation) final;
+		GeometryRange getGeometryRange(const backend::GeometryArena *arena, const backend::GeometryAllocation *allocation) final;
+		void compactGeometryArena(backend::GeometryArena *arena) final;
+
+	public:
+		// statistics
+		uint32_t getNumDescriptorPools() final;
+		DescriptorPoolStats getDescriptorPoolStats(uint32_t index) final;
+		void getMemoryStats(MemoryStats *stats) final;
+		bool defragmentMemory(backend::CommandBuffer *command_buffer, uint64_t max_bytes, uint32_t max_allocations, DefragmentationStats *stats = nullptr) final;
+
+	public:
+		// per-frame memory for backend code, valid until GPU finishes the frame it was allocated in
+		TransientAllocation allocateTransient(VkDeviceSize size, VkDeviceSize alignment);
+
 	public:
 		void *map(backend::VertexBuffer *vertex_buffer) final;
 		void unmap(backend::VertexBuffer *vertex_buffer) final;
@@ -389,6 +657,9 @@ namespace render::backend::vulkan
 		void *map(backend::UniformBuffer *uniform_buffer) final;
 		void unmap(backend::UniformBuffer *uniform_buffer) final;
 
+		void *map(backend::StorageBuffer *storage_buffer) final;
+		void unmap(backend::StorageBuffer *storage_buffer) final;
+
 		void flush(backend::BindSet *bind_set) final;
 		void flush(backend::PipelineState *pipeline_state) final;
 
@@ -418,10 +689,18 @@ namespace render::backend::vulkan
 			const backend::UniformBuffer *uniform_buffer
 		) final;
 
+		void bindDynamicUniformBuffer(
+			backend::BindSet *bind_set,
+			uint32_t binding,
+			const backend::UniformBuffer *uniform_buffer,
+			uint32_t range
+		) final;
+
 		void bindTexture(
 			backend::BindSet *bind_set,
 			uint32_t binding,
-			const backend::Texture *texture
+			const backend::Texture *texture,
+			const backend::Sampler *sampler
 		) final;
 
 		void bindTexture(
@@ -431,7 +710,27 @@ namespace render::backend::vulkan
 			uint32_t base_mip,
 			uint32_t num_mips,
 			uint32_t base_layer,
-			uint32_t num_layers
+			uint32_t num_layers,
+			const backend::Sampler *sampler
+		) final;
+
+		void bindStorageBuffer(
+			backend::BindSet *bind_set,
+			uint32_t binding,
+			const backend::StorageBuffer *storage_buffer
+		) final;
+
+		void bindStorageImage(
+			backend::BindSet *bind_set,
+			uint32_t binding,
+			const backend::Texture *texture,
+			uint32_t mip
+		) final;
+
+		void bindInputAttachment(
+			backend::BindSet *bind_set,
+			uint32_t binding,
+			const backend::Texture *texture
 		) final;
 
 	public:
@@ -456,6 +755,13 @@ namespace render::backend::vulkan
 			backend::BindSet *bind_set
 		) final;
 
+		void setDynamicOffset(
+			backend::PipelineState *pipeline_state,
+			uint8_t set,
+			uint32_t binding,
+			uint32_t offset
+		) final;
+
 		void clearShaders(
 			backend::PipelineState *pipeline_state
 		) final;
@@ -473,7 +779,8 @@ namespace render::backend::vulkan
 		void setVertexStream(
 			backend::PipelineState *pipeline_state,
 			uint8_t binding,
-			backend::VertexBuffer *vertex_buffer
+			backend::VertexBuffer *vertex_buffer,
+			uint32_t offset
 		) final;
 
 		void setViewport(
@@ -528,6 +835,16 @@ namespace render::backend::vulkan
 			BlendFactor dest_factor
 		) final;
 
+		void setCompilePolicy(
+			backend::PipelineState *pipeline_state,
+			PipelineCompilePolicy policy
+		) final;
+
+		void setFallbackPipelineState(
+			backend::PipelineState *pipeline_state,
+			backend::PipelineState *fallback
+		) final;
+
 	public:
 		// command buffers
 		bool resetCommandBuffer(
@@ -538,6 +855,12 @@ namespace render::backend::vulkan
 			backend::CommandBuffer *command_buffer
 		) final;
 
+		bool beginCommandBuffer(
+			backend::CommandBuffer *command_buffer,
+			const backend::RenderPass *render_pass,
+			const backend::FrameBuffer *frame_buffer
+		) final;
+
 		bool endCommandBuffer(
 			backend::CommandBuffer *command_buffer
 		) final;
@@ -562,19 +885,32 @@ namespace render::backend::vulkan
 		void beginRenderPass(
 			backend::CommandBuffer *command_buffer,
 			const backend::RenderPass *render_pass,
-			const backend::FrameBuffer *frame_buffer
+			const backend::FrameBuffer *frame_buffer,
+			RenderPassContents contents
 		) final;
 
 		void beginRenderPass(
 			backend::CommandBuffer *command_buffer,
 			const backend::RenderPass *render_pass,
-			const backend::SwapChain *swap_chain
+			const backend::SwapChain *swap_chain,
+			RenderPassContents contents
+		) final;
+
+		void nextSubpass(
+			backend::CommandBuffer *command_buffer,
+			RenderPassContents contents
 		) final;
 
 		void endRenderPass(
 			backend::CommandBuffer *command_buffer
 		) final;
 
+		void executeCommands(
+			backend::CommandBuffer *command_buffer,
+			uint32_t num_command_buffers,
+			backend::CommandBuffer * const *command_buffers
+		) final;
+
 		void drawIndexedPrimitiveInstanced(
 			backend::CommandBuffer *command_buffer,
 			backend::PipelineState *pipeline_state,
@@ -586,10 +922,164 @@ namespace render::backend::vulkan
 			uint32_t base_instance
 		) final;
 
+		void drawIndexedIndirect(
+			backend::CommandBuffer *command_buffer,
+			backend::PipelineState *pipeline_state,
+			const backend::IndexBuffer *index_buffer,
+			const backend::StorageBuffer *arguments,
+			uint32_t offset,
+			uint32_t num_draws,
+			uint32_t stride
+		) final;
+
+		void drawIndexedIndirectCount(
+			backend::CommandBuffer *command_buffer,
+			backend::PipelineState *pipeline_state,
+			const backend::IndexBuffer *index_buffer,
+			const backend::StorageBuffer *arguments,
+			uint32_t offset,
+			const backend::StorageBuffer *count_buffer,
+			uint32_t count_offset,
+			uint32_t max_draws,
+			uint32_t stride
+		) final;
+
+	public:
+		// compute commands
+		void dispatch(
+			backend::CommandBuffer *command_buffer,
+			backend::PipelineState *pipeline_state,
+			uint32_t num_groups_x,
+			uint32_t num_groups_y,
+			uint32_t num_groups_z
+		) final;
+
+		void dispatchIndirect(
+			backend::CommandBuffer *command_buffer,
+			backend::PipelineState *pipeline_state,
+			const backend::StorageBuffer *arguments,
+			uint32_t offset
+		) final;
+
+		void memoryBarrier(
+			backend::CommandBuffer *command_buffer,
+			BarrierType type
+		) final;
+
+		void textureBarrier(
+			backend::CommandBuffer *command_buffer,
+			const backend::Texture *texture,
+			BarrierType type
+		) final;
+
+	public:
+		void transitionTexture(
+			backend::CommandBuffer *command_buffer,
+			const backend::Texture *texture,
+			TextureState state,
+			uint32_t base_mip,
+			uint32_t num_mips,
+			uint32_t base_layer,
+			uint32_t num_layers
+		) final;
+
+		void flushBarriers(
+			backend::CommandBuffer *command_buffer
+		) final;
+
+	public:
+		// queries
+		void resetQueries(
+			backend::CommandBuffer *command_buffer,
+			backend::QueryPool *query_pool,
+			uint32_t first_query,
+			uint32_t num_queries
+		) final;
+
+		void beginTimestamp(
+			backend::CommandBuffer *command_buffer,
+			backend::QueryPool *query_pool,
+			uint32_t query
+		) final;
+
+		void endTimestamp(
+			backend::CommandBuffer *command_buffer,
+			backend::QueryPool *query_pool,
+			uint32_t query
+		) final;
+
+		void beginQuery(
+			backend::CommandBuffer *command_buffer,
+			backend::QueryPool *query_pool,
+			uint32_t query
+		) final;
+
+		void endQuery(
+			backend::CommandBuffer *command_buffer,
+			backend::QueryPool *query_pool,
+			uint32_t query
+		) final;
+
+		bool getQueryResults(
+			const backend::QueryPool *query_pool,
+			uint32_t first_query,
+			uint32_t num_queries,
+			void *results
+		) final;
+
+		float getTimestampPeriod() final;
+
+	private:
+		UploadContext *getUploadContext();
+		void flushBindSet(BindSet *bind_set);
+		void flushPipelineState(PipelineState *pipeline_state);
+		VkCommandPool getCommandPool();
+		bool bindGraphicsState(CommandBuffer *command_buffer, PipelineState *pipeline_state, const IndexBuffer *index_buffer);
+		bool bindComputeState(CommandBuffer *command_buffer, PipelineState *pipeline_state);
+
 	private:
 		Device *device {nullptr};
+		DescriptorAllocator *descriptor_allocator {nullptr};
 		DescriptorSetLayoutCache *descriptor_set_layout_cache {nullptr};
 		PipelineLayoutCache *pipeline_layout_cache {nullptr};
 		PipelineCache *pipeline_cache {nullptr};
+		SamplerCache *sampler_cache {nullptr};
+		SubmitTracker *submit_tracker {nullptr};
+		DestroyQueue *destroy_queue {nullptr};
+		FrameBufferCache *frame_buffer_cache {nullptr};
+		TransientAllocator *transient_allocator {nullptr};
+		ReadbackRing *readback_ring {nullptr};
+		BindlessTable *bindless_table {nullptr};
+		BindSet *bindless_bind_set {nullptr};
+
+		// one defragmentation is in flight at a time, VMA reports freed blocks into the stats when it ends
+		VmaDefragmentationStats defragmentation_stats {};
+		uint64_t defragmentation_serial {0};
+
+		// driver objects are kept in slabs, pointers handed out to the user point into them
+		ObjectPool<VertexBuffer> vertex_buffer_objects;
+		ObjectPool<IndexBuffer> index_buffer_objects;
+		ObjectPool<Texture> texture_objects;
+		ObjectPool<FrameBuffer> frame_buffer_objects;
+		ObjectPool<RenderPass> render_pass_objects;
+		ObjectPool<CommandBuffer> command_buffer_objects;
+		ObjectPool<UniformBuffer> uniform_buffer_objects;
+		ObjectPool<StorageBuffer> storage_buffer_objects;
+		ObjectPool<Shader> shader_objects;
+		ObjectPool<BindSet> bind_set_objects;
+		ObjectPool<PipelineState> pipeline_state_objects;
+		ObjectPool<QueryPool> query_pool_objects;
+		ObjectPool<Sampler> sampler_objects;
+
+		// resources may be created from loader threads, each thread records into its own context
+		std::unordered_map<std::thread::id, UploadContext *> upload_contexts;
+		std::mutex upload_contexts_mutex;
+
+		// command pools can't be used from several threads at once, each recording thread gets its own
+		std::unordered_map<std::thread::id, VkCommandPool> command_pools;
+		std::mutex command_pools_mutex;
+
+		// flushes touch shared caches and allocators, recording threads take turns
+		std::mutex flush_mutex;
 	};
 }
@@ -10,7 +10,8 @@ namespace render::backend::vulkan
 		#if defined(SCAPES_PLATFORM_WIN32)
 			return "VK_KHR_win32_surface";
 		#else
-			#error "Platform::getInstanceExtension(): not supported on this platform"
+			// no surface support, only headless drivers can be created
+			return nullptr;
 		#endif
 	}
 